@@ -0,0 +1,311 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "animation.h"
+#include "render.h"
+#include "log.h"
+#include "mempool.h"
+#include "mboxstats.h"
+#include "trace.h"
+#include "global.h"
+#include <string.h>
+#include <stdint.h>
+
+typedef struct animation
+{
+  struct animation *next;
+  int animationId;
+  ui_element *element;
+  AnimProperty property;
+  long from;
+  long to;
+  long startMicros; // 0 until the animation's first frame
+  long durationMicros;
+  EasingFunction easing;
+  AnimationCallback callback;
+  void *callbackData;
+} animation;
+
+static slab_pool animationPool = SLAB_POOL_INITIALIZER("animation",animation,16);
+
+// running animations, only accessed from the rendering thread
+static animation *animations = NULL;
+
+static int nextAnimationId = 1;
+
+double animation_ease(EasingFunction easing,double t)
+{
+  switch( easing )
+  {
+    case EASE_IN_QUAD:
+      return t*t;
+    case EASE_OUT_QUAD:
+      return t*(2-t);
+    case EASE_IN_OUT_QUAD:
+      return t < 0.5 ? 2*t*t : -1 + (4-2*t)*t;
+    case EASE_OUT_CUBIC:
+      t -= 1;
+      return t*t*t + 1;
+    case EASE_IN_OUT_CUBIC:
+      if ( t < 0.5 ) {
+        return 4*t*t*t;
+      }
+      t = 2*t - 2;
+      return t*t*t/2 + 1;
+    default:
+      return t;
+  }
+}
+
+static long animation_get_value(ui_element *element,AnimProperty property)
+{
+  switch( property )
+  {
+    case ANIM_PROPERTY_X:
+      return element->bounds.x;
+    case ANIM_PROPERTY_Y:
+      return element->bounds.y;
+    case ANIM_PROPERTY_BACKGROUND_COLOR:
+      return (element->backgroundColor.r << 16) | (element->backgroundColor.g << 8) | element->backgroundColor.b;
+    case ANIM_PROPERTY_SCROLL_OFFSET:
+      return element->listview->yStartOffset;
+  }
+  return 0;
+}
+
+/**
+ * Updates a property and invalidates the regions affected by the change.
+ */
+static void animation_set_value(ui_element *element,AnimProperty property,long value)
+{
+  switch( property )
+  {
+    case ANIM_PROPERTY_X:
+      render_invalidate(element); // region the element is moving away from
+      element->bounds.x = value;
+      break;
+    case ANIM_PROPERTY_Y:
+      render_invalidate(element);
+      element->bounds.y = value;
+      break;
+    case ANIM_PROPERTY_BACKGROUND_COLOR:
+      element->backgroundColor.r = (value >> 16) & 0xff;
+      element->backgroundColor.g = (value >> 8) & 0xff;
+      element->backgroundColor.b = value & 0xff;
+      break;
+    case ANIM_PROPERTY_SCROLL_OFFSET:
+      element->listview->yStartOffset = value;
+      break;
+  }
+  render_invalidate(element);
+}
+
+static long animation_round(double value)
+{
+  return value < 0 ? (long) (value - 0.5) : (long) (value + 0.5);
+}
+
+static long animation_interpolate(AnimProperty property,long from,long to,double progress)
+{
+  if ( property != ANIM_PROPERTY_BACKGROUND_COLOR ) {
+    return from + animation_round( (to - from) * progress );
+  }
+  // interpolate each color channel separately
+  long result = 0;
+  for ( int shift = 16 ; shift >= 0 ; shift -= 8 )
+  {
+    long a = (from >> shift) & 0xff;
+    long b = (to >> shift) & 0xff;
+    long channel = a + animation_round( (b - a) * progress );
+    result |= (channel < 0 ? 0 : channel > 0xff ? 0xff : channel) << shift;
+  }
+  return result;
+}
+
+/**
+ * Unlinks the first animation matching either an ID or an element and property.
+ * @return unlinked animation or NULL
+ */
+static animation *animation_unlink(int animationId,ui_element *element,AnimProperty property)
+{
+  for ( animation **current = &animations ; *current ; current = &(*current)->next )
+  {
+    animation *anim = *current;
+    if ( anim->animationId == animationId || ( anim->element == element && anim->property == property ) )
+    {
+      *current = anim->next;
+      return anim;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Returns the largest scroll offset of a list view, the same limit scrolling by touch has.
+ */
+static long animation_get_max_scroll_offset(ui_element *element)
+{
+  int items = render_listview_get_item_count(element);
+  int visible = element->listview->visibleItemCount;
+  return items <= visible ? 0 : (long) (items - visible) * LISTVIEW_ITEM_HEIGHT;
+}
+
+typedef struct animation_start_args {
+  ui_element *element;
+  AnimProperty property;
+  long to;
+  long durationMicros;
+  EasingFunction easing;
+  AnimationCallback callback;
+  void *callbackData;
+} animation_start_args;
+
+static void *animation_start_internal(void *data)
+{
+  animation_start_args *args = data;
+  ui_element *element = args->element;
+  if ( element->parent == NULL ) {
+    log_error("animation_start(): Element %d is not attached",element->elementId);
+    return NULL;
+  }
+  if ( args->property < ANIM_PROPERTY_X || args->property > ANIM_PROPERTY_SCROLL_OFFSET ) {
+    log_error("animation_start(): Unknown property %d",args->property);
+    return NULL;
+  }
+  if ( args->property == ANIM_PROPERTY_SCROLL_OFFSET && element->type != UI_LISTVIEW ) {
+    log_error("animation_start(): Element %d is not a list view",element->elementId);
+    return NULL;
+  }
+  long to = args->to;
+  if ( args->property == ANIM_PROPERTY_SCROLL_OFFSET ) {
+    // offsets outside the list would make the list view ask for items that don't exist
+    to = max( min(to,animation_get_max_scroll_offset(element)), 0 );
+  }
+
+  animation *anim = animation_unlink(0,element,args->property);
+  if ( anim ) {
+    memset(anim,0,sizeof(animation));
+  } else {
+    anim = slab_alloc(&animationPool);
+    if ( anim == NULL ) {
+      log_error("animation_start(): Failed to allocate animation");
+      return NULL;
+    }
+  }
+  anim->animationId = nextAnimationId++;
+  anim->element = element;
+  anim->property = args->property;
+  anim->from = animation_get_value(element,args->property);
+  anim->to = to;
+  anim->durationMicros = args->durationMicros;
+  anim->easing = args->easing;
+  anim->callback = args->callback;
+  anim->callbackData = args->callbackData;
+
+  anim->next = animations;
+  animations = anim;
+  return (void*) (intptr_t) anim->animationId;
+}
+
+int animation_start(ui_element *element,AnimProperty property,long to,long durationMicros,
+                    EasingFunction easing,AnimationCallback callback,void *callbackData)
+{
+  animation_start_args args = { element, property, to, durationMicros, easing, callback, callbackData };
+  return (int) (intptr_t) render_exec_on_thread(animation_start_internal,&args,1);
+}
+
+static void *animation_cancel_internal(void *animationId)
+{
+  animation *anim = animation_unlink((int) (intptr_t) animationId,NULL,-1);
+  if ( anim == NULL ) {
+    return NULL;
+  }
+  slab_free(&animationPool,anim);
+  return (void*) (intptr_t) 1;
+}
+
+int animation_cancel(int animationId)
+{
+  if ( animationId <= 0 ) {
+    return 0;
+  }
+  return (int) (intptr_t) render_exec_on_thread(animation_cancel_internal,(void*) (intptr_t) animationId,1);
+}
+
+void animation_cancel_element(ui_element *element)
+{
+  animation **current = &animations;
+  while ( *current )
+  {
+    animation *anim = *current;
+    if ( anim->element == element ) {
+      *current = anim->next;
+      slab_free(&animationPool,anim);
+    } else {
+      current = &anim->next;
+    }
+  }
+}
+
+int animation_tick(long nowMicros)
+{
+  if ( animations == NULL ) {
+    return 0;
+  }
+  long traceStart = trace_begin();
+
+  // callbacks are invoked after all animations have been advanced
+  // as they may start or cancel animations
+  animation *completed = NULL;
+  int running = 0;
+
+  animation **current = &animations;
+  while ( *current )
+  {
+    animation *anim = *current;
+    if ( anim->startMicros == 0 ) {
+      anim->startMicros = nowMicros;
+    }
+    long elapsed = nowMicros - anim->startMicros;
+    double progress = 1.0;
+    if ( elapsed < anim->durationMicros ) {
+      progress = animation_ease(anim->easing,(double) elapsed / anim->durationMicros);
+    }
+    long value = animation_interpolate(anim->property,anim->from,anim->to,progress);
+    if ( value != animation_get_value(anim->element,anim->property) ) {
+      animation_set_value(anim->element,anim->property,value);
+    }
+
+    if ( elapsed >= anim->durationMicros )
+    {
+      *current = anim->next;
+      anim->next = completed;
+      completed = anim;
+    } else {
+      current = &anim->next;
+      running++;
+    }
+  }
+
+  while ( completed )
+  {
+    animation *anim = completed;
+    completed = anim->next;
+    if ( anim->callback ) {
+      anim->callback(anim->animationId,anim->callbackData);
+    }
+    slab_free(&animationPool,anim);
+  }
+  trace_end("frame","animate",traceStart,running);
+  return running;
+}
+
+int animation_is_active(void)
+{
+  return animations != NULL;
+}
+
+void animation_init(void)
+{
+  mboxstats_set_name(animation_start_internal,"animation_start");
+  mboxstats_set_name(animation_cancel_internal,"animation_cancel");
+}
@@ -0,0 +1,98 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include "ui_types.h"
+
+/*
+ * Tweens properties of UI elements that are part of the scene graph.
+ *
+ * Animations are advanced once per frame by the rendering thread using the
+ * frame's timestamp, so all animations running during a frame see the same
+ * point in time. Each step only invalidates the regions of the animated elements.
+ *
+ * Animations are only accessed from the rendering thread, all functions
+ * that may be called from other threads are marked as such.
+ */
+
+typedef enum {
+  ANIM_PROPERTY_X=0, // x coordinate relative to the parent
+  ANIM_PROPERTY_Y=1, // y coordinate relative to the parent
+  ANIM_PROPERTY_BACKGROUND_COLOR=2, // background color packed as 0xRRGGBB
+  ANIM_PROPERTY_SCROLL_OFFSET=3 // scroll offset of a list view in pixels
+} AnimProperty;
+
+typedef enum {
+  EASE_LINEAR=0,
+  EASE_IN_QUAD=1,
+  EASE_OUT_QUAD=2,
+  EASE_IN_OUT_QUAD=3,
+  EASE_OUT_CUBIC=4,
+  EASE_IN_OUT_CUBIC=5
+} EasingFunction;
+
+// invoked on the rendering thread after the final value of an animation has been applied
+// void callback(animation ID,callback data)
+typedef void (*AnimationCallback)(int,void*);
+
+/**
+ * Registers the names of the mailbox callbacks of this module.
+ */
+void animation_init(void);
+
+/**
+ * Animates a property from its current value to a target value.
+ * An animation of the same property of the same element that is already running
+ * gets replaced (without invoking its callback).
+ *
+ * May be called from any thread.
+ *
+ * @param element element, must be attached to the scene graph
+ * @param property property to animate, ANIM_PROPERTY_SCROLL_OFFSET requires a list view
+ * @param to target value, scroll offsets are clamped to the items of the list view
+ * @param durationMicros duration, the animation starts with the next frame
+ * @param easing easing function
+ * @param callback callback to invoke when the animation completed or NULL
+ * @param callbackData data passed to the callback
+ * @return 0 on error, otherwise the animation's ID (always >0)
+ */
+int animation_start(ui_element *element,AnimProperty property,long to,long durationMicros,
+                    EasingFunction easing,AnimationCallback callback,void *callbackData);
+
+/**
+ * Stops an animation, the property keeps its current value.
+ * May be called from any thread.
+ *
+ * @param animationId animation ID
+ * @return 0 if there is no such animation (any more), otherwise success
+ */
+int animation_cancel(int animationId);
+
+/**
+ * Stops all animations of an element.
+ * @param element
+ */
+void animation_cancel_element(ui_element *element);
+
+/**
+ * Applies the values all animations have at the given time and
+ * removes completed animations.
+ *
+ * @param nowMicros timestamp of the current frame (see profiler_now_micros())
+ * @return number of animations still running
+ */
+int animation_tick(long nowMicros);
+
+/**
+ * Returns whether any animations are running.
+ */
+int animation_is_active(void);
+
+/**
+ * Maps linear progress to eased progress.
+ * @param easing
+ * @param progress value between 0 and 1
+ * @return eased value, 0 for progress 0 and 1 for progress 1
+ */
+double animation_ease(EasingFunction easing,double progress);
+
+#endif
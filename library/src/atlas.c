@@ -0,0 +1,180 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "atlas.h"
+#include "log.h"
+#include "memstats.h"
+#include <string.h>
+
+int atlas_init(texture_atlas *atlas,SDL_PixelFormat *format)
+{
+  memset(atlas,0,sizeof(texture_atlas));
+  atlas->surface = SDL_CreateRGBSurface(SDL_SWSURFACE,ATLAS_WIDTH,ATLAS_HEIGHT,format->BitsPerPixel,
+                                        format->Rmask,format->Gmask,format->Bmask,format->Amask);
+  if ( atlas->surface == NULL ) {
+    log_error("atlas_init(): Failed to create %dx%d surface: %s",ATLAS_WIDTH,ATLAS_HEIGHT,SDL_GetError());
+    return 0;
+  }
+  memstats_add(MEM_CATEGORY_IMAGES,memstats_surface_size(atlas->surface));
+  return 1;
+}
+
+static int atlas_has_span(atlas_shelf *shelf,int width)
+{
+  for ( int i = 0 ; i < shelf->spanCount ; i++ ) {
+    if ( shelf->freeSpans[i].w >= width ) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Allocates space on a shelf.
+ * @return 0 if there is no free span wide enough
+ */
+static int atlas_alloc_on_shelf(atlas_shelf *shelf,int width,SDL_Rect *result)
+{
+  for ( int i = 0 ; i < shelf->spanCount ; i++ )
+  {
+    atlas_span *span = &shelf->freeSpans[i];
+    if ( span->w < width ) {
+      continue;
+    }
+    result->x = span->x;
+    result->y = shelf->y;
+    span->x += width;
+    span->w -= width;
+    if ( span->w == 0 )
+    {
+      memmove(span,span+1,(shelf->spanCount - i - 1) * sizeof(atlas_span));
+      shelf->spanCount--;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+static int atlas_alloc(texture_atlas *atlas,int width,int height,SDL_Rect *result)
+{
+  result->w = width;
+  result->h = height;
+
+  // best fitting shelf that does not waste too much height
+  atlas_shelf *best = NULL;
+  for ( int i = 0 ; i < atlas->shelfCount ; i++ )
+  {
+    atlas_shelf *shelf = &atlas->shelves[i];
+    if ( shelf->height >= height && shelf->height <= height + height/2
+         && ( best == NULL || shelf->height < best->height ) && atlas_has_span(shelf,width) )
+    {
+      best = shelf;
+    }
+  }
+  if ( best ) {
+    return atlas_alloc_on_shelf(best,width,result);
+  }
+
+  // open a new shelf
+  if ( atlas->shelfCount == ATLAS_MAX_SHELVES || atlas->usedHeight + height > ATLAS_HEIGHT ) {
+    return 0;
+  }
+  atlas_shelf *shelf = &atlas->shelves[atlas->shelfCount++];
+  shelf->y = atlas->usedHeight;
+  shelf->height = height;
+  shelf->spanCount = 1;
+  shelf->freeSpans[0].x = 0;
+  shelf->freeSpans[0].w = ATLAS_WIDTH;
+  atlas->usedHeight += height;
+  return atlas_alloc_on_shelf(shelf,width,result);
+}
+
+int atlas_add(texture_atlas *atlas,SDL_Surface *image,SDL_Rect *result)
+{
+  if ( atlas->surface == NULL || image->w > ATLAS_MAX_IMAGE_SIZE || image->h > ATLAS_MAX_IMAGE_SIZE ) {
+    return 0;
+  }
+  if ( ! atlas_alloc(atlas,image->w,image->h,result) ) {
+    return 0;
+  }
+  // copy the alpha channel instead of blending onto the atlas
+  Uint32 alphaFlags = image->flags & (SDL_SRCALPHA|SDL_RLEACCEL);
+  Uint8 alpha = image->format->alpha;
+  SDL_SetAlpha(image,0,SDL_ALPHA_OPAQUE);
+  SDL_Rect target = *result;
+  int copied = SDL_BlitSurface(image,NULL,atlas->surface,&target) == 0;
+  SDL_SetAlpha(image,alphaFlags,alpha);
+  if ( ! copied )
+  {
+    log_error("atlas_add(): Failed to copy image: %s",SDL_GetError());
+    atlas_remove(atlas,result);
+    return 0;
+  }
+  return 1;
+}
+
+void atlas_remove(texture_atlas *atlas,SDL_Rect *rect)
+{
+  atlas_shelf *shelf = NULL;
+  for ( int i = 0 ; i < atlas->shelfCount && shelf == NULL ; i++ ) {
+    if ( atlas->shelves[i].y == rect->y ) {
+      shelf = &atlas->shelves[i];
+    }
+  }
+  if ( shelf == NULL ) {
+    log_error("atlas_remove(): No shelf at y=%d",rect->y);
+    return;
+  }
+
+  int index = 0;
+  while ( index < shelf->spanCount && shelf->freeSpans[index].x < rect->x ) {
+    index++;
+  }
+  atlas_span *previous = index > 0 ? &shelf->freeSpans[index-1] : NULL;
+  atlas_span *next = index < shelf->spanCount ? &shelf->freeSpans[index] : NULL;
+  int mergePrevious = previous && previous->x + previous->w == rect->x;
+  int mergeNext = next && rect->x + rect->w == next->x;
+
+  if ( mergePrevious && mergeNext )
+  {
+    previous->w += rect->w + next->w;
+    memmove(next,next+1,(shelf->spanCount - index - 1) * sizeof(atlas_span));
+    shelf->spanCount--;
+  }
+  else if ( mergePrevious ) {
+    previous->w += rect->w;
+  }
+  else if ( mergeNext ) {
+    next->x = rect->x;
+    next->w += rect->w;
+  }
+  else if ( shelf->spanCount < ATLAS_MAX_SPANS )
+  {
+    memmove(&shelf->freeSpans[index+1],&shelf->freeSpans[index],(shelf->spanCount - index) * sizeof(atlas_span));
+    shelf->freeSpans[index].x = rect->x;
+    shelf->freeSpans[index].w = rect->w;
+    shelf->spanCount++;
+  } else {
+    log_debug("atlas_remove(): Too many free spans on shelf at y=%d, %d pixels are lost",shelf->y,rect->w);
+  }
+
+  // an empty topmost shelf can be reused for images of any height
+  while ( atlas->shelfCount > 0 )
+  {
+    atlas_shelf *last = &atlas->shelves[atlas->shelfCount-1];
+    if ( last->spanCount != 1 || last->freeSpans[0].w != ATLAS_WIDTH ) {
+      break;
+    }
+    atlas->usedHeight -= last->height;
+    atlas->shelfCount--;
+  }
+}
+
+void atlas_destroy(texture_atlas *atlas)
+{
+  if ( atlas->surface )
+  {
+    memstats_remove(MEM_CATEGORY_IMAGES,memstats_surface_size(atlas->surface));
+    SDL_FreeSurface(atlas->surface);
+  }
+  memset(atlas,0,sizeof(texture_atlas));
+}
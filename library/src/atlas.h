@@ -0,0 +1,80 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Packs small images (icons) into a single surface.
+ *
+ * Space is allocated in shelves: each shelf is a horizontal strip whose height
+ * is fixed by the first image placed on it, images are placed next to each
+ * other on the best fitting shelf. Freed space can be reused by images that fit
+ * onto the same shelf.
+ *
+ * Atlases are only accessed from the rendering thread.
+ */
+
+#define ATLAS_WIDTH 512
+#define ATLAS_HEIGHT 256
+
+// images larger than this (in either dimension) don't go into the atlas
+#define ATLAS_MAX_IMAGE_SIZE 64
+
+#define ATLAS_MAX_SHELVES 32
+
+// max. number of disjoint free spans per shelf
+#define ATLAS_MAX_SPANS 16
+
+typedef struct atlas_span
+{
+  int x;
+  int w;
+} atlas_span;
+
+typedef struct atlas_shelf
+{
+  int y;
+  int height;
+  int spanCount;
+  atlas_span freeSpans[ATLAS_MAX_SPANS]; // sorted by x
+} atlas_shelf;
+
+typedef struct texture_atlas
+{
+  SDL_Surface *surface; // NULL until atlas_init() succeeded
+  int usedHeight; // height occupied by shelves
+  int shelfCount;
+  atlas_shelf shelves[ATLAS_MAX_SHELVES];
+} texture_atlas;
+
+/**
+ * Allocates the atlas surface.
+ * @param atlas
+ * @param format pixel format of the atlas
+ * @return 0 on error, otherwise success
+ */
+int atlas_init(texture_atlas *atlas,SDL_PixelFormat *format);
+
+/**
+ * Copies an image into the atlas.
+ * @param atlas
+ * @param image image to copy, must have the atlas' pixel format
+ * @param result area of the atlas the image was copied to
+ * @return 0 if the image is too large or the atlas is full, otherwise success
+ */
+int atlas_add(texture_atlas *atlas,SDL_Surface *image,SDL_Rect *result);
+
+/**
+ * Releases an area of the atlas.
+ * @param atlas
+ * @param rect area returned by atlas_add()
+ */
+void atlas_remove(texture_atlas *atlas,SDL_Rect *rect);
+
+/**
+ * Frees the atlas surface, all areas become invalid.
+ * @param atlas
+ */
+void atlas_destroy(texture_atlas *atlas);
+
+#endif
@@ -2,20 +2,63 @@
 #define ATOMIC_H
 #include <pthread.h>
 
-// wait for condition
-#define render_wait_condition(mutex,condition) \
-      pthread_mutex_lock(mutex); \
-      pthread_cond_wait(condition, mutex); \
-      pthread_mutex_unlock(mutex); 
-      
-// signal condition
-#define render_signal_condition(mutex,condition) \
-    pthread_mutex_lock(mutex); \
-    pthread_cond_signal(condition); \
-    pthread_mutex_unlock(mutex);  
-    
-#define render_init_condition(mutex,condition) \
-      pthread_mutex_init(mutex, NULL); \
-      pthread_cond_init(condition,NULL);
-      
-#endif      
+/*
+ * Completions: an int that goes from 0 to 1 once, threads wait until it is 1.
+ * Waiting checks the value, so a signal sent before the wait started is not lost.
+ * A completion can be reused after resetting it, once its waiter returned.
+ *
+ * On Linux waiting is a futex wait on the value, elsewhere a shared mutex/condition pair is used.
+ */
+
+#ifdef __linux__
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static inline void render_completion_wait(int *completion)
+{
+  while ( __atomic_load_n(completion,__ATOMIC_ACQUIRE) == 0 ) {
+    // returns immediately if the value is no longer 0
+    syscall(SYS_futex,completion,FUTEX_WAIT_PRIVATE,0,NULL,NULL,0);
+  }
+}
+
+static inline void render_completion_signal(int *completion)
+{
+  __atomic_store_n(completion,1,__ATOMIC_RELEASE);
+  // the waiter may already have returned and reused the completion, waking it up then is harmless
+  syscall(SYS_futex,completion,FUTEX_WAKE_PRIVATE,1,NULL,NULL,0);
+}
+
+#else
+
+static pthread_mutex_t completion_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t completion_condition = PTHREAD_COND_INITIALIZER;
+
+static inline void render_completion_wait(int *completion)
+{
+  pthread_mutex_lock(&completion_mutex);
+  while ( __atomic_load_n(completion,__ATOMIC_ACQUIRE) == 0 ) {
+    pthread_cond_wait(&completion_condition,&completion_mutex);
+  }
+  pthread_mutex_unlock(&completion_mutex);
+}
+
+static inline void render_completion_signal(int *completion)
+{
+  pthread_mutex_lock(&completion_mutex);
+  __atomic_store_n(completion,1,__ATOMIC_RELEASE);
+  // all completions share the condition
+  pthread_cond_broadcast(&completion_condition);
+  pthread_mutex_unlock(&completion_mutex);
+}
+
+#endif
+
+static inline void render_completion_reset(int *completion)
+{
+  __atomic_store_n(completion,0,__ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,274 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "blend.h"
+#include "log.h"
+#include "global.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BLEND_NEON
+#endif
+
+int blend_supports_format(SDL_PixelFormat *format)
+{
+  return format->BitsPerPixel == 16 && format->Rmask == 0xf800 && format->Gmask == 0x07e0 && format->Bmask == 0x001f;
+}
+
+/**
+ * Checks whether a locked ARGB8888 image has pixels that are not fully opaque.
+ */
+static int blend_has_translucent_pixels(SDL_Surface *image)
+{
+  for ( int y = 0 ; y < image->h ; y++ )
+  {
+    Uint32 *row = (Uint32*) ( (Uint8*) image->pixels + y * image->pitch );
+    for ( int x = 0 ; x < image->w ; x++ )
+    {
+      if ( ( row[x] & BLEND_AMASK ) != BLEND_AMASK ) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int blend_is_translucent(SDL_Surface *image)
+{
+  if ( image->format->BitsPerPixel != 32 || image->format->Amask != BLEND_AMASK ) {
+    return 0;
+  }
+  if ( SDL_MUSTLOCK(image) && SDL_LockSurface(image) != 0 ) {
+    log_error("blend_is_translucent(): Failed to lock surface: %s",SDL_GetError());
+    return 0;
+  }
+  int translucent = blend_has_translucent_pixels(image);
+  if ( SDL_MUSTLOCK(image) ) {
+    SDL_UnlockSurface(image);
+  }
+  return translucent;
+}
+
+int blend_premultiply(SDL_Surface *image)
+{
+  if ( image->format->BitsPerPixel != 32 || image->format->Amask != BLEND_AMASK ) {
+    return 0;
+  }
+  if ( SDL_MUSTLOCK(image) && SDL_LockSurface(image) != 0 ) {
+    log_error("blend_premultiply(): Failed to lock surface: %s",SDL_GetError());
+    return 0;
+  }
+  int translucent = blend_has_translucent_pixels(image);
+  for ( int y = 0 ; y < image->h && translucent ; y++ )
+  {
+    Uint32 *row = (Uint32*) ( (Uint8*) image->pixels + y * image->pitch );
+    for ( int x = 0 ; x < image->w ; x++ )
+    {
+      Uint32 pixel = row[x];
+      Uint32 a = pixel >> 24;
+      Uint32 r = ( ( pixel >> 16 ) & 0xff ) * a;
+      Uint32 g = ( ( pixel >> 8 ) & 0xff ) * a;
+      Uint32 b = ( pixel & 0xff ) * a;
+      // x/255 rounded
+      r = ( r + 128 + ( ( r + 128 ) >> 8 ) ) >> 8;
+      g = ( g + 128 + ( ( g + 128 ) >> 8 ) ) >> 8;
+      b = ( b + 128 + ( ( b + 128 ) >> 8 ) ) >> 8;
+      row[x] = ( a << 24 ) | ( r << 16 ) | ( g << 8 ) | b;
+    }
+  }
+  if ( SDL_MUSTLOCK(image) ) {
+    SDL_UnlockSurface(image);
+  }
+  return translucent;
+}
+
+/**
+ * Blends a single pixel: dst = src + dst * (255 - alpha) / 255,
+ * with the RGB565 channels expanded to 8 bits.
+ */
+static Uint16 blend_pixel(Uint16 dst,Uint32 src)
+{
+  Uint32 inverse = 255 - ( src >> 24 );
+  Uint32 r = dst >> 11;
+  Uint32 g = ( dst >> 5 ) & 0x3f;
+  Uint32 b = dst & 0x1f;
+  r = ( ( r << 3 ) | ( r >> 2 ) ) * inverse + 128;
+  g = ( ( g << 2 ) | ( g >> 4 ) ) * inverse + 128;
+  b = ( ( b << 3 ) | ( b >> 2 ) ) * inverse + 128;
+  r = ( ( src >> 16 ) & 0xff ) + ( ( r + ( r >> 8 ) ) >> 8 );
+  g = ( ( src >> 8 ) & 0xff ) + ( ( g + ( g >> 8 ) ) >> 8 );
+  b = ( src & 0xff ) + ( ( b + ( b >> 8 ) ) >> 8 );
+  return ( ( r & 0xf8 ) << 8 ) | ( ( g & 0xfc ) << 3 ) | ( b >> 3 );
+}
+
+#if defined(__SSE2__)
+
+// x * inverse / 255 for 16-bit lanes holding 8-bit values
+static inline __m128i blend_scale(__m128i x,__m128i inverse)
+{
+  __m128i t = _mm_add_epi16( _mm_mullo_epi16(x,inverse), _mm_set1_epi16(128) );
+  return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16(t,8) ), 8 );
+}
+
+/**
+ * Blends 8 pixels.
+ * @return 0 if all of them were transparent and dst was not touched
+ */
+static inline int blend_8_pixels(Uint16 *dst,const Uint32 *src)
+{
+  __m128i s0 = _mm_loadu_si128((const __m128i*) src);
+  __m128i s1 = _mm_loadu_si128((const __m128i*) (src + 4));
+  __m128i mask = _mm_set1_epi32(0xff);
+  // one channel of 8 pixels per register, as 16-bit lanes
+  __m128i a = _mm_packs_epi32( _mm_srli_epi32(s0,24), _mm_srli_epi32(s1,24) );
+  if ( _mm_movemask_epi8( _mm_cmpeq_epi16(a,_mm_setzero_si128()) ) == 0xffff ) {
+    return 0;
+  }
+  __m128i sr = _mm_packs_epi32( _mm_and_si128(_mm_srli_epi32(s0,16),mask), _mm_and_si128(_mm_srli_epi32(s1,16),mask) );
+  __m128i sg = _mm_packs_epi32( _mm_and_si128(_mm_srli_epi32(s0,8),mask), _mm_and_si128(_mm_srli_epi32(s1,8),mask) );
+  __m128i sb = _mm_packs_epi32( _mm_and_si128(s0,mask), _mm_and_si128(s1,mask) );
+
+  __m128i d = _mm_loadu_si128((const __m128i*) dst);
+  __m128i dr = _mm_srli_epi16(d,11);
+  __m128i dg = _mm_and_si128( _mm_srli_epi16(d,5), _mm_set1_epi16(0x3f) );
+  __m128i db = _mm_and_si128( d, _mm_set1_epi16(0x1f) );
+  dr = _mm_or_si128( _mm_slli_epi16(dr,3), _mm_srli_epi16(dr,2) );
+  dg = _mm_or_si128( _mm_slli_epi16(dg,2), _mm_srli_epi16(dg,4) );
+  db = _mm_or_si128( _mm_slli_epi16(db,3), _mm_srli_epi16(db,2) );
+
+  __m128i inverse = _mm_sub_epi16( _mm_set1_epi16(255), a );
+  __m128i r = _mm_add_epi16( sr, blend_scale(dr,inverse) );
+  __m128i g = _mm_add_epi16( sg, blend_scale(dg,inverse) );
+  __m128i b = _mm_add_epi16( sb, blend_scale(db,inverse) );
+
+  __m128i result = _mm_or_si128( _mm_slli_epi16( _mm_srli_epi16(r,3), 11 ),
+                   _mm_or_si128( _mm_slli_epi16( _mm_srli_epi16(g,2), 5 ), _mm_srli_epi16(b,3) ) );
+  _mm_storeu_si128((__m128i*) dst,result);
+  return 1;
+}
+
+#elif defined(BLEND_NEON)
+
+// x * inverse / 255 for 16-bit lanes holding 8-bit values
+static inline uint16x8_t blend_scale(uint16x8_t x,uint16x8_t inverse)
+{
+  uint16x8_t t = vaddq_u16( vmulq_u16(x,inverse), vdupq_n_u16(128) );
+  return vshrq_n_u16( vaddq_u16( t, vshrq_n_u16(t,8) ), 8 );
+}
+
+/**
+ * Blends 8 pixels.
+ * @return 0 if all of them were transparent and dst was not touched
+ */
+static inline int blend_8_pixels(Uint16 *dst,const Uint32 *src)
+{
+  // deinterleaves the bytes B,G,R,A of 8 pixels
+  uint8x8x4_t s = vld4_u8((const uint8_t*) src);
+  if ( vget_lane_u64( vreinterpret_u64_u8(s.val[3]), 0 ) == 0 ) {
+    return 0;
+  }
+  uint16x8_t d = vld1q_u16(dst);
+  uint16x8_t dr = vshrq_n_u16(d,11);
+  uint16x8_t dg = vandq_u16( vshrq_n_u16(d,5), vdupq_n_u16(0x3f) );
+  uint16x8_t db = vandq_u16( d, vdupq_n_u16(0x1f) );
+  dr = vorrq_u16( vshlq_n_u16(dr,3), vshrq_n_u16(dr,2) );
+  dg = vorrq_u16( vshlq_n_u16(dg,2), vshrq_n_u16(dg,4) );
+  db = vorrq_u16( vshlq_n_u16(db,3), vshrq_n_u16(db,2) );
+
+  uint16x8_t inverse = vmovl_u8( vmvn_u8(s.val[3]) );
+  uint16x8_t r = vaddq_u16( vmovl_u8(s.val[2]), blend_scale(dr,inverse) );
+  uint16x8_t g = vaddq_u16( vmovl_u8(s.val[1]), blend_scale(dg,inverse) );
+  uint16x8_t b = vaddq_u16( vmovl_u8(s.val[0]), blend_scale(db,inverse) );
+
+  uint16x8_t result = vorrq_u16( vshlq_n_u16( vshrq_n_u16(r,3), 11 ),
+                      vorrq_u16( vshlq_n_u16( vshrq_n_u16(g,2), 5 ), vshrq_n_u16(b,3) ) );
+  vst1q_u16(dst,result);
+  return 1;
+}
+
+#endif
+
+void blend_row_rgb565(Uint16 *dst,const Uint32 *src,int count)
+{
+  int x = 0;
+#if defined(__SSE2__) || defined(BLEND_NEON)
+  for ( ; x + 8 <= count ; x += 8 ) {
+    blend_8_pixels(dst + x,src + x);
+  }
+#endif
+  for ( ; x < count ; x++ )
+  {
+    Uint32 pixel = src[x];
+    if ( pixel >= 0x01000000 ) {
+      dst[x] = blend_pixel(dst[x],pixel);
+    }
+  }
+}
+
+int blend_blit(SDL_Surface *src,SDL_Rect *srcRect,SDL_Surface *dst,SDL_Rect *dstRect)
+{
+  if ( src->format->BitsPerPixel != 32 || src->format->Amask != BLEND_AMASK || ! blend_supports_format(dst->format) ) {
+    return SDL_BlitSurface(src,srcRect,dst,dstRect) == 0;
+  }
+  SDL_Rect source = srcRect ? *srcRect : (SDL_Rect) { 0, 0, src->w, src->h };
+  int x = dstRect ? dstRect->x : 0;
+  int y = dstRect ? dstRect->y : 0;
+
+  // clip to the image
+  if ( source.x < 0 ) {
+    x -= source.x;
+    source.w = max( source.w + source.x, 0 );
+    source.x = 0;
+  }
+  if ( source.y < 0 ) {
+    y -= source.y;
+    source.h = max( source.h + source.y, 0 );
+    source.y = 0;
+  }
+  int width = min( source.w, src->w - source.x );
+  int height = min( source.h, src->h - source.y );
+
+  // clip to the target
+  SDL_Rect *clip = &dst->clip_rect;
+  int skipX = max( clip->x - x, 0 );
+  int skipY = max( clip->y - y, 0 );
+  width = min( width, clip->x + clip->w - x ) - skipX;
+  height = min( height, clip->y + clip->h - y ) - skipY;
+  if ( dstRect )
+  {
+    dstRect->x = x + skipX;
+    dstRect->y = y + skipY;
+    dstRect->w = max(width,0);
+    dstRect->h = max(height,0);
+  }
+  if ( width <= 0 || height <= 0 ) {
+    return 1;
+  }
+
+  if ( SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) != 0 ) {
+    log_error("blend_blit(): Failed to lock surface: %s",SDL_GetError());
+    return 0;
+  }
+  if ( SDL_MUSTLOCK(src) && SDL_LockSurface(src) != 0 )
+  {
+    log_error("blend_blit(): Failed to lock surface: %s",SDL_GetError());
+    if ( SDL_MUSTLOCK(dst) ) {
+      SDL_UnlockSurface(dst);
+    }
+    return 0;
+  }
+  for ( int row = 0 ; row < height ; row++ )
+  {
+    const Uint32 *srcRow = (const Uint32*) ( (Uint8*) src->pixels + ( source.y + skipY + row ) * src->pitch ) + source.x + skipX;
+    Uint16 *dstRow = (Uint16*) ( (Uint8*) dst->pixels + ( y + skipY + row ) * dst->pitch ) + x + skipX;
+    blend_row_rgb565(dstRow,srcRow,width);
+  }
+  if ( SDL_MUSTLOCK(src) ) {
+    SDL_UnlockSurface(src);
+  }
+  if ( SDL_MUSTLOCK(dst) ) {
+    SDL_UnlockSurface(dst);
+  }
+  return 1;
+}
@@ -0,0 +1,67 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Compositing of translucent images onto RGB565 surfaces.
+ *
+ * SDL_ConvertSurface() to the screen format drops the alpha channel, so images that
+ * are not completely opaque are kept as 32-bit ARGB with premultiplied alpha instead
+ * (see imageloader_convert()) and blended by blend_blit(). Opaque images are still
+ * converted to the screen format and blitted by SDL, which is the cheapest way to draw them.
+ *
+ * The blend kernel processes 8 pixels at a time with SSE2 or NEON if the compiler
+ * targets them, otherwise one pixel at a time. Runs of fully transparent pixels are skipped.
+ */
+
+// premultiplied ARGB8888, the format imageloader_scale() produces
+#define BLEND_RMASK 0x00ff0000
+#define BLEND_GMASK 0x0000ff00
+#define BLEND_BMASK 0x000000ff
+#define BLEND_AMASK 0xff000000
+
+/**
+ * Checks whether translucent images can be blended onto surfaces of a format.
+ * @param format target format
+ * @return 0 unless the format is RGB565
+ */
+int blend_supports_format(SDL_PixelFormat *format);
+
+/**
+ * Premultiplies the color channels of an ARGB8888 image with its alpha channel,
+ * unless the image is completely opaque.
+ *
+ * @param image ARGB8888 image
+ * @return 1 if the image has translucent pixels and got premultiplied, 0 if it is opaque and was left as it is
+ */
+int blend_premultiply(SDL_Surface *image);
+
+/**
+ * Checks whether an ARGB8888 image has pixels that are not fully opaque.
+ * @param image
+ * @return 0 if the image is opaque or not ARGB8888
+ */
+int blend_is_translucent(SDL_Surface *image);
+
+/**
+ * Blends a row of premultiplied ARGB8888 pixels onto RGB565 pixels.
+ * @param dst
+ * @param src
+ * @param count number of pixels
+ */
+void blend_row_rgb565(Uint16 *dst,const Uint32 *src,int count);
+
+/**
+ * Draws an image like SDL_BlitSurface(), blending premultiplied ARGB8888 images
+ * onto RGB565 surfaces. All other images are passed to SDL_BlitSurface().
+ *
+ * @param src image
+ * @param srcRect part of the image to draw or NULL for all of it
+ * @param dst target surface
+ * @param dstRect position on the target surface, receives the area drawn (like SDL_BlitSurface())
+ * @return 0 on error, otherwise success
+ */
+int blend_blit(SDL_Surface *src,SDL_Rect *srcRect,SDL_Surface *dst,SDL_Rect *dstRect);
+
+#endif
@@ -0,0 +1,228 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "bundle.h"
+#include "blend.h"
+#include "log.h"
+#include "global.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const unsigned char *mapping = NULL;
+static size_t mappingSize = 0;
+
+static const bundle_header *header = NULL;
+static const bundle_glyph *glyphs = NULL;
+static const bundle_icon *icons = NULL;
+
+/**
+ * Checks whether an area lies within the mapped file.
+ */
+static int bundle_in_range(size_t offset,size_t size)
+{
+  return offset <= mappingSize && size <= mappingSize - offset;
+}
+
+static int bundle_icon_bytes_per_pixel(const bundle_icon *icon)
+{
+  return icon->format == BUNDLE_ICON_ARGB8888 ? 4 : 2;
+}
+
+/**
+ * Validates all offsets so that a corrupt bundle can't make us read beyond the mapping.
+ * @return 0 if the bundle is invalid
+ */
+static int bundle_validate(const char *path)
+{
+  const bundle_header *hdr = (const bundle_header*) mapping;
+  if ( mappingSize < sizeof(bundle_header) || hdr->magic != BUNDLE_MAGIC ) {
+    log_error("bundle_open(): %s is no asset bundle or has a different byte order",path);
+    return 0;
+  }
+  if ( hdr->version != BUNDLE_VERSION ) {
+    log_error("bundle_open(): %s has version %u, expected %d",path,hdr->version,BUNDLE_VERSION);
+    return 0;
+  }
+  if ( hdr->fontPath[BUNDLE_PATH_LENGTH-1] != 0 || hdr->glyphOffset % 4 != 0 || hdr->iconOffset % 4 != 0
+       || ! bundle_in_range(hdr->glyphOffset,(size_t) BUNDLE_GLYPH_COUNT * sizeof(bundle_glyph))
+       || ! bundle_in_range(hdr->iconOffset,(size_t) hdr->iconCount * sizeof(bundle_icon)) )
+  {
+    log_error("bundle_open(): %s has a corrupt header",path);
+    return 0;
+  }
+  const bundle_glyph *glyphTable = (const bundle_glyph*) (mapping + hdr->glyphOffset);
+  for ( int i = 0 ; i < BUNDLE_GLYPH_COUNT ; i++ )
+  {
+    if ( ! bundle_in_range(glyphTable[i].offset,(size_t) glyphTable[i].width * hdr->fontHeight) ) {
+      log_error("bundle_open(): %s has a corrupt glyph %d",path,BUNDLE_FIRST_GLYPH+i);
+      return 0;
+    }
+  }
+  const bundle_icon *iconTable = (const bundle_icon*) (mapping + hdr->iconOffset);
+  for ( Uint32 i = 0 ; i < hdr->iconCount ; i++ )
+  {
+    const bundle_icon *icon = &iconTable[i];
+    if ( icon->path[BUNDLE_PATH_LENGTH-1] != 0 || icon->offset % 4 != 0
+         || ( icon->format != BUNDLE_ICON_RGB565 && icon->format != BUNDLE_ICON_ARGB8888 )
+         || ! bundle_in_range(icon->offset,(size_t) icon->width * icon->height * bundle_icon_bytes_per_pixel(icon)) )
+    {
+      log_error("bundle_open(): %s has a corrupt icon #%u",path,i);
+      return 0;
+    }
+  }
+  header = hdr;
+  glyphs = glyphTable;
+  icons = iconTable;
+  return 1;
+}
+
+int bundle_open(const char *path)
+{
+  bundle_close();
+
+  int fd = open(path,O_RDONLY);
+  if ( fd == -1 ) {
+    log_error("bundle_open(): Failed to open %s",path);
+    return 0;
+  }
+  struct stat fileStat;
+  if ( fstat(fd,&fileStat) != 0 || fileStat.st_size == 0 ) {
+    log_error("bundle_open(): Failed to get size of %s",path);
+    close(fd);
+    return 0;
+  }
+  // pages only get read in when an icon or glyph is actually used
+  void *data = mmap(NULL,fileStat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if ( data == MAP_FAILED ) {
+    log_error("bundle_open(): Failed to map %s",path);
+    return 0;
+  }
+  mapping = data;
+  mappingSize = fileStat.st_size;
+  if ( ! bundle_validate(path) ) {
+    bundle_close();
+    return 0;
+  }
+  log_info("bundle_open(): Mapped %s (%ld bytes, %u icons, glyphs of %s at size %u)",
+           path,(long) mappingSize,header->iconCount,header->fontPath,header->fontSize);
+  return 1;
+}
+
+void bundle_close(void)
+{
+  if ( mapping ) {
+    munmap((void*) mapping,mappingSize);
+  }
+  mapping = NULL;
+  mappingSize = 0;
+  header = NULL;
+  glyphs = NULL;
+  icons = NULL;
+}
+
+int bundle_has_font(const char *fontPath,int fontSize)
+{
+  return header && header->fontHeight > 0 && header->fontSize == (Uint32) fontSize
+         && strcmp(header->fontPath,fontPath) == 0;
+}
+
+static const bundle_glyph *bundle_get_glyph(unsigned char c)
+{
+  // characters without glyph (control characters) are rendered as space, like SDL_ttf does
+  return &glyphs[ c < BUNDLE_FIRST_GLYPH ? 0 : c - BUNDLE_FIRST_GLYPH ];
+}
+
+int bundle_size_text(const char *text,int *width,int *height)
+{
+  if ( header == NULL || header->fontHeight == 0 ) {
+    return 0;
+  }
+  int textWidth = 0;
+  for ( const unsigned char *c = (const unsigned char*) text ; *c ; c++ ) {
+    textWidth += bundle_get_glyph(*c)->width;
+  }
+  *width = textWidth;
+  *height = header->fontHeight;
+  return 1;
+}
+
+int bundle_render_text(SDL_Surface *surface,const char *text,int x,int y,SDL_Color color,SDL_Rect *result)
+{
+  int bytesPerPixel = surface->format->BytesPerPixel;
+  if ( header == NULL || header->fontHeight == 0 || ( bytesPerPixel != 2 && bytesPerPixel != 4 ) ) {
+    return 0;
+  }
+  Uint32 pixel = SDL_MapRGB(surface->format,color.r,color.g,color.b);
+  SDL_Rect *clip = &surface->clip_rect;
+  int fontHeight = header->fontHeight;
+
+  if ( SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0 ) {
+    return 0;
+  }
+  int glyphX = x;
+  for ( const unsigned char *c = (const unsigned char*) text ; *c ; c++ )
+  {
+    const bundle_glyph *glyph = bundle_get_glyph(*c);
+    const unsigned char *coverage = mapping + glyph->offset;
+    int minX = max(glyphX,clip->x);
+    int maxX = min(glyphX + (int) glyph->width,clip->x + clip->w);
+    int minY = max(y,clip->y);
+    int maxY = min(y + fontHeight,clip->y + clip->h);
+    for ( int dy = minY ; dy < maxY ; dy++ )
+    {
+      const unsigned char *src = coverage + (dy - y) * glyph->width;
+      Uint8 *row = (Uint8*) surface->pixels + dy * surface->pitch;
+      for ( int dx = minX ; dx < maxX ; dx++ )
+      {
+        if ( ! src[dx - glyphX] ) {
+          continue;
+        }
+        if ( bytesPerPixel == 2 ) {
+          ((Uint16*) row)[dx] = pixel;
+        } else {
+          ((Uint32*) row)[dx] = pixel;
+        }
+      }
+    }
+    glyphX += glyph->width;
+  }
+  if ( SDL_MUSTLOCK(surface) ) {
+    SDL_UnlockSurface(surface);
+  }
+  result->x = x;
+  result->y = y;
+  result->w = glyphX - x;
+  result->h = fontHeight;
+  return 1;
+}
+
+SDL_Surface *bundle_get_icon(const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format)
+{
+  if ( header == NULL || ! blend_supports_format(format) ) {
+    return NULL;
+  }
+  for ( Uint32 i = 0 ; i < header->iconCount ; i++ )
+  {
+    const bundle_icon *icon = &icons[i];
+    if ( icon->maxWidth != maxWidth || icon->maxHeight != maxHeight || strcmp(icon->path,path) != 0 ) {
+      continue;
+    }
+    // SDL never writes to the pixels of a blit source, so the read-only pages can be used directly
+    SDL_Surface *surface;
+    if ( icon->format == BUNDLE_ICON_ARGB8888 ) {
+      surface = SDL_CreateRGBSurfaceFrom((void*) (mapping + icon->offset),icon->width,icon->height,32,
+                                         icon->width * 4,BLEND_RMASK,BLEND_GMASK,BLEND_BMASK,BLEND_AMASK);
+    } else {
+      surface = SDL_CreateRGBSurfaceFrom((void*) (mapping + icon->offset),icon->width,icon->height,16,
+                                         icon->width * 2,0xf800,0x07e0,0x001f,0);
+    }
+    if ( surface == NULL ) {
+      log_error("bundle_get_icon(): Failed to create surface: %s",SDL_GetError());
+    }
+    return surface;
+  }
+  return NULL;
+}
@@ -0,0 +1,123 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Asset bundles hold icons and glyphs in the form the renderer uses them
+ * (icons already scaled and converted to RGB565 or, if they are translucent, to premultiplied
+ * ARGB8888 like the image loader keeps them, glyphs already rasterized),
+ * so startup only needs to mmap() the file instead of opening fonts and decoding images.
+ *
+ * Bundles are created offline by tools/mkbundle. All values are stored in the
+ * byte order of the machine that created the bundle, bundles with a different byte order
+ * are rejected.
+ *
+ * File layout:
+ *
+ * bundle_header
+ * bundle_glyph[BUNDLE_GLYPH_COUNT] at header.glyphOffset
+ * bundle_icon[header.iconCount] at header.iconOffset
+ * glyph coverage (width*fontHeight bytes, 0 or 1) and icon pixels (width*height RGB565 or ARGB8888 values),
+ * each starting at a 4 byte boundary
+ *
+ * The bundle is only accessed from the rendering thread.
+ */
+
+#define BUNDLE_MAGIC 0x424c594dU // "MYLB"
+#define BUNDLE_VERSION 2
+
+// glyphs are rasterized for ISO-8859-1 characters, like TTF_RenderText_Solid() expects them
+#define BUNDLE_FIRST_GLYPH 32
+#define BUNDLE_LAST_GLYPH 255
+#define BUNDLE_GLYPH_COUNT (BUNDLE_LAST_GLYPH - BUNDLE_FIRST_GLYPH + 1)
+
+#define BUNDLE_PATH_LENGTH 128
+
+typedef struct bundle_header
+{
+  Uint32 magic;
+  Uint32 version;
+  char fontPath[BUNDLE_PATH_LENGTH]; // font the glyphs were rasterized from
+  Uint32 fontSize;
+  Uint32 fontHeight; // height of all glyphs
+  Uint32 glyphOffset;
+  Uint32 iconCount;
+  Uint32 iconOffset;
+} bundle_header;
+
+typedef struct bundle_glyph
+{
+  Uint32 width; // also the advance
+  Uint32 offset; // offset of the coverage
+} bundle_glyph;
+
+// pixel formats of icons
+#define BUNDLE_ICON_RGB565 0
+#define BUNDLE_ICON_ARGB8888 1 // premultiplied alpha, see blend.h
+
+typedef struct bundle_icon
+{
+  char path[BUNDLE_PATH_LENGTH]; // image file the icon was created from
+  Uint16 maxWidth; // size the image was scaled to fit into
+  Uint16 maxHeight;
+  Uint16 width;
+  Uint16 height;
+  Uint16 format; // BUNDLE_ICON_xxx
+  Uint16 reserved;
+  Uint32 offset; // offset of the pixels
+} bundle_icon;
+
+/**
+ * Maps a bundle into memory, replacing any previously opened bundle.
+ * @param path bundle file
+ * @return 0 if the file could not be mapped or is no valid bundle, otherwise success
+ */
+int bundle_open(const char *path);
+
+/**
+ * Unmaps the bundle. Icons returned by bundle_get_icon() must have been freed.
+ */
+void bundle_close(void);
+
+/**
+ * Checks whether the bundle holds glyphs of a font.
+ * @param fontPath
+ * @param fontSize
+ * @return 0 if no bundle is open or its glyphs were rasterized from a different font or size
+ */
+int bundle_has_font(const char *fontPath,int fontSize);
+
+/**
+ * Calculates the size of a text.
+ * @param text
+ * @param width
+ * @param height
+ * @return 0 if the bundle holds no glyphs, otherwise success
+ */
+int bundle_size_text(const char *text,int *width,int *height);
+
+/**
+ * Draws a text using the glyphs of the bundle.
+ * @param surface surface to draw onto, must have 16 or 32 bits per pixel
+ * @param text
+ * @param x
+ * @param y
+ * @param color
+ * @param result area covered by the text (unclipped)
+ * @return 0 if the bundle holds no glyphs or the surface format is not supported, otherwise success
+ */
+int bundle_render_text(SDL_Surface *surface,const char *text,int x,int y,SDL_Color color,SDL_Rect *result);
+
+/**
+ * Looks up an icon. The icon's pixels are not copied, they stay inside the mapped bundle.
+ * @param path image file the icon was created from
+ * @param maxWidth size the image was scaled to fit into
+ * @param maxHeight
+ * @param format pixel format the icon is needed in
+ * @return icon (free with SDL_FreeSurface()), translucent icons are premultiplied ARGB8888 to draw with blend_blit(),
+ *         NULL if the bundle has no such icon or the format is not RGB565
+ */
+SDL_Surface *bundle_get_icon(const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format);
+
+#endif
@@ -0,0 +1,140 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "display.h"
+#include "log.h"
+#include "SDL/SDL_getenv.h"
+
+// #define USE_FB
+
+// ========================== SDL ==========================
+
+static SDL_Surface *sdlScreen = NULL;
+static int sdlInitialized = 0;
+
+static int display_sdl_init(int width,int height,int bitsPerPixel)
+{
+#ifdef USE_FB
+ // Update the environment variables for SDL to
+ // work correctly with the external display on
+ // LINUX frame buffer 1 (fb1).
+ putenv((char*)"FRAMEBUFFER=/dev/fb1");
+ putenv((char*)"SDL_FBDEV=/dev/fb1");
+#endif
+
+  // Initialize SDL
+  if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+    log_error("SDL_Init() failed: %s",SDL_GetError());
+    return 0;
+  }
+  sdlInitialized = 1;
+
+  // Fetch the best video mode
+  // - Note that the Raspberry Pi generally defaults
+  //   to a 16bits/pixel framebuffer
+  const SDL_VideoInfo* vInfo = SDL_GetVideoInfo();
+  if (!vInfo) {
+    log_error("SDL_GetVideoInfo() failed: %s",SDL_GetError());
+    return 0;
+  }
+
+  // Configure the video mode
+  // - SDL_SWSURFACE appears to be most robust mode
+  int     nFlags = SDL_SWSURFACE;
+  sdlScreen = SDL_SetVideoMode(width,height,bitsPerPixel,nFlags);
+  if (sdlScreen == 0) {
+    log_error("SDL_SetVideoMode() failed: %s",SDL_GetError());
+    return 0;
+  }
+  return 1;
+}
+
+static SDL_Surface *display_sdl_get_back_buffer(void)
+{
+  return sdlScreen;
+}
+
+static void display_sdl_flush(SDL_Rect *rects,int rectCount)
+{
+  if ( rectCount == 0 ) {
+    SDL_Flip(sdlScreen);
+  } else {
+    SDL_UpdateRects(sdlScreen,rectCount,rects);
+  }
+}
+
+static void display_sdl_shutdown(void)
+{
+  // the screen surface is owned by SDL
+  sdlScreen = NULL;
+  if ( sdlInitialized ) {
+    SDL_Quit();
+    sdlInitialized = 0;
+  }
+}
+
+static const display_backend sdlBackend = {
+  "sdl",
+  display_sdl_init,
+  display_sdl_get_back_buffer,
+  display_sdl_flush,
+  display_sdl_shutdown
+};
+
+// ========================== memory ==========================
+
+static SDL_Surface *memoryScreen = NULL;
+
+static int display_memory_init(int width,int height,int bitsPerPixel)
+{
+  Uint32 rmask = 0, gmask = 0, bmask = 0;
+  if ( bitsPerPixel == 16 ) {
+    // RGB565, same as a typical framebuffer
+    rmask = 0xf800;
+    gmask = 0x07e0;
+    bmask = 0x001f;
+  }
+  memoryScreen = SDL_CreateRGBSurface(SDL_SWSURFACE,width,height,bitsPerPixel,rmask,gmask,bmask,0);
+  if ( ! memoryScreen ) {
+    log_error("display_memory_init(): Failed to create %dx%dx%d surface: %s",width,height,bitsPerPixel,SDL_GetError());
+    return 0;
+  }
+  return 1;
+}
+
+static SDL_Surface *display_memory_get_back_buffer(void)
+{
+  return memoryScreen;
+}
+
+static void display_memory_flush(SDL_Rect *rects,int rectCount)
+{
+  // nothing to display
+}
+
+static void display_memory_shutdown(void)
+{
+  if ( memoryScreen ) {
+    SDL_FreeSurface(memoryScreen);
+    memoryScreen = NULL;
+  }
+}
+
+static const display_backend memoryBackend = {
+  "memory",
+  display_memory_init,
+  display_memory_get_back_buffer,
+  display_memory_flush,
+  display_memory_shutdown
+};
+
+const display_backend *display_get_backend(DisplayBackendType type)
+{
+  switch(type) {
+    case DISPLAY_BACKEND_SDL:
+      return &sdlBackend;
+    case DISPLAY_BACKEND_MEMORY:
+      return &memoryBackend;
+    default:
+      return NULL;
+  }
+}
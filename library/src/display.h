@@ -0,0 +1,56 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Display backends provide the surface the rendering thread draws into
+ * and present it.
+ *
+ * All functions are only ever invoked on the rendering thread.
+ */
+
+typedef enum {
+  DISPLAY_BACKEND_SDL=0, // SDL video subsystem (framebuffer, X11, ...)
+  DISPLAY_BACKEND_MEMORY=1 // off-screen surface only, nothing is ever displayed
+} DisplayBackendType;
+
+typedef struct display_backend
+{
+  const char *name;
+
+  /**
+   * Initializes the display.
+   * @param width
+   * @param height
+   * @param bitsPerPixel
+   * @return 0 on error, otherwise success
+   */
+  int (*init)(int width,int height,int bitsPerPixel);
+
+  /**
+   * Returns the surface to draw into, only valid between init() and shutdown().
+   */
+  SDL_Surface *(*get_back_buffer)(void);
+
+  /**
+   * Makes parts of the back buffer visible.
+   * @param rects areas to update
+   * @param rectCount number of rects, 0 updates the whole screen
+   */
+  void (*flush)(SDL_Rect *rects,int rectCount);
+
+  /**
+   * Releases all resources, safe to call even if init() failed.
+   */
+  void (*shutdown)(void);
+} display_backend;
+
+/**
+ * Returns one of the built-in backends.
+ * @param type
+ * @return backend or NULL if type is invalid
+ */
+const display_backend *display_get_backend(DisplayBackendType type);
+
+#endif
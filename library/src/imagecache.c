@@ -0,0 +1,357 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "imagecache.h"
+#include "log.h"
+#include "mempool.h"
+#include "memstats.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static image_cache_entry *buckets[IMAGECACHE_BUCKET_COUNT];
+
+// all entries, most recently used first
+static image_cache_entry *lruFirst = NULL;
+static image_cache_entry *lruLast = NULL;
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static image_cache_stats stats;
+
+// holds small opaque images of the screen format
+static texture_atlas atlas;
+
+static slab_pool entryPool = SLAB_POOL_INITIALIZER("image_cache_entry",image_cache_entry,16);
+static slab_pool waiterPool = SLAB_POOL_INITIALIZER("image_cache_waiter",image_cache_waiter,16);
+
+static unsigned int imagecache_hash(const char *path,int maxWidth,int maxHeight)
+{
+  // FNV-1a
+  unsigned int hash = 2166136261u;
+  for ( const char *c = path ; *c ; c++ ) {
+    hash = (hash ^ (unsigned char) *c) * 16777619u;
+  }
+  hash = (hash ^ maxWidth) * 16777619u;
+  hash = (hash ^ maxHeight) * 16777619u;
+  return hash % IMAGECACHE_BUCKET_COUNT;
+}
+
+static void imagecache_lru_unlink(image_cache_entry *entry)
+{
+  if ( entry->lruPrevious ) {
+    entry->lruPrevious->lruNext = entry->lruNext;
+  } else {
+    lruFirst = entry->lruNext;
+  }
+  if ( entry->lruNext ) {
+    entry->lruNext->lruPrevious = entry->lruPrevious;
+  } else {
+    lruLast = entry->lruPrevious;
+  }
+  entry->lruPrevious = NULL;
+  entry->lruNext = NULL;
+}
+
+static void imagecache_lru_push_front(image_cache_entry *entry)
+{
+  entry->lruNext = lruFirst;
+  if ( lruFirst ) {
+    lruFirst->lruPrevious = entry;
+  } else {
+    lruLast = entry;
+  }
+  lruFirst = entry;
+}
+
+static void imagecache_update_size(long bytes,int entries,int atlasEntries)
+{
+  pthread_mutex_lock(&stats_mutex);
+  stats.bytes += bytes;
+  stats.entryCount += entries;
+  stats.atlasEntryCount += atlasEntries;
+  pthread_mutex_unlock(&stats_mutex);
+}
+
+static long imagecache_entry_size(image_cache_entry *entry)
+{
+  // pages of the asset bundle are not part of the heap
+  if ( entry->image == NULL || entry->inBundle ) {
+    return 0;
+  }
+  if ( entry->inAtlas ) {
+    return entry->rect.w * entry->rect.h * entry->image->format->BytesPerPixel;
+  }
+  return memstats_surface_size(entry->image);
+}
+
+/**
+ * Checks whether a pixel format is the one an entry was requested in.
+ */
+static int imagecache_has_format(image_cache_entry *entry,SDL_PixelFormat *format)
+{
+  return entry->bitsPerPixel == format->BitsPerPixel && entry->rmask == format->Rmask && entry->gmask == format->Gmask
+         && entry->bmask == format->Bmask && entry->amask == format->Amask;
+}
+
+static void imagecache_free_entry(image_cache_entry *entry);
+
+/**
+ * Moves an image into the atlas, evicting unused images from the atlas if it is full.
+ * @return 0 if the image does not fit into the atlas
+ */
+static int imagecache_add_to_atlas(image_cache_entry *entry,SDL_Surface *image)
+{
+  if ( image->w > ATLAS_MAX_IMAGE_SIZE || image->h > ATLAS_MAX_IMAGE_SIZE ) {
+    return 0;
+  }
+  // translucent images are delivered as premultiplied ARGB8888 instead of the requested
+  // format and get blended, they must neither go into nor determine the format of the atlas
+  if ( ! imagecache_has_format(entry,image->format) ) {
+    return 0;
+  }
+  if ( atlas.surface == NULL && ! atlas_init(&atlas,image->format) ) {
+    return 0;
+  }
+  if ( ! imagecache_has_format(entry,atlas.surface->format) ) {
+    return 0;
+  }
+
+  int added = atlas_add(&atlas,image,&entry->rect);
+  for ( image_cache_entry *victim = lruLast ; victim && ! added ; )
+  {
+    image_cache_entry *previous = victim->lruPrevious;
+    if ( victim->inAtlas && victim->refCount == 0 )
+    {
+      imagecache_free_entry(victim);
+      pthread_mutex_lock(&stats_mutex);
+      stats.evictions++;
+      pthread_mutex_unlock(&stats_mutex);
+      added = atlas_add(&atlas,image,&entry->rect);
+    }
+    victim = previous;
+  }
+  if ( ! added ) {
+    return 0;
+  }
+  memstats_remove(MEM_CATEGORY_IMAGES,memstats_surface_size(image));
+  SDL_FreeSurface(image);
+  entry->image = atlas.surface;
+  entry->inAtlas = 1;
+  return 1;
+}
+
+/**
+ * Invoked by the image loader on the rendering thread.
+ */
+static void imagecache_image_loaded(SDL_Surface *image,image_cache_entry *entry)
+{
+  entry->request = NULL;
+  if ( image && ! imagecache_add_to_atlas(entry,image) )
+  {
+    entry->image = image;
+    entry->rect.x = 0;
+    entry->rect.y = 0;
+    entry->rect.w = image->w;
+    entry->rect.h = image->h;
+  }
+  if ( entry->image ) {
+    imagecache_update_size(imagecache_entry_size(entry),0,entry->inAtlas);
+  }
+  image = entry->image;
+
+  image_cache_waiter *waiter = entry->waiters;
+  entry->waiters = NULL;
+  while ( waiter )
+  {
+    image_cache_waiter *next = waiter->next;
+    waiter->callback(image,waiter->callbackData);
+    slab_free(&waiterPool,waiter);
+    waiter = next;
+  }
+}
+
+/**
+ * Starts loading the image of an entry.
+ * @return 0 on error, otherwise success
+ */
+static int imagecache_load(image_cache_entry *entry,SDL_PixelFormat *format)
+{
+  entry->request = imageloader_load(entry->path,entry->maxWidth,entry->maxHeight,format,
+                                    (ImageLoadedCallback) imagecache_image_loaded,entry);
+  return entry->request != NULL;
+}
+
+/**
+ * Frees an entry that is no longer referenced.
+ */
+static void imagecache_free_entry(image_cache_entry *entry)
+{
+  image_cache_entry **current = &buckets[imagecache_hash(entry->path,entry->maxWidth,entry->maxHeight)];
+  while ( *current != entry ) {
+    current = &(*current)->nextInBucket;
+  }
+  *current = entry->nextInBucket;
+  imagecache_lru_unlink(entry);
+
+  if ( entry->request ) {
+    imageloader_cancel(entry->request);
+  }
+  while ( entry->waiters )
+  {
+    image_cache_waiter *next = entry->waiters->next;
+    slab_free(&waiterPool,entry->waiters);
+    entry->waiters = next;
+  }
+  long bytes = imagecache_entry_size(entry);
+  if ( entry->inAtlas ) {
+    atlas_remove(&atlas,&entry->rect);
+  }
+  else if ( entry->image )
+  {
+    memstats_remove(MEM_CATEGORY_IMAGES,bytes);
+    // only frees the surface header for images from the bundle
+    SDL_FreeSurface(entry->image);
+  }
+  imagecache_update_size(-bytes,-1,entry->inAtlas ? -1 : 0);
+  free(entry->path);
+  slab_free(&entryPool,entry);
+}
+
+image_cache_entry *imagecache_acquire(const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format,
+                                      ImageLoadedCallback callback,void *callbackData)
+{
+  unsigned int bucket = imagecache_hash(path,maxWidth,maxHeight);
+  image_cache_entry *entry = buckets[bucket];
+  while ( entry )
+  {
+    if ( entry->maxWidth == maxWidth && entry->maxHeight == maxHeight && imagecache_has_format(entry,format)
+         && strcmp(entry->path,path) == 0 )
+    {
+      break;
+    }
+    entry = entry->nextInBucket;
+  }
+
+  pthread_mutex_lock(&stats_mutex);
+  if ( entry ) {
+    stats.hits++;
+  } else {
+    stats.misses++;
+  }
+  pthread_mutex_unlock(&stats_mutex);
+
+  if ( entry == NULL )
+  {
+    entry = slab_alloc(&entryPool);
+    if ( entry == NULL ) {
+      log_error("imagecache_acquire(): Failed to allocate entry");
+      return NULL;
+    }
+    entry->path = mem_strdup(path);
+    if ( entry->path == NULL ) {
+      slab_free(&entryPool,entry);
+      log_error("imagecache_acquire(): Failed to allocate entry");
+      return NULL;
+    }
+    entry->maxWidth = maxWidth;
+    entry->maxHeight = maxHeight;
+    entry->bitsPerPixel = format->BitsPerPixel;
+    entry->rmask = format->Rmask;
+    entry->gmask = format->Gmask;
+    entry->bmask = format->Bmask;
+    entry->amask = format->Amask;
+
+    entry->nextInBucket = buckets[bucket];
+    buckets[bucket] = entry;
+    imagecache_lru_push_front(entry);
+    imagecache_update_size(0,1,0);
+    
+    // precompiled images don't need to be loaded
+    entry->image = bundle_get_icon(path,maxWidth,maxHeight,format);
+    if ( entry->image ) 
+    {
+      entry->inBundle = 1;
+      entry->rect.w = entry->image->w;
+      entry->rect.h = entry->image->h;
+    }
+  } else {
+    imagecache_lru_unlink(entry);
+    imagecache_lru_push_front(entry);
+  }
+
+  if ( entry->image == NULL )
+  {
+    image_cache_waiter *waiter = slab_alloc(&waiterPool);
+    if ( waiter == NULL ) {
+      log_error("imagecache_acquire(): Failed to allocate waiter");
+      return NULL;
+    }
+    // loading failed before, try again
+    if ( entry->request == NULL && ! imagecache_load(entry,format) ) {
+      slab_free(&waiterPool,waiter);
+      return NULL;
+    }
+    waiter->callback = callback;
+    waiter->callbackData = callbackData;
+    waiter->next = entry->waiters;
+    entry->waiters = waiter;
+  }
+  entry->refCount++;
+  return entry;
+}
+
+void imagecache_release(image_cache_entry *entry,void *callbackData)
+{
+  image_cache_waiter **current = &entry->waiters;
+  while ( *current && (*current)->callbackData != callbackData ) {
+    current = &(*current)->next;
+  }
+  if ( *current )
+  {
+    image_cache_waiter *waiter = *current;
+    *current = waiter->next;
+    slab_free(&waiterPool,waiter);
+  }
+  // unreferenced entries stay cached until they get evicted
+  entry->refCount--;
+}
+
+void imagecache_evict(long excessBytes)
+{
+  long released = 0;
+  image_cache_entry *entry = lruLast;
+  while ( entry && released < excessBytes )
+  {
+    image_cache_entry *previous = entry->lruPrevious;
+    // evicting images from the atlas or the bundle does not release any memory
+    if ( entry->refCount == 0 && ! entry->inAtlas && ! entry->inBundle )
+    {
+      released += imagecache_entry_size(entry);
+      imagecache_free_entry(entry);
+
+      pthread_mutex_lock(&stats_mutex);
+      stats.evictions++;
+      pthread_mutex_unlock(&stats_mutex);
+    }
+    entry = previous;
+  }
+  log_debug("imagecache_evict(): Released %ld of %ld bytes",released,excessBytes);
+}
+
+void imagecache_clear(void)
+{
+  while ( lruFirst )
+  {
+    if ( lruFirst->refCount > 0 ) {
+      log_warn("imagecache_clear(): Image %s is still referenced",lruFirst->path);
+    }
+    imagecache_free_entry(lruFirst);
+  }
+  atlas_destroy(&atlas);
+}
+
+void imagecache_get_stats(image_cache_stats *result)
+{
+  pthread_mutex_lock(&stats_mutex);
+  *result = stats;
+  pthread_mutex_unlock(&stats_mutex);
+}
@@ -0,0 +1,108 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include "SDL/SDL.h"
+#include "imageloader.h"
+#include "atlas.h"
+#include "bundle.h"
+
+/*
+ * Shares decoded images between all widgets that display the same
+ * file at the same size in the same pixel format.
+ *
+ * Images found in the asset bundle are used straight from the bundle's pages.
+ * Other small opaque images are packed into a shared texture atlas in the
+ * requested (screen) format, so many icons can be drawn from the same surface.
+ * Translucent images stay premultiplied ARGB8888 and are never atlased.
+ *
+ * Entries are reference counted. Entries no longer referenced stay cached
+ * and are evicted in least-recently-used order once MEM_CATEGORY_IMAGES
+ * exceeds its budget (images outside the atlas) or the atlas is full
+ * (images inside the atlas).
+ *
+ * The cache is only accessed from the rendering thread, except for imagecache_get_stats().
+ */
+
+// number of hash buckets
+#define IMAGECACHE_BUCKET_COUNT 64
+
+typedef struct image_cache_waiter
+{
+  struct image_cache_waiter *next;
+  ImageLoadedCallback callback;
+  void *callbackData;
+} image_cache_waiter;
+
+typedef struct image_cache_entry
+{
+  struct image_cache_entry *nextInBucket;
+  struct image_cache_entry *lruPrevious; // more recently used
+  struct image_cache_entry *lruNext; // less recently used
+  char *path;
+  int maxWidth;
+  int maxHeight;
+  Uint8 bitsPerPixel;
+  Uint32 rmask,gmask,bmask,amask;
+  int refCount;
+  SDL_Surface *image; // NULL while loading or if loading failed, the atlas surface if inAtlas is set
+  SDL_Rect rect; // area of 'image' that holds the image
+  int inAtlas;
+  int inBundle; // image pixels belong to the asset bundle
+  image_request *request; // pending load or NULL
+  image_cache_waiter *waiters; // acquirers waiting for the image
+} image_cache_entry;
+
+typedef struct image_cache_stats
+{
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  int entryCount;
+  long bytes; // size of all cached images
+  int atlasEntryCount; // number of images packed into the atlas
+} image_cache_stats;
+
+/**
+ * Looks up an image, loading it in the background if it is not cached yet.
+ * The returned entry must be released with imagecache_release().
+ *
+ * @param path image file
+ * @param maxWidth max. width of the image, larger images get downscaled
+ * @param maxHeight max. height of the image
+ * @param format pixel format of the image
+ * @param callback invoked once the image has been loaded if it is not available yet, the image remains 
+ *                 owned by the cache and entry->rect tells which part of it to draw
+ * @param callbackData data passed to the callback, identifies the acquirer
+ * @return entry or NULL on error. If entry->image is set the callback will not be invoked.
+ */
+image_cache_entry *imagecache_acquire(const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format,
+                                      ImageLoadedCallback callback,void *callbackData);
+
+/**
+ * Releases an entry, the callback registered by the acquirer will not be invoked anymore.
+ *
+ * @param entry
+ * @param callbackData data passed to imagecache_acquire()
+ */
+void imagecache_release(image_cache_entry *entry,void *callbackData);
+
+/**
+ * Evicts least recently used images no longer referenced
+ * until at least the given number of bytes has been released.
+ *
+ * @param excessBytes
+ */
+void imagecache_evict(long excessBytes);
+
+/**
+ * Frees all entries, cancelling pending loads. No entry may be referenced anymore.
+ */
+void imagecache_clear(void);
+
+/**
+ * Copies the cache statistics, may be called from any thread.
+ * @param stats
+ */
+void imagecache_get_stats(image_cache_stats *stats);
+
+#endif
@@ -0,0 +1,323 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "imageloader.h"
+#include "render.h"
+#include "SDL/SDL_image.h"
+#include "log.h"
+#include "global.h"
+#include "mempool.h"
+#include "memstats.h"
+#include "mboxstats.h"
+#include "trace.h"
+#include "blend.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef enum { REQUEST_QUEUED, REQUEST_LOADING, REQUEST_DELIVERING } RequestState;
+
+struct image_request
+{
+  struct image_request *next;
+  char *path;
+  int maxWidth;
+  int maxHeight;
+  SDL_PixelFormat *format;
+  ImageLoadedCallback callback;
+  void *callbackData;
+  RequestState state; // guarded by queue_mutex
+  int cancelled; // guarded by queue_mutex
+  SDL_Surface *result;
+};
+
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_condition = PTHREAD_COND_INITIALIZER;
+
+// requests no worker picked up yet in the order they were queued, guarded by queue_mutex
+static image_request *queueFirst = NULL;
+static image_request *queueLast = NULL;
+static int stopping = 0;
+
+static pthread_t workers[IMAGELOADER_WORKER_COUNT];
+static int workerCount = 0;
+
+static slab_pool requestPool = SLAB_POOL_INITIALIZER("image_request",image_request,8);
+
+// intermediate format used for scaling
+#define RGBA_RMASK 0x00ff0000
+#define RGBA_GMASK 0x0000ff00
+#define RGBA_BMASK 0x000000ff
+#define RGBA_AMASK 0xff000000
+
+static void imageloader_free_request(image_request *request)
+{
+  free(request->path);
+  slab_free(&requestPool,request);
+}
+
+SDL_Surface *imageloader_scale(SDL_Surface *source,int maxWidth,int maxHeight)
+{
+  if ( maxWidth <= 0 || maxHeight <= 0 ) {
+    return NULL;
+  }
+  int width = source->w;
+  int height = source->h;
+  if ( width > maxWidth ) {
+    height = (int) ( (long) height * maxWidth / width );
+    width = maxWidth;
+  }
+  if ( height > maxHeight ) {
+    width = (int) ( (long) width * maxHeight / height );
+    height = maxHeight;
+  }
+  width = max(width,1);
+  height = max(height,1);
+
+  SDL_Surface *result = SDL_CreateRGBSurface(SDL_SWSURFACE,width,height,32,RGBA_RMASK,RGBA_GMASK,RGBA_BMASK,RGBA_AMASK);
+  if ( result == NULL ) {
+    return NULL;
+  }
+  SDL_Surface *rgba = SDL_ConvertSurface(source,result->format,SDL_SWSURFACE);
+  if ( rgba ) {
+    // averaging premultiplied colors keeps transparent (mostly black) pixels from darkening edges
+    blend_premultiply(rgba);
+  }
+  if ( rgba == NULL || ( width == rgba->w && height == rgba->h ) ) {
+    SDL_FreeSurface(result);
+    return rgba;
+  }
+
+  // box filter, each target pixel is the average of all source pixels it covers
+  SDL_LockSurface(rgba);
+  SDL_LockSurface(result);
+  for ( int y = 0 ; y < height ; y++ )
+  {
+    int srcY0 = y * rgba->h / height;
+    int srcY1 = max( (y+1) * rgba->h / height, srcY0+1 );
+    Uint32 *dst = (Uint32*) ( (Uint8*) result->pixels + y * result->pitch );
+    for ( int x = 0 ; x < width ; x++ )
+    {
+      int srcX0 = x * rgba->w / width;
+      int srcX1 = max( (x+1) * rgba->w / width, srcX0+1 );
+      Uint32 r = 0, g = 0, b = 0, a = 0;
+      for ( int sy = srcY0 ; sy < srcY1 ; sy++ )
+      {
+        Uint32 *src = (Uint32*) ( (Uint8*) rgba->pixels + sy * rgba->pitch );
+        for ( int sx = srcX0 ; sx < srcX1 ; sx++ )
+        {
+          Uint32 pixel = src[sx];
+          r += (pixel & RGBA_RMASK) >> 16;
+          g += (pixel & RGBA_GMASK) >> 8;
+          b += pixel & RGBA_BMASK;
+          a += (pixel & RGBA_AMASK) >> 24;
+        }
+      }
+      Uint32 count = (srcY1 - srcY0) * (srcX1 - srcX0);
+      dst[x] = ( (a / count) << 24 ) | ( (r / count) << 16 ) | ( (g / count) << 8 ) | ( b / count );
+    }
+  }
+  SDL_UnlockSurface(result);
+  SDL_UnlockSurface(rgba);
+  SDL_FreeSurface(rgba);
+  return result;
+}
+
+SDL_Surface *imageloader_convert(SDL_Surface *image,SDL_PixelFormat *format)
+{
+  // converting to a format without alpha channel would turn transparent edges into boxes,
+  // the image is premultiplied already
+  if ( blend_supports_format(format) && blend_is_translucent(image) ) {
+    return image;
+  }
+  SDL_Surface *result = SDL_ConvertSurface(image,format,SDL_SWSURFACE);
+  SDL_FreeSurface(image);
+  return result;
+}
+
+/**
+ * Loads, scales and converts the image of a request.
+ * @return image or NULL on error
+ */
+static SDL_Surface *imageloader_decode(image_request *request)
+{
+  long traceStart = trace_begin();
+  SDL_Surface *image = IMG_Load(request->path);
+  trace_end("image","decode",traceStart,TRACE_NO_ARG);
+  if ( image == NULL ) {
+    log_error("imageloader_decode(): Unable to load image %s: %s",request->path,IMG_GetError());
+    return NULL;
+  }
+
+  traceStart = trace_begin();
+  SDL_Surface *scaled = imageloader_scale(image,request->maxWidth,request->maxHeight);
+  SDL_FreeSurface(image);
+  if ( scaled == NULL ) {
+    log_error("imageloader_decode(): Unable to scale image %s: %s",request->path,SDL_GetError());
+    return NULL;
+  }
+  SDL_Surface *result = imageloader_convert(scaled,request->format);
+  trace_end("image","scale",traceStart,TRACE_NO_ARG);
+  if ( result == NULL ) {
+    log_error("imageloader_decode(): Unable to convert image %s: %s",request->path,SDL_GetError());
+  }
+  return result;
+}
+
+/**
+ * Hands the result of a request to its callback, invoked on the rendering thread.
+ */
+static void *imageloader_deliver_internal(void *data)
+{
+  image_request *request = data;
+  if ( request->cancelled ) {
+    if ( request->result ) {
+      SDL_FreeSurface(request->result);
+    }
+  } else {
+    if ( request->result ) {
+      memstats_add(MEM_CATEGORY_IMAGES,memstats_surface_size(request->result));
+    }
+    request->callback(request->result,request->callbackData);
+  }
+  imageloader_free_request(request);
+  return NULL;
+}
+
+static void *imageloader_worker(void *data)
+{
+  trace_set_thread_name("image_loader");
+  while ( 1 )
+  {
+    pthread_mutex_lock(&queue_mutex);
+    while ( queueFirst == NULL && ! stopping ) {
+      pthread_cond_wait(&queue_condition,&queue_mutex);
+    }
+    if ( stopping ) {
+      pthread_mutex_unlock(&queue_mutex);
+      break;
+    }
+    image_request *request = queueFirst;
+    queueFirst = request->next;
+    if ( queueFirst == NULL ) {
+      queueLast = NULL;
+    }
+    request->state = REQUEST_LOADING;
+    pthread_mutex_unlock(&queue_mutex);
+
+    request->result = imageloader_decode(request);
+
+    pthread_mutex_lock(&queue_mutex);
+    request->state = REQUEST_DELIVERING;
+    int cancelled = request->cancelled;
+    pthread_mutex_unlock(&queue_mutex);
+
+    if ( cancelled )
+    {
+      if ( request->result ) {
+        SDL_FreeSurface(request->result);
+      }
+      imageloader_free_request(request);
+    } else {
+      render_exec_on_thread(imageloader_deliver_internal,request,0);
+    }
+  }
+  return NULL;
+}
+
+int imageloader_start(void)
+{
+  mboxstats_set_name(imageloader_deliver_internal,"image_loaded");
+
+  stopping = 0;
+  for ( ; workerCount < IMAGELOADER_WORKER_COUNT ; workerCount++ )
+  {
+    if ( pthread_create(&workers[workerCount],NULL,&imageloader_worker,NULL) != 0 ) {
+      log_error("imageloader_start(): Failed to spawn worker thread");
+      imageloader_stop();
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void imageloader_stop(void)
+{
+  pthread_mutex_lock(&queue_mutex);
+  stopping = 1;
+  pthread_cond_broadcast(&queue_condition);
+  pthread_mutex_unlock(&queue_mutex);
+
+  for ( int i = 0 ; i < workerCount ; i++ ) {
+    pthread_join(workers[i],NULL);
+  }
+  workerCount = 0;
+
+  pthread_mutex_lock(&queue_mutex);
+  while ( queueFirst )
+  {
+    image_request *request = queueFirst;
+    queueFirst = request->next;
+    imageloader_free_request(request);
+  }
+  queueLast = NULL;
+  pthread_mutex_unlock(&queue_mutex);
+}
+
+image_request *imageloader_load(const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format,
+                                ImageLoadedCallback callback,void *callbackData)
+{
+  image_request *request = slab_alloc(&requestPool);
+  if ( request == NULL ) {
+    log_error("imageloader_load(): Failed to allocate request");
+    return NULL;
+  }
+  request->path = mem_strdup(path);
+  if ( request->path == NULL ) {
+    slab_free(&requestPool,request);
+    log_error("imageloader_load(): Failed to allocate request");
+    return NULL;
+  }
+  request->maxWidth = maxWidth;
+  request->maxHeight = maxHeight;
+  request->format = format;
+  request->callback = callback;
+  request->callbackData = callbackData;
+  request->state = REQUEST_QUEUED;
+
+  pthread_mutex_lock(&queue_mutex);
+  if ( queueLast ) {
+    queueLast->next = request;
+  } else {
+    queueFirst = request;
+  }
+  queueLast = request;
+  pthread_cond_signal(&queue_condition);
+  pthread_mutex_unlock(&queue_mutex);
+  return request;
+}
+
+void imageloader_cancel(image_request *request)
+{
+  pthread_mutex_lock(&queue_mutex);
+  if ( request->state != REQUEST_QUEUED )
+  {
+    // the worker or the mailbox entry delivering the result frees the request
+    request->cancelled = 1;
+    pthread_mutex_unlock(&queue_mutex);
+    return;
+  }
+  image_request *previous = NULL;
+  for ( image_request *current = queueFirst ; current != request ; current = current->next ) {
+    previous = current;
+  }
+  if ( previous ) {
+    previous->next = request->next;
+  } else {
+    queueFirst = request->next;
+  }
+  if ( queueLast == request ) {
+    queueLast = previous;
+  }
+  pthread_mutex_unlock(&queue_mutex);
+  imageloader_free_request(request);
+}
@@ -0,0 +1,78 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Decodes, downscales and converts images on a pool of worker threads
+ * so the rendering thread only ever needs to blit the result.
+ *
+ * Results are handed to the rendering thread through its mailbox.
+ */
+
+// number of worker threads
+#define IMAGELOADER_WORKER_COUNT 2
+
+// invoked on the rendering thread, takes ownership of the image (NULL if loading failed)
+// void callback(image,callback data)
+typedef void (*ImageLoadedCallback)(SDL_Surface*,void*);
+
+typedef struct image_request image_request;
+
+/**
+ * Starts the worker threads.
+ * @return 0 on error, otherwise success
+ */
+int imageloader_start(void);
+
+/**
+ * Stops all worker threads, discarding requests that have not been started yet.
+ */
+void imageloader_stop(void);
+
+/**
+ * Queues loading an image. Images larger than the target size get
+ * downscaled (keeping their aspect ratio), smaller images are left as they are.
+ *
+ * @param path file to load
+ * @param maxWidth max. width of the result
+ * @param maxHeight max. height of the result
+ * @param format pixel format of the result, must stay valid until the callback got invoked
+ * @param callback callback to invoke on the rendering thread
+ * @param callbackData data passed to the callback
+ * @return request or NULL on error
+ */
+image_request *imageloader_load(const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format,
+                                ImageLoadedCallback callback,void *callbackData);
+
+/**
+ * Cancels a request, its callback will not be invoked.
+ * Must be called on the rendering thread, before the request's callback got invoked.
+ *
+ * @param request
+ */
+void imageloader_cancel(image_request *request);
+
+/**
+ * Downscales an image with a box filter so that it fits into the given size.
+ * Colors get premultiplied with alpha before they are averaged.
+ *
+ * @param source image to scale
+ * @param maxWidth
+ * @param maxHeight
+ * @return 32-bit ARGB image with premultiplied alpha (see blend.h) or NULL on error
+ */
+SDL_Surface *imageloader_scale(SDL_Surface *source,int maxWidth,int maxHeight);
+
+/**
+ * Converts an image returned by imageloader_scale() to the form it gets drawn from:
+ * translucent images stay as they are if they can be blended onto the target format
+ * (see blend.h), all others get converted to the target format.
+ *
+ * @param image premultiplied 32-bit ARGB image, freed unless it is returned
+ * @param format pixel format of the surface the image gets drawn onto
+ * @return image to draw with blend_blit() or NULL on error
+ */
+SDL_Surface *imageloader_convert(SDL_Surface *image,SDL_PixelFormat *format);
+
+#endif
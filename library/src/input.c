@@ -1,8 +1,11 @@
+#define LOG_MODULE LOG_MODULE_INPUT
+
 #include "SDL/SDL.h"
 #include <sys/time.h>
 #include "log.h"
 #include "input.h"
 #include "render.h"
+#include "trace.h"
 
 static int mouseButtonPressed = 0;
 
@@ -20,7 +23,7 @@ int input_poll_touch(TouchEvent *event)
 #ifdef FAKE_TOUCHSCREEN
     SDL_Event test_event;
     if ( ! SDL_PollEvent(&test_event)) {
-      log_debug("no events");
+      log_trace("no events");
       return 0;    
     }
     
@@ -42,7 +45,7 @@ int input_poll_touch(TouchEvent *event)
                 gettimeofday(&event->tv,NULL);
                 event->type = TOUCH_START;
                 
-                printf("MOUSE DOWN - Button %d, Current mouse position is: (%d, %d)\n", test_event.button.button, test_event.button.x, test_event.button.y);             
+                log_debug("MOUSE DOWN - Button %d, Current mouse position is: (%d, %d)", test_event.button.button, test_event.button.x, test_event.button.y);             
                 return 1;
             }
             return 0;
@@ -61,7 +64,7 @@ int input_poll_touch(TouchEvent *event)
               event->type = TOUCH_STOP;    
             
               mouseButtonPressed = 0;
-              printf("MOUSE UP\n");
+              log_debug("MOUSE UP");
               return 1;
             } 
             return 0;
@@ -74,7 +77,7 @@ int input_poll_touch(TouchEvent *event)
               gettimeofday(&event->tv,NULL);                
               event->type = TOUCH_CONTINUE; 
               
-              printf("MOUSE DRAG: (%d, %d)\n", test_event.motion.x, test_event.motion.y);
+              log_debug("MOUSE DRAG: (%d, %d)", test_event.motion.x, test_event.motion.y);
               return 1;
             }        
         default:
@@ -118,6 +121,8 @@ void input_invoke_input_handler(TouchEvent *event) {
   __sync_synchronize();
  InputHandler handler=inputHandler; 
   if ( handler != NULL ) {
+    long traceStart = trace_begin();
     handler(event);    
+    trace_end("input","touch",traceStart,event->type);
   }
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "labelcache.h"
+#include "log.h"
+#include "mempool.h"
+#include "memstats.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LABELCACHE_INITIAL_CAPACITY 32
+
+// guards the list of all caches
+static pthread_mutex_t caches_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static label_cache *allCaches = NULL;
+
+label_cache *labelcache_allocate(void)
+{
+  label_cache *result = mem_calloc(1,sizeof(label_cache));
+  if ( ! result ) {
+    log_error("labelcache_allocate(): Failed to allocate %d bytes",sizeof(label_cache));
+    return NULL;
+  }
+  result->itemCount = LABELCACHE_UNKNOWN_ITEM_COUNT;
+  memstats_add(MEM_CATEGORY_LABEL_CACHE,sizeof(label_cache));
+  
+  pthread_mutex_lock(&caches_mutex);
+  result->next = allCaches;
+  allCaches = result;
+  pthread_mutex_unlock(&caches_mutex);
+  return result;
+}
+
+const char *labelcache_get(label_cache *cache,int index)
+{
+  if ( index < 0 || index >= cache->capacity ) {
+    return NULL;
+  }
+  return cache->labels[index];
+}
+
+/**
+ * Grows the label array so that it has a slot for the given index.
+ * @param cache
+ * @param index
+ * @return 0 on failure, otherwise success
+ */
+static int labelcache_ensure_capacity(label_cache *cache,int index)
+{
+  if ( index < cache->capacity ) {
+    return 1;
+  }
+  int newCapacity = cache->capacity > 0 ? cache->capacity : LABELCACHE_INITIAL_CAPACITY;
+  while ( newCapacity <= index ) {
+    newCapacity *= 2;
+  }
+  char **newLabels = realloc(cache->labels,newCapacity*sizeof(char*));
+  if ( ! newLabels ) {
+    log_error("labelcache_ensure_capacity(): Failed to grow cache to %d entries",newCapacity);
+    return 0;
+  }
+  memset(&newLabels[cache->capacity],0,(newCapacity-cache->capacity)*sizeof(char*));
+  memstats_add(MEM_CATEGORY_LABEL_CACHE,(newCapacity-cache->capacity)*sizeof(char*));
+  cache->labels = newLabels;
+  cache->capacity = newCapacity;
+  return 1;
+}
+
+const char *labelcache_put(label_cache *cache,int index,const char *label)
+{
+  if ( index < 0 || label == NULL || ! labelcache_ensure_capacity(cache,index) ) {
+    return NULL;
+  }
+  char *copy = mem_strdup(label);
+  if ( ! copy ) {
+    log_error("labelcache_put(): strdup() failed");
+    return NULL;
+  }
+  labelcache_invalidate_range(cache,index,1);
+  cache->labels[index] = copy;
+  memstats_add(MEM_CATEGORY_LABEL_CACHE,strlen(copy)+1);
+  return copy;
+}
+
+/**
+ * Discards cached labels.
+ * @return number of bytes released
+ */
+static long labelcache_discard(label_cache *cache,int firstIndex,int count)
+{
+  long released = 0;
+  if ( firstIndex < 0 ) {
+    count += firstIndex;
+    firstIndex = 0;
+  }
+  for ( int i = firstIndex ; count > 0 && i < cache->capacity ; i++,count-- )
+  {
+    if ( cache->labels[i] ) 
+    {
+      released += strlen(cache->labels[i])+1;
+      free(cache->labels[i]);
+      cache->labels[i] = NULL;
+    }
+  }
+  if ( released > 0 ) {
+    memstats_remove(MEM_CATEGORY_LABEL_CACHE,released);
+  }
+  return released;
+}
+
+void labelcache_invalidate_range(label_cache *cache,int firstIndex,int count)
+{
+  labelcache_discard(cache,firstIndex,count);
+}
+
+void labelcache_evict(long excessBytes)
+{
+  long released = 0;
+  
+  pthread_mutex_lock(&caches_mutex);
+  for ( label_cache *cache = allCaches ; cache && released < excessBytes ; cache = cache->next ) {
+    released += labelcache_discard(cache,0,cache->capacity);
+  }
+  pthread_mutex_unlock(&caches_mutex);
+  
+  log_debug("labelcache_evict(): Released %ld bytes",released);
+}
+
+void labelcache_invalidate_all(label_cache *cache)
+{
+  labelcache_invalidate_range(cache,0,cache->capacity);
+  cache->itemCount = LABELCACHE_UNKNOWN_ITEM_COUNT;
+}
+
+void labelcache_set_item_count(label_cache *cache,int itemCount)
+{
+  if ( itemCount != LABELCACHE_UNKNOWN_ITEM_COUNT && itemCount < cache->capacity ) {
+    labelcache_invalidate_range(cache,itemCount,cache->capacity-itemCount);
+  }
+  cache->itemCount = itemCount;
+}
+
+void labelcache_free(label_cache *cache)
+{
+  pthread_mutex_lock(&caches_mutex);
+  label_cache **previous = &allCaches;
+  while ( *previous && *previous != cache ) {
+    previous = &(*previous)->next;
+  }
+  if ( *previous ) {
+    *previous = cache->next;
+  }
+  pthread_mutex_unlock(&caches_mutex);
+  
+  labelcache_invalidate_range(cache,0,cache->capacity);
+  memstats_remove(MEM_CATEGORY_LABEL_CACHE,sizeof(label_cache) + cache->capacity*sizeof(char*));
+  free(cache->labels);
+  free(cache);
+}
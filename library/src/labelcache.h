@@ -0,0 +1,84 @@
+#ifndef LABEL_CACHE_H
+#define LABEL_CACHE_H
+
+/*
+ * Caches the labels of a single list view so that the
+ * label provider callback only gets invoked once per item
+ * until the item is explicitly invalidated.
+ *
+ * Label caches are only ever accessed from the rendering thread.
+ */
+
+#define LABELCACHE_UNKNOWN_ITEM_COUNT -1
+
+typedef struct label_cache
+{
+  struct label_cache *next; // all caches are kept in a list so they can be evicted
+  char **labels; // labels indexed by item index, NULL if not cached yet
+  int capacity; // number of slots in the labels array
+  int itemCount; // number of items or LABELCACHE_UNKNOWN_ITEM_COUNT
+} label_cache;
+
+/**
+ * Allocates an empty label cache.
+ * @return cache or NULL on OOM
+ */
+label_cache *labelcache_allocate(void);
+
+/**
+ * Look up a cached label.
+ * @param cache
+ * @param index item index
+ * @return label or NULL if the item is not cached
+ */
+const char *labelcache_get(label_cache *cache,int index);
+
+/**
+ * Stores a copy of a label, replacing any previously cached one.
+ * @param cache
+ * @param index item index
+ * @param label label to copy
+ * @return cached copy or NULL on failure
+ */
+const char *labelcache_put(label_cache *cache,int index,const char *label);
+
+/**
+ * Discards cached labels.
+ * @param cache
+ * @param firstIndex index of first item to discard
+ * @param count number of items to discard
+ */
+void labelcache_invalidate_range(label_cache *cache,int firstIndex,int count);
+
+/**
+ * Discards all cached labels along with the item count.
+ * @param cache
+ */
+void labelcache_invalidate_all(label_cache *cache);
+
+/**
+ * Updates the number of items, discarding all labels
+ * of items beyond the new count.
+ *
+ * @param cache
+ * @param itemCount new item count or LABELCACHE_UNKNOWN_ITEM_COUNT
+ */
+void labelcache_set_item_count(label_cache *cache,int itemCount);
+
+/**
+ * Discards labels from all label caches until at least the given number
+ * of bytes has been released. Item counts are retained.
+ * 
+ * Must be called on the rendering thread.
+ * 
+ * @param excessBytes number of bytes to release
+ */
+void labelcache_evict(long excessBytes);
+
+/**
+ * Free a label cache and all labels it holds.
+ * @param cache cache to free
+ */
+void labelcache_free(label_cache *cache);
+
+#endif
@@ -0,0 +1,514 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "layout.h"
+#include "render.h"
+#include "ui.h"
+#include "log.h"
+#include "global.h"
+#include "mboxstats.h"
+#include "trace.h"
+#include <stdint.h>
+
+static int layout_is_container(ui_element *element)
+{
+  return element->type == UI_CONTAINER && element->container->layout != LAYOUT_NONE;
+}
+
+/**
+ * Returns whether the size of an element is independent of its content.
+ */
+static int layout_has_fixed_size(ui_element *element)
+{
+  return element->layout.width > 0 && element->layout.height > 0;
+}
+
+/**
+ * Returns the weight of an element, LAYOUT_FILL along the layout direction counts as weight 1.
+ * @param element
+ * @param requested requested size along the layout direction
+ */
+static int layout_get_weight(ui_element *element,int requested)
+{
+  if ( element->layout.weight > 0 ) {
+    return element->layout.weight;
+  }
+  return requested == LAYOUT_FILL ? 1 : 0;
+}
+
+static int layout_get_column_count(ui_element *element)
+{
+  return min(max(element->container->columns,1),LAYOUT_MAX_COLUMNS);
+}
+
+/**
+ * Marks the measured size of an element as outdated and schedules arranging the
+ * containers that are affected, up to the first container with a fixed size.
+ *
+ * @param element
+ * @param arrangeParent whether the parent needs to be arranged even if the element has a fixed size
+ */
+static void layout_propagate(ui_element *element,int arrangeParent)
+{
+  ui_element *top = NULL;
+  if ( layout_is_container(element) ) {
+    element->layout.flags |= LAYOUT_FLAG_ARRANGE;
+    top = element;
+  }
+  ui_element *current = element;
+  current->layout.flags |= LAYOUT_FLAG_MEASURE;
+  int sizeMayChange = arrangeParent || ! layout_has_fixed_size(current);
+  while ( sizeMayChange && current->parent && layout_is_container(current->parent) )
+  {
+    current = current->parent;
+    current->layout.flags |= LAYOUT_FLAG_ARRANGE | LAYOUT_FLAG_MEASURE;
+    top = current;
+    sizeMayChange = ! layout_has_fixed_size(current);
+  }
+  if ( top == NULL ) {
+    return;
+  }
+  // lets layout_run() find the container without visiting the whole scene graph
+  for ( ui_element *ancestor = top->parent ; ancestor && ! (ancestor->layout.flags & LAYOUT_FLAG_DESCENDANT) ; ancestor = ancestor->parent ) {
+    ancestor->layout.flags |= LAYOUT_FLAG_DESCENDANT;
+  }
+}
+
+void layout_request(ui_element *element)
+{
+  layout_propagate(element,0);
+}
+
+void layout_element_attached(ui_element *element)
+{
+  layout_node *node = &element->layout;
+  if ( ! (node->flags & LAYOUT_FLAG_SIZE_SET) )
+  {
+    node->width = element->bounds.w;
+    node->height = element->bounds.h;
+    node->flags |= LAYOUT_FLAG_SIZE_SET;
+  }
+  layout_propagate(element,1);
+}
+
+void layout_element_detached(ui_element *parent)
+{
+  if ( layout_is_container(parent) ) {
+    layout_propagate(parent,0);
+  }
+}
+
+static void layout_measure(ui_element *element);
+
+/**
+ * Determines the widths and weights of the columns of a grid from its children.
+ * @return number of columns that hold children
+ */
+static int layout_get_grid_columns(ui_element *element,int *widths,int *weights)
+{
+  int columns = layout_get_column_count(element);
+  for ( int i = 0 ; i < columns ; i++ ) {
+    widths[i] = weights[i] = 0;
+  }
+  int index = 0;
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling, index++ )
+  {
+    int column = index % columns;
+    widths[column] = max(widths[column],child->layout.measuredWidth);
+    weights[column] = max(weights[column],layout_get_weight(child,child->layout.width));
+  }
+  return min(index,columns);
+}
+
+/**
+ * Returns the height of a row of a grid, the height of its highest child.
+ * @param child first child of the row
+ * @param columns
+ */
+static int layout_get_grid_row_height(ui_element *child,int columns)
+{
+  int height = 0;
+  for ( int i = 0 ; i < columns && child ; i++, child = child->nextSibling ) {
+    height = max(height,child->layout.measuredHeight);
+  }
+  return height;
+}
+
+/**
+ * Measures the space the children of a layout container need, including padding.
+ */
+static void layout_measure_children(ui_element *element,int *width,int *height)
+{
+  container_entry *container = element->container;
+  int count = 0;
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling, count++ ) {
+    layout_measure(child);
+  }
+  if ( container->layout == LAYOUT_GRID )
+  {
+    int widths[LAYOUT_MAX_COLUMNS];
+    int weights[LAYOUT_MAX_COLUMNS];
+    int columns = layout_get_grid_columns(element,widths,weights);
+    for ( int i = 0 ; i < columns ; i++ ) {
+      *width += widths[i];
+    }
+    int rows = 0;
+    ui_element *rowStart = element->firstChild;
+    while ( rowStart )
+    {
+      *height += layout_get_grid_row_height(rowStart,columns);
+      rows++;
+      for ( int i = 0 ; i < columns && rowStart ; i++ ) {
+        rowStart = rowStart->nextSibling;
+      }
+    }
+    *width += max(columns - 1,0) * container->spacing;
+    *height += max(rows - 1,0) * container->spacing;
+  }
+  else
+  {
+    int horizontal = container->layout == LAYOUT_ROW;
+    int length = max(count - 1,0) * container->spacing;
+    int thickness = 0;
+    for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling )
+    {
+      length += horizontal ? child->layout.measuredWidth : child->layout.measuredHeight;
+      thickness = max(thickness,horizontal ? child->layout.measuredHeight : child->layout.measuredWidth);
+    }
+    *width = horizontal ? length : thickness;
+    *height = horizontal ? thickness : length;
+  }
+  *width += 2 * container->padding;
+  *height += 2 * container->padding;
+}
+
+/**
+ * Measures how large the content of an element is.
+ */
+static void layout_measure_content(ui_element *element,int *width,int *height)
+{
+  *width = *height = 0;
+  switch( element->type )
+  {
+    case UI_BUTTON:
+      if ( element->button->text )
+      {
+        if ( render_size_text(element->button->text,width,height) ) {
+          *width += 2 * LAYOUT_BUTTON_PADDING;
+          *height += 2 * LAYOUT_BUTTON_PADDING;
+        }
+      }
+      else if ( element->button->image )
+      {
+        *width = element->button->imageRect.w;
+        *height = element->button->imageRect.h;
+      }
+      break;
+    case UI_LISTVIEW:
+      *height = LISTVIEW_DEFAULT_VISIBLE_ITEMS * LISTVIEW_ITEM_HEIGHT;
+      break;
+    case UI_PROGRESSBAR:
+      *height = LAYOUT_PROGRESSBAR_HEIGHT;
+      break;
+    case UI_CONTAINER:
+      // children of containers without layout don't determine its size
+      if ( layout_is_container(element) ) {
+        layout_measure_children(element,width,height);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Updates the measured size of an element unless it is still valid.
+ */
+static void layout_measure(ui_element *element)
+{
+  layout_node *node = &element->layout;
+  if ( ! (node->flags & LAYOUT_FLAG_MEASURE) ) {
+    return;
+  }
+  int width = 0;
+  int height = 0;
+  if ( ! layout_has_fixed_size(element) ) {
+    layout_measure_content(element,&width,&height);
+  }
+  node->measuredWidth = node->width > 0 ? node->width : width;
+  node->measuredHeight = node->height > 0 ? node->height : height;
+  node->flags &= ~LAYOUT_FLAG_MEASURE;
+}
+
+/**
+ * Moves/resizes an element, invalidating its old and new region if they differ.
+ * @param element
+ * @param x
+ * @param y
+ * @param width
+ * @param height
+ */
+static void layout_place(ui_element *element,int x,int y,int width,int height)
+{
+  if ( element->type == UI_LISTVIEW )
+  {
+    // list views only show whole items
+    element->listview->visibleItemCount = max(height / LISTVIEW_ITEM_HEIGHT,1);
+    height = element->listview->visibleItemCount * LISTVIEW_ITEM_HEIGHT;
+  }
+  SDL_Rect *bounds = &element->bounds;
+  width = max(width,0);
+  height = max(height,0);
+  if ( bounds->x == x && bounds->y == y && bounds->w == width && bounds->h == height ) {
+    return;
+  }
+  int resized = bounds->w != width || bounds->h != height;
+  render_invalidate(element); // region the element is moving away from
+  bounds->x = x;
+  bounds->y = y;
+  bounds->w = width;
+  bounds->h = height;
+  render_invalidate(element);
+
+  if ( resized && layout_is_container(element) ) {
+    element->layout.flags |= LAYOUT_FLAG_ARRANGE;
+  }
+}
+
+/**
+ * Arranges the children of a row or column.
+ * @param element container
+ * @param inner area within the padding
+ * @param horizontal whether this is a row
+ */
+static void layout_arrange_linear(ui_element *element,SDL_Rect *inner,int horizontal)
+{
+  int spacing = element->container->spacing;
+  int available = horizontal ? inner->w : inner->h;
+  int thickness = horizontal ? inner->h : inner->w;
+
+  int used = -spacing;
+  int totalWeight = 0;
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling )
+  {
+    int weight = layout_get_weight(child,horizontal ? child->layout.width : child->layout.height);
+    totalWeight += weight;
+    used += ( weight ? 0 : horizontal ? child->layout.measuredWidth : child->layout.measuredHeight ) + spacing;
+  }
+  int left = max(available - used,0);
+
+  int position = horizontal ? inner->x : inner->y;
+  int weightSoFar = 0;
+  int sharedSoFar = 0;
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling )
+  {
+    layout_node *node = &child->layout;
+    int weight = layout_get_weight(child,horizontal ? node->width : node->height);
+    int length;
+    if ( weight )
+    {
+      // rounding errors don't accumulate so that weighted children always use up all space left
+      weightSoFar += weight;
+      int shared = (int) ( (long) left * weightSoFar / totalWeight );
+      length = shared - sharedSoFar;
+      sharedSoFar = shared;
+    } else {
+      length = horizontal ? node->measuredWidth : node->measuredHeight;
+    }
+    int across = horizontal ? node->height : node->width;
+    int childThickness = across == LAYOUT_FILL ? thickness : horizontal ? node->measuredHeight : node->measuredWidth;
+    if ( horizontal ) {
+      layout_place(child,position,inner->y,length,childThickness);
+    } else {
+      layout_place(child,inner->x,position,childThickness,length);
+    }
+    position += length + spacing;
+  }
+}
+
+/**
+ * Arranges the children of a grid.
+ * @param element container
+ * @param inner area within the padding
+ */
+static void layout_arrange_grid(ui_element *element,SDL_Rect *inner)
+{
+  int spacing = element->container->spacing;
+  int widths[LAYOUT_MAX_COLUMNS];
+  int weights[LAYOUT_MAX_COLUMNS];
+  int columns = layout_get_grid_columns(element,widths,weights);
+
+  int used = -spacing;
+  int totalWeight = 0;
+  for ( int i = 0 ; i < columns ; i++ )
+  {
+    totalWeight += weights[i];
+    used += ( weights[i] ? 0 : widths[i] ) + spacing;
+  }
+  int left = max(inner->w - used,0);
+  int weightSoFar = 0;
+  int sharedSoFar = 0;
+  for ( int i = 0 ; i < columns ; i++ )
+  {
+    if ( weights[i] )
+    {
+      weightSoFar += weights[i];
+      int shared = (int) ( (long) left * weightSoFar / totalWeight );
+      widths[i] = shared - sharedSoFar;
+      sharedSoFar = shared;
+    }
+  }
+
+  int y = inner->y;
+  ui_element *child = element->firstChild;
+  while ( child )
+  {
+    int rowHeight = layout_get_grid_row_height(child,columns);
+    int x = inner->x;
+    for ( int i = 0 ; i < columns && child ; i++, child = child->nextSibling )
+    {
+      // children with a fixed size keep it, all others fill their cell
+      layout_node *node = &child->layout;
+      layout_place(child,x,y,node->width > 0 ? node->width : widths[i],node->height > 0 ? node->height : rowHeight);
+      x += widths[i] + spacing;
+    }
+    y += rowHeight + spacing;
+  }
+}
+
+/**
+ * Assigns the bounds of all children of a layout container.
+ */
+static void layout_arrange(ui_element *element)
+{
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling ) {
+    layout_measure(child);
+  }
+  int padding = element->container->padding;
+  SDL_Rect inner;
+  inner.x = padding;
+  inner.y = padding;
+  inner.w = max(element->bounds.w - 2 * padding,0);
+  inner.h = max(element->bounds.h - 2 * padding,0);
+  switch( element->container->layout )
+  {
+    case LAYOUT_ROW:
+      layout_arrange_linear(element,&inner,1);
+      break;
+    case LAYOUT_COLUMN:
+      layout_arrange_linear(element,&inner,0);
+      break;
+    case LAYOUT_GRID:
+      layout_arrange_grid(element,&inner);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Arranges all containers marked for arranging within a subtree.
+ */
+static void layout_update(ui_element *element)
+{
+  int flags = element->layout.flags;
+  element->layout.flags &= ~(LAYOUT_FLAG_ARRANGE | LAYOUT_FLAG_DESCENDANT);
+  if ( (flags & LAYOUT_FLAG_ARRANGE) && layout_is_container(element) ) {
+    layout_arrange(element);
+  }
+  // arranging marks children that changed their size
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling )
+  {
+    if ( child->layout.flags & (LAYOUT_FLAG_ARRANGE | LAYOUT_FLAG_DESCENDANT) ) {
+      layout_update(child);
+    }
+  }
+}
+
+void layout_run(ui_element *root)
+{
+  if ( ! (root->layout.flags & (LAYOUT_FLAG_ARRANGE | LAYOUT_FLAG_DESCENDANT)) ) {
+    return;
+  }
+  long traceStart = trace_begin();
+  layout_update(root);
+  trace_end("frame","layout",traceStart,TRACE_NO_ARG);
+}
+
+typedef struct layout_set_params_args {
+  ui_element *element;
+  LayoutType type;
+  int padding;
+  int spacing;
+  int columns;
+} layout_set_params_args;
+
+static void *layout_set_params_internal(void *data)
+{
+  layout_set_params_args *args = data;
+  ui_element *element = args->element;
+  container_entry *container = element->container;
+  int hadLayout = layout_is_container(element);
+  container->layout = args->type;
+  container->padding = args->padding;
+  container->spacing = args->spacing;
+  container->columns = args->columns;
+  if ( hadLayout || layout_is_container(element) ) {
+    layout_propagate(element,0);
+  }
+  return (void*) (intptr_t) 1;
+}
+
+int layout_set_params(ui_element *element,LayoutType type,int padding,int spacing,int columns)
+{
+  if ( element->type != UI_CONTAINER ) {
+    log_error("layout_set_params(): Element %d is not a container",element->elementId);
+    return 0;
+  }
+  if ( type < LAYOUT_NONE || type > LAYOUT_GRID || padding < 0 || spacing < 0 ) {
+    log_error("layout_set_params(): Invalid layout %d (padding %d, spacing %d)",type,padding,spacing);
+    return 0;
+  }
+  if ( type == LAYOUT_GRID && ( columns < 1 || columns > LAYOUT_MAX_COLUMNS ) ) {
+    log_error("layout_set_params(): Grids must have 1 to %d columns, got %d",LAYOUT_MAX_COLUMNS,columns);
+    return 0;
+  }
+  layout_set_params_args args = { element, type, padding, spacing, columns };
+  return (int) (intptr_t) render_exec_on_thread(layout_set_params_internal,&args,1);
+}
+
+typedef struct layout_set_size_args {
+  ui_element *element;
+  int width;
+  int height;
+  int weight;
+} layout_set_size_args;
+
+static void *layout_set_size_internal(void *data)
+{
+  layout_set_size_args *args = data;
+  layout_node *node = &args->element->layout;
+  node->width = args->width;
+  node->height = args->height;
+  node->weight = args->weight;
+  node->flags |= LAYOUT_FLAG_SIZE_SET;
+  if ( args->element->parent ) {
+    layout_propagate(args->element,1);
+  }
+  return (void*) (intptr_t) 1;
+}
+
+int layout_set_size(ui_element *element,int width,int height,int weight)
+{
+  if ( width < LAYOUT_FILL || height < LAYOUT_FILL || weight < 0 ) {
+    log_error("layout_set_size(): Invalid size %dx%d (weight %d) for element %d",width,height,weight,element->elementId);
+    return 0;
+  }
+  layout_set_size_args args = { element, width, height, weight };
+  return (int) (intptr_t) render_exec_on_thread(layout_set_size_internal,&args,1);
+}
+
+void layout_init(void)
+{
+  mboxstats_set_name(layout_set_params_internal,"layout_set_params");
+  mboxstats_set_name(layout_set_size_internal,"layout_set_size");
+}
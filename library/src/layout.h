@@ -0,0 +1,105 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "ui_types.h"
+
+/*
+ * Positions the children of containers that have a layout (rows, columns or grids).
+ *
+ * Layout runs in two passes at the end of each frame, before damaged regions get repainted:
+ * the measure pass determines how large each element wants to be, the arrange pass
+ * assigns the bounds of the children of a container. Measured sizes are cached per
+ * element, changing an element only measures that element again and arranges the
+ * containers whose size depends on it. A container with a fixed size stops the
+ * propagation, so a label change only relayouts its own container.
+ *
+ * Elements in a layout container keep their x/y/w/h as given until the next frame.
+ * Their width and height when they were attached become their requested size
+ * unless it was set with layout_set_size() before.
+ * Children are laid out in painting order (see render_set_z_order()).
+ *
+ * Row/column: children get their measured size along the layout direction, the space
+ * that is left gets shared among children with a weight (or LAYOUT_FILL) in proportion
+ * to their weight. Across the layout direction children get their measured size,
+ * LAYOUT_FILL stretches them to the container.
+ *
+ * Grid: children fill the cells row by row. A column is as wide as its widest child,
+ * the space that is left gets shared among columns in proportion to the largest weight
+ * of their children. A row is as high as its highest child. Children are stretched
+ * to their cell unless they have a fixed size.
+ *
+ * All functions must be called on the rendering thread unless marked otherwise.
+ */
+
+// padding around the text of a button measured with LAYOUT_WRAP_CONTENT
+#define LAYOUT_BUTTON_PADDING 6
+
+// height of a progress bar measured with LAYOUT_WRAP_CONTENT
+#define LAYOUT_PROGRESSBAR_HEIGHT 10
+
+// max. number of columns of a grid
+#define LAYOUT_MAX_COLUMNS 16
+
+#define LAYOUT_FLAG_SIZE_SET (1<<0) // requested size has been set
+#define LAYOUT_FLAG_MEASURE (1<<1) // measured size is outdated
+#define LAYOUT_FLAG_ARRANGE (1<<2) // children of the container need to be arranged
+#define LAYOUT_FLAG_DESCENDANT (1<<3) // some descendant needs to be arranged
+
+/**
+ * Registers the names of the mailbox callbacks of this module.
+ */
+void layout_init(void);
+
+/**
+ * Changes the layout of a container. May be called from any thread.
+ *
+ * @param element container
+ * @param type layout type, LAYOUT_NONE leaves the children where they are
+ * @param padding space between the container's edges and its children
+ * @param spacing space between adjacent children
+ * @param columns number of columns (grids only)
+ * @return 0 on error, otherwise success
+ */
+int layout_set_params(ui_element *element,LayoutType type,int padding,int spacing,int columns);
+
+/**
+ * Changes the size an element requests from its layout container. May be called from any thread.
+ *
+ * @param element
+ * @param width LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels
+ * @param height LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels
+ * @param weight share of the space left along the layout direction, 0 for none
+ * @return 0 on error, otherwise success
+ */
+int layout_set_size(ui_element *element,int width,int height,int weight);
+
+/**
+ * Must be invoked after an element has been attached to the scene graph.
+ * @param element
+ */
+void layout_element_attached(ui_element *element);
+
+/**
+ * Must be invoked after an element has been removed from a container.
+ * @param parent the container
+ */
+void layout_element_detached(ui_element *parent);
+
+/**
+ * Marks the measured size of an element as outdated, to be invoked
+ * when the content (text, image, ...) of the element changed.
+ * The affected containers get arranged at the end of the frame.
+ *
+ * @param element
+ */
+void layout_request(ui_element *element);
+
+/**
+ * Measures and arranges all elements marked by layout_request(), invalidating
+ * elements whose bounds changed.
+ *
+ * @param root root of the scene graph
+ */
+void layout_run(ui_element *root);
+
+#endif
@@ -1,52 +1,531 @@
 #include "log.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include "global.h"
 
-static enum LogLevel level = INFO;
+volatile enum LogLevel log_module_levels[LOG_MODULE_COUNT] = { INFO, INFO, INFO, INFO };
 
-void log_all(const char*level,char *msg,va_list ap) 
+static const char *levelNames[] = { "ERROR", "WARN", "INFO", "DEBUG", "TRACE" };
+
+/*
+ * Log messages are not formatted by the calling thread. Instead,
+ * the format string pointer and a copy of all arguments get stored
+ * in a lock-free ring buffer that is drained by a background thread
+ * which does the actual formatting and I/O.
+ *
+ * Format strings therefore MUST be string literals (or otherwise outlive
+ * the log call), string arguments are copied.
+ */
+
+// number of records in ring buffer, must be a power of 2
+#define LOG_RING_SIZE 512
+
+// max. number of arguments a single log message may have
+#define LOG_MAX_ARGS 8
+
+// space for copies of string arguments
+#define LOG_STRING_BUFFER_SIZE 160
+
+// how long the writer thread sleeps when there is nothing to do
+#define LOG_WRITER_IDLE_MICROS 2000
+
+#define LOG_MAX_MESSAGE_SIZE 1024
+
+typedef enum { ARG_NONE, ARG_INT, ARG_LONG, ARG_LONGLONG, ARG_SIZE, ARG_PTRDIFF, ARG_DOUBLE, ARG_LONGDOUBLE, ARG_STRING, ARG_POINTER, ARG_COUNT, ARG_PERCENT, ARG_INVALID } log_arg_type;
+
+typedef union log_arg
+{
+  long long i;
+  double d;
+  void *p;
+  int stringOffset; // offset into log_record#strings
+} log_arg;
+
+typedef struct log_record
+{
+  volatile unsigned long sequence;
+  const char *levelName; // NULL if the message got written synchronously, the record is just skipped
+  const char *format; // NULL if message was already formatted into 'strings'
+  log_arg args[LOG_MAX_ARGS];
+  char strings[LOG_STRING_BUFFER_SIZE];
+} log_record;
+
+/*
+ * A single conversion specification from a format string.
+ */
+typedef struct log_spec
+{
+  const char *start; // points to '%'
+  int length; // length including the conversion character
+  log_arg_type type;
+  int widthFromArg; // width is '*'
+  int precisionFromArg; // precision is '*'
+} log_spec;
+
+static log_record ring[LOG_RING_SIZE];
+
+static volatile unsigned long enqueuePos = 0;
+static volatile unsigned long dequeuePos = 0;
+static volatile unsigned long droppedMessages = 0;
+
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static pthread_t writerThread;
+static volatile int writerRunning = 0;
+static volatile int writerTerminate = 0;
+// threads inside log_all() that may still claim and publish a record
+static volatile int activeLoggers = 0;
+
+/**
+ * Finds the next conversion specification in a format string.
+ *
+ * @param format format string
+ * @param spec spec to fill in
+ * @return 0 if there are no more conversion specifications
+ */
+static int log_next_spec(const char *format,log_spec *spec)
+{
+  const char *ptr = strchr(format,'%');
+  if ( ptr == NULL ) {
+    return 0;
+  }
+  spec->start = ptr++;
+  spec->widthFromArg = 0;
+  spec->precisionFromArg = 0;
+
+  while ( *ptr && strchr("-+ #0'",*ptr) ) {
+    ptr++;
+  }
+  if ( *ptr == '*' ) {
+    spec->widthFromArg = 1;
+    ptr++;
+  }
+  while ( *ptr >= '0' && *ptr <= '9' ) {
+    ptr++;
+  }
+  if ( *ptr == '.' )
+  {
+    ptr++;
+    if ( *ptr == '*' ) {
+      spec->precisionFromArg = 1;
+      ptr++;
+    }
+    while ( *ptr >= '0' && *ptr <= '9' ) {
+      ptr++;
+    }
+  }
+
+  log_arg_type intType = ARG_INT;
+  int longDouble = 0;
+  switch( *ptr )
+  {
+    case 'h':
+      ptr += ( ptr[1] == 'h' ) ? 2 : 1;
+      break;
+    case 'l':
+      if ( ptr[1] == 'l' ) {
+        intType = ARG_LONGLONG;
+        ptr += 2;
+      } else {
+        intType = ARG_LONG;
+        ptr++;
+      }
+      break;
+    case 'q':
+    case 'j':
+      intType = ARG_LONGLONG;
+      ptr++;
+      break;
+    case 'z':
+      intType = ARG_SIZE;
+      ptr++;
+      break;
+    case 't':
+      intType = ARG_PTRDIFF;
+      ptr++;
+      break;
+    case 'L':
+      longDouble = 1;
+      ptr++;
+      break;
+  }
+
+  switch( *ptr )
+  {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+      spec->type = intType;
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      spec->type = longDouble ? ARG_LONGDOUBLE : ARG_DOUBLE;
+      break;
+    case 's':
+      spec->type = ARG_STRING;
+      break;
+    case 'p':
+      spec->type = ARG_POINTER;
+      break;
+    case 'n':
+      spec->type = ARG_COUNT;
+      break;
+    case '%':
+      spec->type = ARG_PERCENT;
+      break;
+    default:
+      spec->type = ARG_INVALID;
+      return 1;
+  }
+  spec->length = (int) (ptr - spec->start) + 1;
+  return 1;
+}
+
+/**
+ * Copies all arguments of a log message into a ring record.
+ *
+ * @return 0 if the message cannot be captured (too many/unsupported arguments or strings too long)
+ */
+static int log_capture_args(log_record *record,const char *format,va_list ap)
+{
+  log_spec spec;
+  int argCount = 0;
+  int stringsUsed = 0;
+
+  while ( log_next_spec(format,&spec) )
+  {
+    if ( spec.type == ARG_INVALID ) {
+      return 0;
+    }
+    format = spec.start + spec.length;
+    if ( spec.type == ARG_PERCENT ) {
+      continue;
+    }
+
+    int needed = 1 + spec.widthFromArg + spec.precisionFromArg;
+    if ( argCount + needed > LOG_MAX_ARGS ) {
+      return 0;
+    }
+    if ( spec.widthFromArg ) {
+      record->args[argCount++].i = va_arg(ap,int);
+    }
+    if ( spec.precisionFromArg ) {
+      record->args[argCount++].i = va_arg(ap,int);
+    }
+
+    log_arg *arg = &record->args[argCount++];
+    switch( spec.type )
+    {
+      case ARG_INT:        arg->i = va_arg(ap,int); break;
+      case ARG_LONG:       arg->i = va_arg(ap,long); break;
+      case ARG_LONGLONG:   arg->i = va_arg(ap,long long); break;
+      case ARG_SIZE:       arg->i = va_arg(ap,size_t); break;
+      case ARG_PTRDIFF:    arg->i = va_arg(ap,ptrdiff_t); break;
+      case ARG_DOUBLE:     arg->d = va_arg(ap,double); break;
+      case ARG_LONGDOUBLE: arg->d = (double) va_arg(ap,long double); break;
+      case ARG_POINTER:    arg->p = va_arg(ap,void*); break;
+      case ARG_COUNT:      (void) va_arg(ap,void*); break;
+      case ARG_STRING:
+      {
+        const char *string = va_arg(ap,const char*);
+        if ( string == NULL ) {
+          string = "(null)";
+        }
+        int len = strlen(string)+1;
+        if ( stringsUsed + len > LOG_STRING_BUFFER_SIZE ) {
+          return 0;
+        }
+        memcpy(&record->strings[stringsUsed],string,len);
+        arg->stringOffset = stringsUsed;
+        stringsUsed += len;
+        break;
+      }
+      default:
+        return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Formats a captured log message. Conversion specifications
+ * get formatted one at a time using the captured arguments.
+ *
+ * @return message length
+ */
+static int log_format_record(log_record *record,char *buffer,int bufferSize)
+{
+  int len = snprintf(buffer,bufferSize,"%s: ",record->levelName);
+
+  if ( record->format == NULL ) {
+    return len + snprintf(&buffer[len],bufferSize-len,"%s",record->strings);
+  }
+
+  const char *format = record->format;
+  int argIdx = 0;
+  log_spec spec;
+  char specBuffer[32];
+
+  while ( len < bufferSize-1 && log_next_spec(format,&spec) )
+  {
+    // copy literal text preceding the spec
+    int literalLen = min((int) (spec.start - format), bufferSize-1-len);
+    memcpy(&buffer[len],format,literalLen);
+    len += literalLen;
+    format = spec.start + spec.length;
+
+    if ( spec.type == ARG_PERCENT ) {
+      len += snprintf(&buffer[len],bufferSize-len,"%%");
+      continue;
+    }
+    if ( spec.type == ARG_COUNT ) {
+      argIdx++;
+      continue;
+    }
+
+    // resolve '*' width/precision by substituting the captured values
+    int specLen = 0;
+    for ( const char *ptr = spec.start ; ptr < format && specLen < (int) sizeof(specBuffer)-12 ; ptr++ )
+    {
+      if ( *ptr == '*' ) {
+        specLen += snprintf(&specBuffer[specLen],sizeof(specBuffer)-specLen,"%d",(int) record->args[argIdx++].i);
+      } else {
+        specBuffer[specLen++] = *ptr;
+      }
+    }
+    specBuffer[specLen] = 0;
+
+    log_arg *arg = &record->args[argIdx++];
+    int remaining = bufferSize-len;
+    int written = 0;
+    switch( spec.type )
+    {
+      case ARG_INT:        written = snprintf(&buffer[len],remaining,specBuffer,(int) arg->i); break;
+      case ARG_LONG:       written = snprintf(&buffer[len],remaining,specBuffer,(long) arg->i); break;
+      case ARG_LONGLONG:   written = snprintf(&buffer[len],remaining,specBuffer,arg->i); break;
+      case ARG_SIZE:       written = snprintf(&buffer[len],remaining,specBuffer,(size_t) arg->i); break;
+      case ARG_PTRDIFF:    written = snprintf(&buffer[len],remaining,specBuffer,(ptrdiff_t) arg->i); break;
+      case ARG_DOUBLE:     written = snprintf(&buffer[len],remaining,specBuffer,arg->d); break;
+      case ARG_LONGDOUBLE: written = snprintf(&buffer[len],remaining,specBuffer,(long double) arg->d); break;
+      case ARG_POINTER:    written = snprintf(&buffer[len],remaining,specBuffer,arg->p); break;
+      case ARG_STRING:     written = snprintf(&buffer[len],remaining,specBuffer,&record->strings[arg->stringOffset]); break;
+      default:
+        break;
+    }
+    len += min(written,remaining-1);
+  }
+  if ( len < bufferSize-1 ) {
+    len += snprintf(&buffer[len],bufferSize-len,"%s",format);
+  }
+  return min(len,bufferSize-1);
+}
+
+/**
+ * Removes the oldest record from the ring and writes it.
+ * Must only be called by a single thread at a time.
+ *
+ * @return 0 if the ring was empty
+ */
+static int log_write_next_record(void)
 {
-    char buffer[1024];
-    
-    buffer[0]=0;
-    int len = snprintf(&buffer[0],1024,"%s: ",level);    
-    vsnprintf(&buffer[len], sizeof(buffer)-len-1, msg, ap);
-    printf("%s\n",&buffer[0]);
+  char buffer[LOG_MAX_MESSAGE_SIZE];
+
+  unsigned long pos = dequeuePos;
+  log_record *record = &ring[pos & (LOG_RING_SIZE-1)];
+  if ( __atomic_load_n(&record->sequence,__ATOMIC_ACQUIRE) != pos+1 ) {
+    return 0;
+  }
+
+  if ( record->levelName )
+  {
+    int len = log_format_record(record,buffer,sizeof(buffer)-1);
+    buffer[len++] = '\n';
+    fwrite(buffer,1,len,stdout);
+  }
+
+  __atomic_store_n(&record->sequence,pos + LOG_RING_SIZE,__ATOMIC_RELEASE);
+  dequeuePos = pos+1;
+  return 1;
 }
 
-void log_info(char *msg,...) 
+static void *log_writer_main(void *data)
 {
-    if ( level >= INFO ) {
-        va_list ap;
-        va_start(ap, msg); 
-        log_all("INFO",msg,ap);
-        va_end(ap);
+  unsigned long reportedDrops = 0;
+
+  while ( 1 )
+  {
+    int written = 0;
+    while ( log_write_next_record() ) {
+      written++;
+    }
+
+    unsigned long drops = __atomic_load_n(&droppedMessages,__ATOMIC_RELAXED);
+    if ( drops != reportedDrops ) {
+      printf("WARN: %lu log messages dropped (ring buffer full)\n",drops-reportedDrops);
+      reportedDrops = drops;
+      written++;
+    }
+    if ( written ) {
+      fflush(stdout);
+    } else if ( __atomic_load_n(&writerTerminate,__ATOMIC_ACQUIRE) 
+                && dequeuePos == __atomic_load_n(&enqueuePos,__ATOMIC_ACQUIRE) ) {
+      // all records claimed before log_close() have been published and written
+      break;
+    } else {
+      usleep(LOG_WRITER_IDLE_MICROS);
     }
+  }
+  return NULL;
+}
+
+static void log_init(void)
+{
+  for ( int i = 0 ; i < LOG_RING_SIZE ; i++ ) {
+    ring[i].sequence = i;
+  }
+  __sync_synchronize();
+  if ( pthread_create(&writerThread,NULL,&log_writer_main,NULL) == 0 ) {
+    __atomic_store_n(&writerRunning,1,__ATOMIC_RELEASE);
+  } else {
+    printf("ERROR: Failed to start log writer thread, logging synchronously\n");
+  }
 }
 
-void log_debug(char *msg,...) {
-    if ( level >= DEBUG ) {
-        va_list ap;
-        va_start(ap, msg); 
-        log_all("DEBUG",msg,ap);
-        va_end(ap);
+/**
+ * Claims a free record from the ring.
+ *
+ * @return record or NULL if the ring is full
+ */
+static log_record *log_claim_record(unsigned long *posOut)
+{
+  unsigned long pos = __atomic_load_n(&enqueuePos,__ATOMIC_RELAXED);
+  while ( 1 )
+  {
+    log_record *record = &ring[pos & (LOG_RING_SIZE-1)];
+    long diff = (long) __atomic_load_n(&record->sequence,__ATOMIC_ACQUIRE) - (long) pos;
+    if ( diff == 0 )
+    {
+      unsigned long previous = __sync_val_compare_and_swap(&enqueuePos,pos,pos+1);
+      if ( previous == pos ) {
+        *posOut = pos;
+        return record;
+      }
+      pos = previous;
     }
+    else if ( diff < 0 ) {
+      return NULL;
+    } else {
+      pos = __atomic_load_n(&enqueuePos,__ATOMIC_RELAXED);
+    }
+  }
+}
+
+static void log_write_sync(const char *levelName,const char *msg,va_list ap)
+{
+  char buffer[LOG_MAX_MESSAGE_SIZE];
+
+  buffer[0]=0;
+  int len = snprintf(&buffer[0],sizeof(buffer),"%s: ",levelName);
+  vsnprintf(&buffer[len], sizeof(buffer)-len-1, msg, ap);
+  printf("%s\n",&buffer[0]);
 }
 
-void log_warn(char *msg,...) {
-    if ( level >= WARN ) {
-        va_list ap;
-        va_start(ap, msg); 
-        log_all("WARN",msg,ap);
-        va_end(ap);    
+void log_all(const char *levelName,char *msg,va_list ap)
+{
+  pthread_once(&initOnce,&log_init);
+
+  // log_close() waits for this thread to leave before the writer stops
+  __atomic_fetch_add(&activeLoggers,1,__ATOMIC_SEQ_CST);
+  if ( ! __atomic_load_n(&writerRunning,__ATOMIC_SEQ_CST) ) {
+    __atomic_fetch_sub(&activeLoggers,1,__ATOMIC_RELEASE);
+    log_write_sync(levelName,msg,ap);
+    return;
+  }
+
+  unsigned long pos;
+  log_record *record = log_claim_record(&pos);
+  if ( record == NULL ) {
+    __sync_fetch_and_add(&droppedMessages,1);
+    __atomic_fetch_sub(&activeLoggers,1,__ATOMIC_RELEASE);
+    return;
+  }
+
+  record->levelName = levelName;
+  record->format = msg;
+
+  va_list copy;
+  va_copy(copy,ap);
+  int captured = log_capture_args(record,msg,copy);
+  va_end(copy);
+  int fits = 1;
+  if ( ! captured )
+  {
+    // can't defer formatting of this one, format it right away
+    record->format = NULL;
+    va_copy(copy,ap);
+    fits = vsnprintf(record->strings,sizeof(record->strings),msg,copy) < (int) sizeof(record->strings);
+    va_end(copy);
+    if ( ! fits ) {
+      record->levelName = NULL;
     }
+  }
+
+  __atomic_store_n(&record->sequence,pos+1,__ATOMIC_RELEASE);
+  __atomic_fetch_sub(&activeLoggers,1,__ATOMIC_RELEASE);
+
+  if ( ! fits ) {
+    // too long for the record, the synchronous path allows LOG_MAX_MESSAGE_SIZE bytes
+    log_write_sync(levelName,msg,ap);
+  }
 }
 
-void log_error(char *msg,...) {
-    if ( level >= ERROR ) {    
-        va_list ap;
-        va_start(ap, msg); 
-        log_all("ERROR",msg,ap);
-        va_end(ap);    
+unsigned long log_get_dropped_count(void)
+{
+  return __atomic_load_n(&droppedMessages,__ATOMIC_RELAXED);
+}
+
+void log_close(void)
+{
+  pthread_once(&initOnce,&log_init);
+  if ( __atomic_load_n(&writerRunning,__ATOMIC_ACQUIRE) )
+  {
+    __atomic_store_n(&writerRunning,0,__ATOMIC_SEQ_CST);
+    // threads that saw the writer running may still be claiming records
+    while ( __atomic_load_n(&activeLoggers,__ATOMIC_SEQ_CST) ) {
+      sched_yield();
+    }
+    __atomic_store_n(&writerTerminate,1,__ATOMIC_RELEASE);
+    pthread_join(writerThread,NULL);
+
+    // drain messages that got enqueued while we were shutting down
+    while ( log_write_next_record() ) {
     }
+    fflush(stdout);
+  }
+}
+
+void log_write(enum LogModule module,enum LogLevel level,char *msg,...) 
+{
+  va_list ap;
+  va_start(ap, msg); 
+  log_all(levelNames[level],msg,ap);
+  va_end(ap);
+}
+
+int log_set_level(enum LogModule module,enum LogLevel level) 
+{
+  if ( module < 0 || module >= LOG_MODULE_COUNT || level < ERROR || level > TRACE ) {
+    return 0;
+  }
+  log_module_levels[module] = level;
+  return 1;
+}
+
+int log_get_level(enum LogModule module) 
+{
+  if ( module < 0 || module >= LOG_MODULE_COUNT ) {
+    return -1;
+  }
+  return log_module_levels[module];
 }
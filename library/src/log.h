@@ -3,9 +3,78 @@
 
 enum LogLevel { ERROR=0,WARN=1,INFO=2,DEBUG=3,TRACE=4 };
 
-void log_info(char *msg,...);
-void log_debug(char *msg,...);
-void log_warn(char *msg,...);
-void log_error(char *msg,...);
+/*
+ * Each source file logs on behalf of one module, the
+ * log level of each module can be changed at runtime.
+ *
+ * Define LOG_MODULE before including any header in a
+ * source file to select its module, files that don't
+ * do so log as LOG_MODULE_UI.
+ */
+enum LogModule { LOG_MODULE_RENDER=0,LOG_MODULE_INPUT=1,LOG_MODULE_UI=2,LOG_MODULE_PYTHON=3 };
+
+#define LOG_MODULE_COUNT 4
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_UI
+#endif
+
+/*
+ * Log calls above this level are removed at compile time,
+ * their arguments are never evaluated.
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL TRACE
+#endif
+
+// current runtime level of each module, use log_set_level() to change
+extern volatile enum LogLevel log_module_levels[LOG_MODULE_COUNT];
+
+#define log_enabled(lvl) ( (lvl) <= LOG_COMPILE_LEVEL && (lvl) <= log_module_levels[LOG_MODULE] )
+
+#define log_at_level(lvl,...) do { if ( log_enabled(lvl) ) { log_write(LOG_MODULE,lvl,__VA_ARGS__); } } while(0)
+
+#define log_error(...) log_at_level(ERROR,__VA_ARGS__)
+#define log_warn(...)  log_at_level(WARN,__VA_ARGS__)
+#define log_info(...)  log_at_level(INFO,__VA_ARGS__)
+#define log_debug(...) log_at_level(DEBUG,__VA_ARGS__)
+#define log_trace(...) log_at_level(TRACE,__VA_ARGS__)
+
+/**
+ * Writes a log message, regardless of the current log level.
+ * Use the log_xxx() macros instead of invoking this function directly.
+ *
+ * @param module module the message originates from
+ * @param level message level
+ * @param msg printf()-style format string, MUST outlive the call (string literal)
+ */
+void log_write(enum LogModule module,enum LogLevel level,char *msg,...);
+
+/**
+ * Sets the runtime log level of a module.
+ * @param module
+ * @param level
+ * @return 0 if module or level are out of range, otherwise success
+ */
+int log_set_level(enum LogModule module,enum LogLevel level);
+
+/**
+ * Returns the runtime log level of a module.
+ * @param module
+ * @return level or -1 if module is out of range
+ */
+int log_get_level(enum LogModule module);
+
+/**
+ * Returns the number of log messages that got discarded
+ * because the log ring buffer was full.
+ */
+unsigned long log_get_dropped_count(void);
+
+/**
+ * Writes all pending log messages and stops the background writer thread.
+ * Messages logged afterwards are written synchronously.
+ */
+void log_close(void);
 
 #endif
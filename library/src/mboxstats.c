@@ -0,0 +1,160 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "mboxstats.h"
+#include "log.h"
+#include <pthread.h>
+#include <string.h>
+
+#define MBOXSTATS_MAX_NAMES 32
+
+typedef struct mbox_callback_name
+{
+  void *func;
+  const char *name;
+} mbox_callback_name;
+
+// guards stats and names
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static mbox_stats stats = { 0, 0, 0, MBOXSTATS_DEFAULT_SLOW_THRESHOLD_MICROS };
+
+static mbox_callback_name names[MBOXSTATS_MAX_NAMES];
+static int nameCount = 0;
+
+static const char *mboxstats_lookup_name(void *func)
+{
+  for ( int i = 0 ; i < nameCount ; i++ ) {
+    if ( names[i].func == func ) {
+      return names[i].name;
+    }
+  }
+  return NULL;
+}
+
+void mboxstats_set_name(void *func,const char *name)
+{
+  pthread_mutex_lock(&stats_mutex);
+  if ( mboxstats_lookup_name(func) == NULL )
+  {
+    if ( nameCount < MBOXSTATS_MAX_NAMES ) {
+      names[nameCount].func = func;
+      names[nameCount].name = name;
+      nameCount++;
+    } else {
+      log_warn("mboxstats_set_name(): Too many names, ignoring '%s'",name);
+    }
+  }
+  pthread_mutex_unlock(&stats_mutex);
+}
+
+const char *mboxstats_get_name(void *func)
+{
+  pthread_mutex_lock(&stats_mutex);
+  const char *result = mboxstats_lookup_name(func);
+  pthread_mutex_unlock(&stats_mutex);
+  return result;
+}
+
+void mboxstats_record_depth(int depth)
+{
+  pthread_mutex_lock(&stats_mutex);
+  if ( depth > stats.highWaterMark ) {
+    stats.highWaterMark = depth;
+  }
+  pthread_mutex_unlock(&stats_mutex);
+}
+
+static int mboxstats_bucket(long micros)
+{
+  int bucket = 0;
+  while ( bucket < MBOXSTATS_BUCKETS-1 && micros >= (1L << (bucket+MBOXSTATS_FIRST_BUCKET_SHIFT)) ) {
+    bucket++;
+  }
+  return bucket;
+}
+
+long mboxstats_bucket_limit(int bucket)
+{
+  if ( bucket >= MBOXSTATS_BUCKETS-1 ) {
+    return -1;
+  }
+  return 1L << (bucket+MBOXSTATS_FIRST_BUCKET_SHIFT);
+}
+
+void mboxstats_record_execution(void *func,long waitMicros,long execMicros)
+{
+  pthread_mutex_lock(&stats_mutex);
+
+  stats.processed++;
+
+  int i;
+  for ( i = 0 ; i < stats.callbackCount && stats.callbacks[i].func != func ; i++ ) {
+  }
+  mbox_callback_stats *entry = NULL;
+  if ( i < stats.callbackCount ) {
+    entry = &stats.callbacks[i];
+  }
+  else if ( stats.callbackCount < MBOXSTATS_MAX_CALLBACKS )
+  {
+    entry = &stats.callbacks[stats.callbackCount++];
+    entry->func = func;
+    entry->name = mboxstats_lookup_name(func);
+  }
+
+  int slow = stats.slowThresholdMicros > 0 && execMicros > stats.slowThresholdMicros;
+  const char *name = entry ? entry->name : NULL;
+  if ( entry )
+  {
+    entry->count++;
+    entry->totalWaitMicros += waitMicros;
+    entry->totalExecMicros += execMicros;
+    if ( waitMicros > entry->maxWaitMicros ) {
+      entry->maxWaitMicros = waitMicros;
+    }
+    if ( execMicros > entry->maxExecMicros ) {
+      entry->maxExecMicros = execMicros;
+    }
+    entry->waitHistogram[ mboxstats_bucket(waitMicros) ]++;
+    entry->execHistogram[ mboxstats_bucket(execMicros) ]++;
+    if ( slow ) {
+      entry->slowCount++;
+    }
+  } else {
+    stats.untracked++;
+  }
+  long threshold = stats.slowThresholdMicros;
+
+  pthread_mutex_unlock(&stats_mutex);
+
+  if ( slow )
+  {
+    if ( name ) {
+      log_warn("Slow mailbox callback %s: took %ld us (threshold: %ld us, waited %ld us)",name,execMicros,threshold,waitMicros);
+    } else {
+      log_warn("Slow mailbox callback %p: took %ld us (threshold: %ld us, waited %ld us)",func,execMicros,threshold,waitMicros);
+    }
+  }
+}
+
+void mboxstats_set_slow_threshold(long micros)
+{
+  pthread_mutex_lock(&stats_mutex);
+  stats.slowThresholdMicros = micros;
+  pthread_mutex_unlock(&stats_mutex);
+}
+
+void mboxstats_get(mbox_stats *result)
+{
+  pthread_mutex_lock(&stats_mutex);
+  *result = stats;
+  pthread_mutex_unlock(&stats_mutex);
+}
+
+void mboxstats_reset(void)
+{
+  pthread_mutex_lock(&stats_mutex);
+  long threshold = stats.slowThresholdMicros;
+  memset(&stats,0,sizeof(stats));
+  stats.slowThresholdMicros = threshold;
+  pthread_mutex_unlock(&stats_mutex);
+}
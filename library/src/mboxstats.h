@@ -0,0 +1,103 @@
+#ifndef MBOXSTATS_H
+#define MBOXSTATS_H
+
+/*
+ * Statistics about callbacks that were executed through the
+ * rendering thread's mailbox (see render_exec_on_thread()).
+ *
+ * For each distinct callback function the time entries spent waiting
+ * in the mailbox (enqueue until start of execution) and the time the callback
+ * took to execute are tracked as histograms.
+ */
+
+// max. number of distinct callback functions tracked
+#define MBOXSTATS_MAX_CALLBACKS 32
+
+// Histogram bucket N counts samples < 2^(N+MBOXSTATS_FIRST_BUCKET_SHIFT) microseconds,
+// the last bucket counts all samples that did not fit into any other bucket
+#define MBOXSTATS_BUCKETS 12
+#define MBOXSTATS_FIRST_BUCKET_SHIFT 4
+
+// default threshold for logging slow callbacks (one frame)
+#define MBOXSTATS_DEFAULT_SLOW_THRESHOLD_MICROS 16000
+
+typedef struct mbox_callback_stats
+{
+  void *func;
+  const char *name; // NULL if no name was registered for this function
+  unsigned long count;
+  unsigned long slowCount; // number of invocations that exceeded the slow callback threshold
+  long totalWaitMicros;
+  long maxWaitMicros;
+  long totalExecMicros;
+  long maxExecMicros;
+  unsigned long waitHistogram[MBOXSTATS_BUCKETS];
+  unsigned long execHistogram[MBOXSTATS_BUCKETS];
+} mbox_callback_stats;
+
+typedef struct mbox_stats
+{
+  int highWaterMark; // max. number of entries that were pending at the same time
+  unsigned long processed; // total number of entries processed
+  unsigned long untracked; // entries processed whose callback did not fit into the callbacks table
+  long slowThresholdMicros;
+  int callbackCount;
+  mbox_callback_stats callbacks[MBOXSTATS_MAX_CALLBACKS];
+} mbox_stats;
+
+/**
+ * Registers a human-readable name for a callback function.
+ * @param func
+ * @param name name, must be a string literal
+ */
+void mboxstats_set_name(void *func,const char *name);
+
+/**
+ * Looks up the name registered for a callback function.
+ * @param func
+ * @return name or NULL
+ */
+const char *mboxstats_get_name(void *func);
+
+/**
+ * Records the current mailbox depth after an entry was added.
+ * Must be called while holding the mailbox mutex.
+ * @param depth
+ */
+void mboxstats_record_depth(int depth);
+
+/**
+ * Records execution of a mailbox entry.
+ * Only to be called by the rendering thread.
+ *
+ * @param func callback that was executed
+ * @param waitMicros time the entry spent in the mailbox
+ * @param execMicros time the callback took to execute
+ */
+void mboxstats_record_execution(void *func,long waitMicros,long execMicros);
+
+/**
+ * Sets the execution time above which a callback gets logged as slow.
+ * @param micros threshold in microseconds, 0 disables logging
+ */
+void mboxstats_set_slow_threshold(long micros);
+
+/**
+ * Copies the current statistics.
+ * @param stats
+ */
+void mboxstats_get(mbox_stats *stats);
+
+/**
+ * Discards all statistics (except for registered names and the slow callback threshold).
+ */
+void mboxstats_reset(void);
+
+/**
+ * Returns the upper bound (exclusive) of a histogram bucket in microseconds.
+ * @param bucket
+ * @return upper bound or -1 for the last bucket
+ */
+long mboxstats_bucket_limit(int bucket);
+
+#endif
@@ -0,0 +1,246 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "mempool.h"
+#include "log.h"
+#include "memstats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MEM_ALIGNMENT 16
+
+#define MEM_ALIGN(size) ( ( (size) + MEM_ALIGNMENT - 1 ) & ~((size_t) MEM_ALIGNMENT - 1) )
+
+// smallest block a frame arena will allocate
+#define ARENA_MIN_BLOCK_SIZE 4096
+
+static volatile unsigned long heapAllocations = 0;
+
+void *mem_calloc(size_t count,size_t size)
+{
+  __sync_fetch_and_add(&heapAllocations,1);
+  return calloc(count,size);
+}
+
+char *mem_strdup(const char *string)
+{
+  __sync_fetch_and_add(&heapAllocations,1);
+  return strdup(string);
+}
+
+unsigned long mem_get_heap_allocation_count(void)
+{
+  return __sync_fetch_and_add(&heapAllocations,0);
+}
+
+// ========================== slab pool ==========================
+
+static size_t slab_stride(slab_pool *pool)
+{
+  size_t size = pool->objectSize < sizeof(void*) ? sizeof(void*) : pool->objectSize;
+  return MEM_ALIGN(size);
+}
+
+static size_t slab_size(slab_pool *pool)
+{
+  return MEM_ALIGN(sizeof(void*)) + slab_stride(pool) * pool->objectsPerSlab;
+}
+
+/**
+ * Adds a new slab to a pool and puts all its objects on the free list.
+ * Must be called while holding the pool's mutex.
+ *
+ * @param pool
+ * @return 0 on failure, otherwise success
+ */
+static int slab_grow(slab_pool *pool)
+{
+  size_t stride = slab_stride(pool);
+  char *slab = mem_calloc(1,slab_size(pool));
+  if ( ! slab ) {
+    log_error("slab_grow(): Failed to allocate new slab for pool '%s'",pool->name);
+    return 0;
+  }
+  memstats_add(MEM_CATEGORY_POOLS,slab_size(pool));
+
+  // first word links all slabs of this pool
+  *((void**) slab) = pool->slabs;
+  pool->slabs = slab;
+  pool->slabCount++;
+
+  char *object = slab + MEM_ALIGN(sizeof(void*));
+  for ( int i = 0 ; i < pool->objectsPerSlab ; i++, object += stride )
+  {
+    *((void**) object) = pool->freeList;
+    pool->freeList = object;
+  }
+  return 1;
+}
+
+void *slab_alloc(slab_pool *pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+
+  if ( pool->freeList == NULL && ! slab_grow(pool) ) {
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+  }
+  void *result = pool->freeList;
+  pool->freeList = *((void**) result);
+  pool->objectsInUse++;
+
+  pthread_mutex_unlock(&pool->mutex);
+
+  memset(result,0,pool->objectSize);
+  return result;
+}
+
+void slab_free(slab_pool *pool,void *object)
+{
+  if ( object == NULL ) {
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  *((void**) object) = pool->freeList;
+  pool->freeList = object;
+  pool->objectsInUse--;
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void slab_destroy(slab_pool *pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+  if ( pool->objectsInUse != 0 ) {
+    log_warn("slab_destroy(): Pool '%s' still has %d objects in use",pool->name,pool->objectsInUse);
+  }
+  void *slab = pool->slabs;
+  while ( slab )
+  {
+    void *next = *((void**) slab);
+    free(slab);
+    memstats_remove(MEM_CATEGORY_POOLS,slab_size(pool));
+    slab = next;
+  }
+  pool->slabs = NULL;
+  pool->freeList = NULL;
+  pool->slabCount = 0;
+  pool->objectsInUse = 0;
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+// ========================== frame arena ==========================
+
+static arena_block *arena_allocate_block(size_t minCapacity)
+{
+  size_t capacity = ARENA_MIN_BLOCK_SIZE;
+  while ( capacity < minCapacity ) {
+    capacity *= 2;
+  }
+  arena_block *block = mem_calloc(1,MEM_ALIGN(sizeof(arena_block)) + capacity);
+  if ( ! block ) {
+    log_error("arena_allocate_block(): Failed to allocate %d bytes",capacity);
+    return NULL;
+  }
+  block->capacity = capacity;
+  memstats_add(MEM_CATEGORY_POOLS,MEM_ALIGN(sizeof(arena_block)) + capacity);
+  return block;
+}
+
+static void *arena_alloc_from_block(arena_block *block,size_t size)
+{
+  if ( block == NULL || block->used + size > block->capacity ) {
+    return NULL;
+  }
+  char *result = ((char*) block) + MEM_ALIGN(sizeof(arena_block)) + block->used;
+  block->used += size;
+  return result;
+}
+
+void *arena_alloc(frame_arena *arena,size_t size)
+{
+  size = MEM_ALIGN(size);
+
+  void *result = arena_alloc_from_block(arena->first,size);
+  if ( ! result )
+  {
+    if ( arena->first == NULL )
+    {
+      arena->first = arena_allocate_block(size);
+      result = arena_alloc_from_block(arena->first,size);
+    }
+    else
+    {
+      result = arena_alloc_from_block(arena->overflow,size);
+      if ( ! result )
+      {
+        arena_block *block = arena_allocate_block(size);
+        if ( block )
+        {
+          block->next = arena->overflow;
+          arena->overflow = block;
+          result = arena_alloc_from_block(block,size);
+        }
+      }
+    }
+  }
+
+  if ( result )
+  {
+    memset(result,0,size);
+    arena->used += size;
+    if ( arena->used > arena->highWaterMark ) {
+      arena->highWaterMark = arena->used;
+    }
+  }
+  return result;
+}
+
+char *arena_strdup(frame_arena *arena,const char *string)
+{
+  size_t len = strlen(string)+1;
+  char *result = arena_alloc(arena,len);
+  if ( result ) {
+    memcpy(result,string,len);
+  }
+  return result;
+}
+
+static void arena_free_blocks(arena_block *block)
+{
+  while ( block )
+  {
+    arena_block *next = block->next;
+    memstats_remove(MEM_CATEGORY_POOLS,MEM_ALIGN(sizeof(arena_block)) + block->capacity);
+    free(block);
+    block = next;
+  }
+}
+
+void arena_reset(frame_arena *arena)
+{
+  if ( arena->overflow )
+  {
+    // previous frame did not fit into a single block, replace
+    // the main block with one that is large enough
+    arena_free_blocks(arena->overflow);
+    arena->overflow = NULL;
+
+    arena_block *block = arena_allocate_block(arena->highWaterMark);
+    if ( block ) {
+      arena_free_blocks(arena->first);
+      arena->first = block;
+    }
+  }
+  if ( arena->first ) {
+    arena->first->used = 0;
+  }
+  arena->used = 0;
+}
+
+void arena_destroy(frame_arena *arena)
+{
+  arena_free_blocks(arena->first);
+  arena_free_blocks(arena->overflow);
+  arena->first = NULL;
+  arena->overflow = NULL;
+  arena->used = 0;
+}
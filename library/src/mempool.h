@@ -0,0 +1,119 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/*
+ * Allocators used on the rendering path.
+ *
+ * A slab pool hands out fixed-size objects carved from larger
+ * slabs and keeps released objects on a free list, so that once
+ * the pool is warmed up no further heap allocations are needed.
+ * Slab pools are thread-safe.
+ *
+ * A frame arena is a bump allocator for transient objects that
+ * only live until the current frame has been flushed. Frame arenas
+ * must only be used from a single thread (the rendering thread).
+ */
+
+typedef struct slab_pool
+{
+  pthread_mutex_t mutex;
+  const char *name;
+  size_t objectSize;
+  int objectsPerSlab;
+  void *freeList;
+  void *slabs;
+  int slabCount;
+  int objectsInUse;
+} slab_pool;
+
+#define SLAB_POOL_INITIALIZER(poolName,type,perSlab) { PTHREAD_MUTEX_INITIALIZER, poolName, sizeof(type), perSlab, NULL, NULL, 0, 0 }
+
+typedef struct arena_block
+{
+  struct arena_block *next;
+  size_t capacity;
+  size_t used;
+} arena_block;
+
+typedef struct frame_arena
+{
+  arena_block *first; // block all allocations are made from in steady state
+  arena_block *overflow; // extra blocks allocated when the first block was exhausted
+  size_t used; // bytes allocated since last reset
+  size_t highWaterMark; // max. bytes allocated between two resets
+} frame_arena;
+
+#define FRAME_ARENA_INITIALIZER { NULL, NULL, 0, 0 }
+
+/**
+ * Counting wrapper around calloc().
+ * All heap allocations on the rendering path should go through this function.
+ */
+void *mem_calloc(size_t count,size_t size);
+
+/**
+ * Counting wrapper around strdup().
+ */
+char *mem_strdup(const char *string);
+
+/**
+ * Returns the number of heap allocations performed
+ * through mem_calloc()/mem_strdup() and the pools.
+ */
+unsigned long mem_get_heap_allocation_count(void);
+
+/**
+ * Allocates a zero-initialized object from a slab pool.
+ * @param pool
+ * @return object or NULL on OOM
+ */
+void *slab_alloc(slab_pool *pool);
+
+/**
+ * Returns an object to the slab pool it was allocated from.
+ * @param pool
+ * @param object object to release, may be NULL
+ */
+void slab_free(slab_pool *pool,void *object);
+
+/**
+ * Releases all slabs of a pool. All objects allocated from
+ * the pool become invalid.
+ * @param pool
+ */
+void slab_destroy(slab_pool *pool);
+
+/**
+ * Allocates zero-initialized memory from a frame arena.
+ * @param arena
+ * @param size number of bytes
+ * @return memory or NULL on OOM
+ */
+void *arena_alloc(frame_arena *arena,size_t size);
+
+/**
+ * Copies a string into a frame arena.
+ * @param arena
+ * @param string
+ * @return copy or NULL on OOM
+ */
+char *arena_strdup(frame_arena *arena,const char *string);
+
+/**
+ * Discards all allocations of a frame arena. If the previous frame
+ * needed overflow blocks, the arena's main block gets enlarged so that
+ * the next frame can be served without further heap allocations.
+ * @param arena
+ */
+void arena_reset(frame_arena *arena);
+
+/**
+ * Releases all memory held by a frame arena.
+ * @param arena
+ */
+void arena_destroy(frame_arena *arena);
+
+#endif
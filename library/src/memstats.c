@@ -0,0 +1,87 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "memstats.h"
+#include "log.h"
+#include <pthread.h>
+#include <string.h>
+
+static pthread_mutex_t usage_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static mem_usage usage;
+
+// only accessed from the rendering thread
+static MemEvictor evictors[MEM_CATEGORY_COUNT];
+
+static const char *categoryNames[] = { "images", "listview_surfaces", "text", "fonts", "label_cache", "pools", "page_surfaces" };
+
+void memstats_add(MemCategory category,long bytes)
+{
+  pthread_mutex_lock(&usage_mutex);
+  usage.currentBytes[category] += bytes;
+  if ( usage.currentBytes[category] > usage.peakBytes[category] ) {
+    usage.peakBytes[category] = usage.currentBytes[category];
+  }
+  pthread_mutex_unlock(&usage_mutex);
+}
+
+void memstats_remove(MemCategory category,long bytes)
+{
+  pthread_mutex_lock(&usage_mutex);
+  usage.currentBytes[category] -= bytes;
+  pthread_mutex_unlock(&usage_mutex);
+}
+
+long memstats_surface_size(SDL_Surface *surface)
+{
+  if ( surface == NULL ) {
+    return 0;
+  }
+  return sizeof(SDL_Surface) + surface->h * surface->pitch;
+}
+
+int memstats_set_budget(MemCategory category,long bytes)
+{
+  if ( category < 0 || category >= MEM_CATEGORY_COUNT || bytes < 0 ) {
+    return 0;
+  }
+  pthread_mutex_lock(&usage_mutex);
+  usage.budgetBytes[category] = bytes;
+  pthread_mutex_unlock(&usage_mutex);
+  return 1;
+}
+
+void memstats_set_evictor(MemCategory category,MemEvictor evictor)
+{
+  evictors[category] = evictor;
+}
+
+void memstats_enforce_budgets(void)
+{
+  for ( int i = 0 ; i < MEM_CATEGORY_COUNT ; i++ )
+  {
+    pthread_mutex_lock(&usage_mutex);
+    long excess = usage.budgetBytes[i] > 0 ? usage.currentBytes[i] - usage.budgetBytes[i] : 0;
+    if ( excess > 0 && evictors[i] ) {
+      usage.evictions[i]++;
+    }
+    pthread_mutex_unlock(&usage_mutex);
+
+    if ( excess > 0 && evictors[i] )
+    {
+      log_debug("memstats_enforce_budgets(): %s over budget by %ld bytes",categoryNames[i],excess);
+      evictors[i](excess);
+    }
+  }
+}
+
+void memstats_get(mem_usage *result)
+{
+  pthread_mutex_lock(&usage_mutex);
+  *result = usage;
+  pthread_mutex_unlock(&usage_mutex);
+}
+
+const char *memstats_get_category_name(MemCategory category)
+{
+  return categoryNames[category];
+}
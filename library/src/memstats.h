@@ -0,0 +1,90 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Accounting of memory held by the library, broken down by category.
+ *
+ * Each category may have a budget. When a category exceeds its budget,
+ * the evictor registered for that category (if any) is asked to release
+ * memory the next time budgets get enforced, which happens once per frame
+ * on the rendering thread.
+ */
+
+typedef enum {
+  MEM_CATEGORY_IMAGES=0, // surfaces of images loaded from disk
+  MEM_CATEGORY_LISTVIEW_SURFACES=1, // off-screen surfaces of list views
+  MEM_CATEGORY_TEXT=2, // surfaces of rendered text
+  MEM_CATEGORY_FONTS=3, // loaded fonts (estimated from font file size)
+  MEM_CATEGORY_LABEL_CACHE=4, // cached list view labels
+  MEM_CATEGORY_POOLS=5, // slab pools, frame arena and trace buffers
+  MEM_CATEGORY_PAGE_SURFACES=6 // off-screen surfaces of pages
+} MemCategory;
+
+#define MEM_CATEGORY_COUNT 7
+
+typedef struct mem_usage
+{
+  long currentBytes[MEM_CATEGORY_COUNT];
+  long peakBytes[MEM_CATEGORY_COUNT];
+  long budgetBytes[MEM_CATEGORY_COUNT]; // 0 = unlimited
+  unsigned long evictions[MEM_CATEGORY_COUNT]; // number of times the evictor was invoked
+} mem_usage;
+
+// releases at least the given number of bytes (if possible)
+typedef void (*MemEvictor)(long excessBytes);
+
+/**
+ * Accounts memory being allocated.
+ * @param category
+ * @param bytes
+ */
+void memstats_add(MemCategory category,long bytes);
+
+/**
+ * Accounts memory being released.
+ * @param category
+ * @param bytes
+ */
+void memstats_remove(MemCategory category,long bytes);
+
+/**
+ * Returns the number of bytes a surface occupies, including its header.
+ * @param surface surface or NULL
+ */
+long memstats_surface_size(SDL_Surface *surface);
+
+/**
+ * Sets the budget of a category.
+ * @param category
+ * @param bytes budget in bytes, 0 for unlimited
+ * @return 0 if category is invalid, otherwise success
+ */
+int memstats_set_budget(MemCategory category,long bytes);
+
+/**
+ * Registers the function that releases memory of a category when it is over budget.
+ * @param category
+ * @param evictor
+ */
+void memstats_set_evictor(MemCategory category,MemEvictor evictor);
+
+/**
+ * Invokes the evictors of all categories that are over budget.
+ * Must be called on the rendering thread.
+ */
+void memstats_enforce_budgets(void);
+
+/**
+ * Copies the current memory usage.
+ * @param usage
+ */
+void memstats_get(mem_usage *usage);
+
+/**
+ * Returns the name of a category.
+ */
+const char *memstats_get_category_name(MemCategory category);
+
+#endif
@@ -1,5 +1,9 @@
 #include "mylib.h"
 #include "ui.h"
+#include "mempool.h"
+#include "log.h"
+#include "render.h"
+#include "trace.h"
 
 int mylib_add_button(char *text,int x,int y,int width,int height,ButtonHandler clickHandler) 
 {
@@ -17,11 +21,227 @@ int mylib_add_image_button(char *imagePath,int x,int y,int width,int height,Butt
   return ui_add_image_button(imagePath,&rect,clickHandler);     
 }
 
+int mylib_add_progressbar(int x,int y,int width,int height,int maximum,ProgressBarSeekCallback seekCallback) 
+{
+  SDL_Rect rect = {x,y,width,height};
+  return ui_add_progressbar(&rect,maximum,seekCallback);
+}
+
+int mylib_progressbar_set_value(int progressBarId,int value) {
+  return ui_progressbar_set_value(progressBarId,value);
+}
+
+int mylib_progressbar_set_maximum(int progressBarId,int maximum) {
+  return ui_progressbar_set_maximum(progressBarId,maximum);
+}
+
+int mylib_add_container(int x,int y,int width,int height,SDL_Color *background) 
+{
+  SDL_Rect rect = {x,y,width,height};
+  return ui_add_container(&rect,background);
+}
+
+int mylib_begin_container(int containerId) {
+  return ui_begin_container(containerId);
+}
+
+void mylib_end_container(void) {
+  ui_end_container();
+}
+
+int mylib_add_page(SDL_Color *background) {
+  return ui_add_page(background);
+}
+
+int mylib_push_page(int pageId,int transition,int durationMillis) {
+  return ui_push_page(pageId,transition,durationMillis * 1000L);
+}
+
+int mylib_pop_page(int transition,int durationMillis) {
+  return ui_pop_page(transition,durationMillis * 1000L);
+}
+
+int mylib_show_page(int pageId,int transition,int durationMillis) {
+  return ui_show_page(pageId,transition,durationMillis * 1000L);
+}
+
+int mylib_get_active_page(void) {
+  return ui_get_active_page();
+}
+
+int mylib_set_layout(int containerId,int type,int padding,int spacing,int columns) {
+  return ui_set_layout(containerId,type,padding,spacing,columns);
+}
+
+int mylib_set_layout_size(int elementId,int width,int height,int weight) {
+  return ui_set_layout_size(elementId,width,height,weight);
+}
+
+int mylib_set_button_text(int buttonId,const char *text) {
+  return ui_set_button_text(buttonId,text);
+}
+
+int mylib_set_z_order(int elementId,int zOrder) {
+  return ui_set_z_order(elementId,zOrder);
+}
+
+int mylib_animate(int elementId,int property,long to,int durationMillis,int easing) {
+  return ui_animate(elementId,property,to,durationMillis * 1000L,easing);
+}
+
+int mylib_cancel_animation(int animationId) {
+  return ui_cancel_animation(animationId);
+}
+
+int mylib_invalidate(int elementId) {
+  return ui_invalidate(elementId);
+}
+
+int mylib_listview_invalidate_item(int listViewId,int itemIndex) {
+  return ui_listview_invalidate_item(listViewId,itemIndex);
+}
+
+int mylib_listview_invalidate_range(int listViewId,int firstIndex,int count) {
+  return ui_listview_invalidate_range(listViewId,firstIndex,count);
+}
+
+int mylib_listview_invalidate_all(int listViewId) {
+  return ui_listview_invalidate_all(listViewId);
+}
+
+int mylib_listview_set_item_count(int listViewId,int itemCount) {
+  return ui_listview_set_item_count(listViewId,itemCount);
+}
+
+unsigned long mylib_get_heap_allocation_count(void) {
+  return mem_get_heap_allocation_count();
+}
+
+unsigned long mylib_get_dropped_log_count(void) {
+  return log_get_dropped_count();
+}
+
+int mylib_set_log_level(int module,int level) {
+  return log_set_level(module,level);
+}
+
+int mylib_get_log_level(int module) {
+  return log_get_level(module);
+}
+
+void mylib_set_profiler_enabled(int enabled) {
+  profiler_set_enabled(enabled);
+}
+
+void mylib_set_profiler_hud(int enabled) {
+  render_set_profiler_hud(enabled);
+}
+
+int mylib_get_frame_profiles(frame_profile *frames,int maxFrames) {
+  if ( ! profiler_is_enabled() ) {
+    profiler_set_enabled(1);
+  }
+  return profiler_get_frames(frames,maxFrames);
+}
+
+void mylib_get_mailbox_stats(mbox_stats *stats) {
+  mboxstats_get(stats);
+}
+
+void mylib_reset_mailbox_stats(void) {
+  mboxstats_reset();
+}
+
+void mylib_set_slow_callback_threshold(long micros) {
+  mboxstats_set_slow_threshold(micros);
+}
+
+void mylib_get_memory_usage(mem_usage *usage) {
+  memstats_get(usage);
+}
+
+int mylib_set_memory_budget(int category,long bytes) {
+  return memstats_set_budget(category,bytes);
+}
+
+void mylib_get_image_cache_stats(image_cache_stats *stats) {
+  imagecache_get_stats(stats);
+}
+
+int mylib_start_trace(const char *path) {
+  return trace_start(path);
+}
+
+void mylib_flush_trace(void) {
+  trace_flush();
+}
+
+void mylib_stop_trace(void) {
+  trace_stop();
+}
+
+int mylib_set_display_backend(int type) {
+  const display_backend *backend = display_get_backend(type);
+  return backend ? render_set_display_backend(backend) : 0;
+}
+
+int mylib_set_asset_bundle(const char *path) {
+  return render_set_asset_bundle(path);
+}
+
+int mylib_set_render_workers(int count) {
+  return render_set_row_workers(count);
+}
+
+SDL_Surface *mylib_capture_frame(void) 
+{
+  viewport_desc viewport;
+  if ( ! render_get_viewport_desc(&viewport) ) {
+    return NULL;
+  }
+  // bytes of each pixel in R,G,B,A order
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+  SDL_Surface *result = SDL_CreateRGBSurface(SDL_SWSURFACE,viewport.width,viewport.height,32,
+                                             0xff000000,0x00ff0000,0x0000ff00,0x000000ff);
+#else
+  SDL_Surface *result = SDL_CreateRGBSurface(SDL_SWSURFACE,viewport.width,viewport.height,32,
+                                             0x000000ff,0x0000ff00,0x00ff0000,0xff000000);
+#endif
+  if ( result && ! render_capture_frame(result) ) {
+    SDL_FreeSurface(result);
+    result = NULL;
+  }
+  return result;
+}
+
+screen_definition *mylib_load_screen(const char *path,ScreenCallbackResolver resolver,void *resolverData) {
+  return screen_load(path,resolver,resolverData);
+}
+
+int mylib_show_screen(screen_definition *screen) {
+  return screen_show(screen);
+}
+
+int mylib_find_screen_element(screen_definition *screen,const char *name) {
+  return screen_find_element(screen,name);
+}
+
+const char *mylib_get_screen_callback_name(int elementId,int type) {
+  return screen_get_callback_name(elementId,type);
+}
+
+void mylib_free_screen(screen_definition *screen) {
+  screen_free(screen);
+}
+
 int mylib_init(void) {
   return ui_init();  
 }
 
 void mylib_close(void) {
+  screen_close();
   ui_close();  
+  trace_stop();
+  log_close();
 }
   
\ No newline at end of file
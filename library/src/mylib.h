@@ -2,6 +2,12 @@
 #define MYLIB_H
 
 #include "ui.h"
+#include "profiler.h"
+#include "mboxstats.h"
+#include "memstats.h"
+#include "display.h"
+#include "imagecache.h"
+#include "screen.h"
 
 int mylib_add_button(char *text,int x,int y,int width,int height,ButtonHandler clickHandler);
 
@@ -18,6 +24,395 @@ int mylib_add_image_button(char *imagePath,int x,int y,int width,int height,Butt
  */
 int mylib_add_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListViewItemCountProvider itemCountProvider, ListViewClickCallback clickCallback);
 
+/**
+ * Adds a progress/seek bar.
+ * @param maximum value at which the bar is completely filled
+ * @param seekCallback callback that gets invoked when the user dragged the bar to a new value or NULL
+ * @return the progress bar's ID (always >0) if everything worked ok, otherwise 0
+ */
+int mylib_add_progressbar(int x,int y,int width,int height,int maximum,ProgressBarSeekCallback seekCallback);
+
+/**
+ * Updates the value of a progress bar. May be called from any thread, does 
+ * not wait for the rendering thread.
+ * @param progressBarId progress bar ID
+ * @param value new value
+ * @return 0 on error, otherwise success
+ */
+int mylib_progressbar_set_value(int progressBarId,int value);
+
+/**
+ * Updates the value at which a progress bar is completely filled.
+ * @param progressBarId progress bar ID
+ * @param maximum
+ * @return 0 on error, otherwise success
+ */
+int mylib_progressbar_set_maximum(int progressBarId,int maximum);
+
+/**
+ * Adds a container (panel, page, ...). Children are positioned relative 
+ * to the container and clipped to its bounds.
+ * 
+ * @param background background color or NULL for a transparent container
+ * @return the container's ID (always >0) if everything worked ok, otherwise 0
+ */
+int mylib_add_container(int x,int y,int width,int height,SDL_Color *background);
+
+/**
+ * Makes all elements added until the matching mylib_end_container() call children of a container.
+ * @param containerId container ID
+ * @return 0 on error, otherwise success
+ */
+int mylib_begin_container(int containerId);
+
+void mylib_end_container(void);
+
+/**
+ * Adds a full-screen page, elements get added to it with mylib_begin_container().
+ * The first page added becomes the active page.
+ * 
+ * @param background background color or NULL for black
+ * @return the page's ID (always >0) if everything worked ok, otherwise 0
+ */
+int mylib_add_page(SDL_Color *background);
+
+/**
+ * Makes a page the active page, keeping the current page on the page stack.
+ * @param pageId page ID
+ * @param transition transition (PAGE_TRANSITION_xxx)
+ * @param durationMillis duration of the transition in milliseconds
+ * @return 0 on error, otherwise success
+ */
+int mylib_push_page(int pageId,int transition,int durationMillis);
+
+/**
+ * Returns to the page below the active page.
+ * @param transition transition (PAGE_TRANSITION_xxx)
+ * @param durationMillis duration of the transition in milliseconds
+ * @return 0 on error, otherwise success
+ */
+int mylib_pop_page(int transition,int durationMillis);
+
+/**
+ * Replaces the active page by another page.
+ * @param pageId page ID
+ * @param transition transition (PAGE_TRANSITION_xxx)
+ * @param durationMillis duration of the transition in milliseconds
+ * @return 0 on error, otherwise success
+ */
+int mylib_show_page(int pageId,int transition,int durationMillis);
+
+/**
+ * Returns the ID of the active page or 0 if no page has been added.
+ */
+int mylib_get_active_page(void);
+
+/**
+ * Makes a container position its children as a row, a column or a grid (LAYOUT_xxx).
+ * Row/column children share the space left in proportion to their weight, grid 
+ * columns are as wide as their widest child. See layout.h for details.
+ * 
+ * @param containerId container ID
+ * @param type layout type, LAYOUT_NONE keeps the children where they are
+ * @param padding space between the container's edges and its children
+ * @param spacing space between adjacent children
+ * @param columns number of columns (grids only)
+ * @return 0 on error, otherwise success
+ */
+int mylib_set_layout(int containerId,int type,int padding,int spacing,int columns);
+
+/**
+ * Changes the size an element requests from its layout container,
+ * by default that is the size the element was added with.
+ * 
+ * @param elementId element ID
+ * @param width LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels
+ * @param height LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels
+ * @param weight share of the space left along the layout direction, 0 for none
+ * @return 0 on error, otherwise success
+ */
+int mylib_set_layout_size(int elementId,int width,int height,int weight);
+
+/**
+ * Replaces the text of a button.
+ * @param buttonId button ID
+ * @param text new text
+ * @return 0 on error, otherwise success
+ */
+int mylib_set_button_text(int buttonId,const char *text);
+
+/**
+ * Changes the z-order of an element (default: 0). Elements with a higher z-order are 
+ * drawn on top of elements in the same container with a lower z-order.
+ * 
+ * @param elementId element ID
+ * @param zOrder
+ * @return 0 on error, otherwise success
+ */
+int mylib_set_z_order(int elementId,int zOrder);
+
+/**
+ * Animates a property of an element from its current value to a target value.
+ * Colors are packed as 0xRRGGBB. Starting a new animation of a property 
+ * replaces the one currently running.
+ * 
+ * @param elementId element ID
+ * @param property property (ANIM_PROPERTY_xxx)
+ * @param to target value
+ * @param durationMillis duration in milliseconds
+ * @param easing easing function (EASE_xxx)
+ * @return 0 on error, otherwise the animation's ID (always >0)
+ */
+int mylib_animate(int elementId,int property,long to,int durationMillis,int easing);
+
+/**
+ * Stops an animation, the animated property keeps its current value.
+ * @param animationId animation ID
+ * @return 0 if the animation is not running, otherwise success
+ */
+int mylib_cancel_animation(int animationId);
+
+/**
+ * Repaints an element (including its children) at the end of the current frame.
+ * @param elementId element ID
+ * @return 0 on error, otherwise success
+ */
+int mylib_invalidate(int elementId);
+
+/**
+ * Discards the cached label of a list view item.
+ * @param listViewId list view ID
+ * @param itemIndex item index
+ * @return 0 on error, otherwise success
+ */
+int mylib_listview_invalidate_item(int listViewId,int itemIndex);
+
+/**
+ * Discards the cached labels of a range of list view items.
+ * @param listViewId list view ID
+ * @param firstIndex index of first item
+ * @param count number of items
+ * @return 0 on error, otherwise success
+ */
+int mylib_listview_invalidate_range(int listViewId,int firstIndex,int count);
+
+/**
+ * Discards all cached labels and the cached item count of a list view.
+ * @param listViewId list view ID
+ * @return 0 on error, otherwise success
+ */
+int mylib_listview_invalidate_all(int listViewId);
+
+/**
+ * Updates the number of items a list view displays.
+ * @param listViewId list view ID
+ * @param itemCount new item count
+ * @return 0 on error, otherwise success
+ */
+int mylib_listview_set_item_count(int listViewId,int itemCount);
+
+/**
+ * Returns the number of heap allocations the library performed so far.
+ * Meant for tests that verify the rendering path does not allocate in steady state.
+ * 
+ * @return allocation count
+ */
+unsigned long mylib_get_heap_allocation_count(void);
+
+/**
+ * Returns the number of log messages that were dropped because
+ * the background log writer could not keep up.
+ * 
+ * @return dropped message count
+ */
+unsigned long mylib_get_dropped_log_count(void);
+
+/**
+ * Sets the runtime log level of a library module.
+ * 
+ * @param module one of LOG_MODULE_RENDER, LOG_MODULE_INPUT, LOG_MODULE_UI, LOG_MODULE_PYTHON
+ * @param level one of ERROR, WARN, INFO, DEBUG, TRACE
+ * @return 0 if module or level are invalid, otherwise success
+ */
+int mylib_set_log_level(int module,int level);
+
+/**
+ * Returns the runtime log level of a library module.
+ * 
+ * @param module module
+ * @return log level or -1 if the module is invalid
+ */
+int mylib_get_log_level(int module);
+
+/**
+ * Enables or disables collection of per-frame timings.
+ * Profiling is disabled by default, showing the profiler overlay or 
+ * calling mylib_get_frame_profiles() enables it as well.
+ * 
+ * @param enabled
+ */
+void mylib_set_profiler_enabled(int enabled);
+
+/**
+ * Shows or hides an overlay in the top-right corner of the screen that
+ * displays the last frame's time, its most expensive phase and the mailbox depth.
+ * Showing the overlay enables the profiler, hiding it disables the profiler again unless it was enabled before.
+ * 
+ * @param enabled
+ */
+void mylib_set_profiler_hud(int enabled);
+
+/**
+ * Copies timings of the most recently rendered frames.
+ * Enables the profiler if it is disabled, so the first call may not return any frames.
+ * 
+ * @param frames array to copy frames to, most recent frame first
+ * @param maxFrames array size
+ * @return number of frames copied
+ */
+int mylib_get_frame_profiles(frame_profile *frames,int maxFrames);
+
+/**
+ * Copies statistics about callbacks executed on the rendering thread.
+ * @param stats
+ */
+void mylib_get_mailbox_stats(mbox_stats *stats);
+
+/**
+ * Discards all mailbox statistics.
+ */
+void mylib_reset_mailbox_stats(void);
+
+/**
+ * Sets the execution time above which a callback on the rendering thread gets logged as slow.
+ * @param micros threshold in microseconds, 0 disables logging of slow callbacks
+ */
+void mylib_set_slow_callback_threshold(long micros);
+
+/**
+ * Copies current and peak memory usage per category (MEM_CATEGORY_xxx).
+ * @param usage
+ */
+void mylib_get_memory_usage(mem_usage *usage);
+
+/**
+ * Sets the memory budget of a category. Categories that exceed their
+ * budget get trimmed at the end of the next frame, if the category supports eviction.
+ * 
+ * @param category category (MEM_CATEGORY_xxx)
+ * @param bytes budget in bytes, 0 for unlimited
+ * @return 0 if category is invalid, otherwise success
+ */
+int mylib_set_memory_budget(int category,long bytes);
+
+/**
+ * Copies hit/miss statistics and the size of the cache images are shared through.
+ * Cached images count towards MEM_CATEGORY_IMAGES, unused images get evicted
+ * once that category exceeds its budget.
+ * @param stats
+ */
+void mylib_get_image_cache_stats(image_cache_stats *stats);
+
+/**
+ * Starts recording a trace (Chrome trace event format) of frames, mailbox callbacks,
+ * draws, touch dispatch and user callbacks.
+ * 
+ * @param path trace file to write
+ * @return 0 on error, otherwise success
+ */
+int mylib_start_trace(const char *path);
+
+/**
+ * Writes all buffered trace events to the trace file.
+ * Call this periodically during long-running traces, events get dropped when
+ * a thread's buffer (TRACE_BUFFER_SIZE events) fills up.
+ */
+void mylib_flush_trace(void);
+
+/**
+ * Writes all buffered trace events and closes the trace file.
+ * Invoked automatically by mylib_close().
+ */
+void mylib_stop_trace(void);
+
+/**
+ * Selects where the UI gets displayed, must be called before mylib_init().
+ * DISPLAY_BACKEND_MEMORY renders into an off-screen surface only and does not need
+ * any video subsystem (benchmarks, tests, frame capture).
+ * 
+ * @param type backend (DISPLAY_BACKEND_xxx)
+ * @return 0 if type is invalid or the library is already initialized, otherwise success
+ */
+int mylib_set_display_backend(int type);
+
+/**
+ * Takes icons and glyphs from an asset bundle created by tools/mkbundle instead of
+ * decoding image files and rasterizing the TTF font, must be called before mylib_init().
+ * Images and text not found in the bundle are still loaded from their files.
+ * 
+ * @param path bundle file
+ * @return 0 if the library is already initialized, otherwise success
+ */
+int mylib_set_asset_bundle(const char *path);
+
+/**
+ * Sets the number of threads that render list view items besides the rendering thread.
+ * By default there is one per additional CPU core. May be called before or after mylib_init().
+ * 
+ * @param count number of workers (0 renders all items on the rendering thread) or -1 for one per additional CPU core
+ * @return 0 if the count is out of range or not all workers could be started, otherwise success
+ */
+int mylib_set_render_workers(int count);
+
+/**
+ * Copies the current contents of the screen.
+ * @return 32-bit RGBA surface (free with SDL_FreeSurface()) or NULL on error
+ */
+SDL_Surface *mylib_capture_frame(void);
+
+/**
+ * Loads a screen definition file (see screen.h), parsing and validating it on the calling thread
+ * and loading all of its images in the background.
+ * 
+ * @param path screen file
+ * @param resolver looks up the callbacks named in the file
+ * @param resolverData data passed to the resolver
+ * @return screen or NULL on error
+ */
+screen_definition *mylib_load_screen(const char *path,ScreenCallbackResolver resolver,void *resolverData);
+
+/**
+ * Replaces the currently shown screen, the new screen appears at once in the next frame.
+ * 
+ * @param screen
+ * @return 0 on error, otherwise success
+ */
+int mylib_show_screen(screen_definition *screen);
+
+/**
+ * Looks up the ID of a named element of a shown screen.
+ * 
+ * @param screen
+ * @param name
+ * @return element ID or 0 if the screen is not shown or has no such element
+ */
+int mylib_find_screen_element(screen_definition *screen,const char *name);
+
+/**
+ * Looks up the name of a callback of an element of the shown screen.
+ * 
+ * @param elementId
+ * @param type callback type (SCREEN_CALLBACK_xxx)
+ * @return callback name or NULL
+ */
+const char *mylib_get_screen_callback_name(int elementId,int type);
+
+/**
+ * Frees a screen, hiding it if it is shown.
+ * @param screen
+ */
+void mylib_free_screen(screen_definition *screen);
+
 int mylib_init(void);
 
 void mylib_close(void);
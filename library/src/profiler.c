@@ -0,0 +1,172 @@
+#include "profiler.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+// off until the overlay or a caller asks for timings, see mylib_set_profiler_enabled()
+static volatile int enabled = 0;
+
+// completed frames, guarded by ring_mutex
+static pthread_mutex_t ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static frame_profile ring[PROFILER_FRAME_COUNT];
+static unsigned long completedFrames = 0;
+
+/*
+ * State of the frame currently being recorded, only
+ * accessed by the rendering thread.
+ */
+static frame_profile current;
+static int frameActive = 0;
+static long frameStart;
+static long phaseStart[PROFILE_PHASE_COUNT];
+static long drawMicrosAtPhaseStart[PROFILE_PHASE_COUNT];
+static long callbackStart;
+static long drawMicrosAtCallbackStart;
+static int drawNesting = 0;
+
+static const char *phaseNames[] = { "input", "mailbox", "draw", "flush" };
+
+long profiler_now_micros(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+void profiler_set_enabled(int enable)
+{
+  enabled = enable;
+}
+
+int profiler_is_enabled(void)
+{
+  return enabled;
+}
+
+const char *profiler_get_phase_name(ProfilePhase phase)
+{
+  return phaseNames[phase];
+}
+
+void profiler_begin_frame(int mailboxDepth)
+{
+  frameActive = enabled;
+  if ( ! frameActive ) {
+    return;
+  }
+  unsigned long frameNumber = current.frameNumber;
+  memset(&current,0,sizeof(current));
+  current.frameNumber = frameNumber+1;
+  current.mailboxDepth = mailboxDepth;
+  drawNesting = 0;
+  frameStart = profiler_now_micros();
+}
+
+void profiler_begin_phase(ProfilePhase phase)
+{
+  if ( frameActive ) {
+    drawMicrosAtPhaseStart[phase] = current.phaseMicros[PROFILE_PHASE_DRAW];
+    phaseStart[phase] = profiler_now_micros();
+  }
+}
+
+void profiler_end_phase(ProfilePhase phase)
+{
+  if ( frameActive )
+  {
+    long elapsed = profiler_now_micros() - phaseStart[phase];
+    // draws are accounted separately
+    elapsed -= current.phaseMicros[PROFILE_PHASE_DRAW] - drawMicrosAtPhaseStart[phase];
+    current.phaseMicros[phase] += elapsed;
+  }
+}
+
+void profiler_begin_callback(void)
+{
+  if ( frameActive ) {
+    drawMicrosAtCallbackStart = current.phaseMicros[PROFILE_PHASE_DRAW];
+    callbackStart = profiler_now_micros();
+  }
+}
+
+void profiler_end_callback(void *func)
+{
+  if ( ! frameActive ) {
+    return;
+  }
+  long elapsed = profiler_now_micros() - callbackStart;
+  elapsed -= current.phaseMicros[PROFILE_PHASE_DRAW] - drawMicrosAtCallbackStart;
+
+  int i;
+  for ( i = 0 ; i < current.callbackCount && current.callbacks[i].func != func ; i++ ) {
+  }
+  if ( i == current.callbackCount )
+  {
+    if ( i == PROFILER_MAX_CALLBACKS ) {
+      return;
+    }
+    current.callbacks[i].func = func;
+    current.callbackCount++;
+  }
+  current.callbacks[i].count++;
+  current.callbacks[i].micros += elapsed;
+}
+
+long profiler_begin_draw(void)
+{
+  if ( ! frameActive || drawNesting++ > 0 ) {
+    return 0;
+  }
+  return profiler_now_micros();
+}
+
+void profiler_end_draw(int elementId,long startMicros)
+{
+  if ( ! frameActive || --drawNesting > 0 ) {
+    return;
+  }
+  long elapsed = profiler_now_micros() - startMicros;
+  current.phaseMicros[PROFILE_PHASE_DRAW] += elapsed;
+
+  int i;
+  for ( i = 0 ; i < current.drawCount && current.draws[i].elementId != elementId ; i++ ) {
+  }
+  if ( i == current.drawCount )
+  {
+    if ( i == PROFILER_MAX_DRAWS ) {
+      return;
+    }
+    current.draws[i].elementId = elementId;
+    current.drawCount++;
+  }
+  current.draws[i].count++;
+  current.draws[i].micros += elapsed;
+}
+
+void profiler_end_frame(void)
+{
+  if ( ! frameActive ) {
+    return;
+  }
+  current.totalMicros = profiler_now_micros() - frameStart;
+  frameActive = 0;
+
+  pthread_mutex_lock(&ring_mutex);
+  ring[ completedFrames % PROFILER_FRAME_COUNT ] = current;
+  completedFrames++;
+  pthread_mutex_unlock(&ring_mutex);
+}
+
+int profiler_get_frames(frame_profile *frames,int maxFrames)
+{
+  pthread_mutex_lock(&ring_mutex);
+
+  int available = completedFrames < PROFILER_FRAME_COUNT ? (int) completedFrames : PROFILER_FRAME_COUNT;
+  int count = maxFrames < available ? maxFrames : available;
+  for ( int i = 0 ; i < count ; i++ ) {
+    frames[i] = ring[ (completedFrames - 1 - i) % PROFILER_FRAME_COUNT ];
+  }
+
+  pthread_mutex_unlock(&ring_mutex);
+  return count;
+}
@@ -0,0 +1,126 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ * Per-frame profiler for the rendering thread.
+ *
+ * The rendering thread records how long each phase of a frame took,
+ * completed frames are kept in a ring buffer that can be read from
+ * any thread.
+ *
+ * Time spent drawing UI elements is accounted to PROFILE_PHASE_DRAW only,
+ * it is NOT included in the phase (input or mailbox) that triggered the draw.
+ */
+
+// number of frames kept in the ring buffer
+#define PROFILER_FRAME_COUNT 64
+
+// max. number of distinct mailbox callbacks tracked per frame
+#define PROFILER_MAX_CALLBACKS 8
+
+// max. number of distinct UI elements tracked per frame
+#define PROFILER_MAX_DRAWS 8
+
+typedef enum { PROFILE_PHASE_INPUT=0, PROFILE_PHASE_MAILBOX=1, PROFILE_PHASE_DRAW=2, PROFILE_PHASE_FLUSH=3 } ProfilePhase;
+
+#define PROFILE_PHASE_COUNT 4
+
+typedef struct profile_callback
+{
+  void *func; // mailbox callback
+  int count; // number of invocations
+  long micros; // total execution time excluding draws
+} profile_callback;
+
+typedef struct profile_draw
+{
+  int elementId; // 0 for elements not registered (yet)
+  int count;
+  long micros;
+} profile_draw;
+
+typedef struct frame_profile
+{
+  unsigned long frameNumber;
+  long totalMicros; // time from start of input drain until flush completed
+  long phaseMicros[PROFILE_PHASE_COUNT];
+  int mailboxDepth; // mailbox entries pending when the frame started
+  int callbackCount;
+  profile_callback callbacks[PROFILER_MAX_CALLBACKS];
+  int drawCount;
+  profile_draw draws[PROFILER_MAX_DRAWS];
+} frame_profile;
+
+/**
+ * Returns a monotonic timestamp in microseconds.
+ */
+long profiler_now_micros(void);
+
+/**
+ * Enables or disables profiling.
+ * @param enabled
+ */
+void profiler_set_enabled(int enabled);
+
+int profiler_is_enabled(void);
+
+/**
+ * Starts recording a new frame.
+ * @param mailboxDepth number of pending mailbox entries
+ */
+void profiler_begin_frame(int mailboxDepth);
+
+/**
+ * Starts timing a phase.
+ */
+void profiler_begin_phase(ProfilePhase phase);
+
+/**
+ * Stops timing a phase.
+ */
+void profiler_end_phase(ProfilePhase phase);
+
+/**
+ * Starts timing a mailbox callback.
+ */
+void profiler_begin_callback(void);
+
+/**
+ * Stops timing a mailbox callback.
+ * @param func callback that was invoked
+ */
+void profiler_end_callback(void *func);
+
+/**
+ * Starts timing the draw of a UI element.
+ * @return timestamp to pass to profiler_end_draw()
+ */
+long profiler_begin_draw(void);
+
+/**
+ * Stops timing the draw of a UI element.
+ * @param elementId
+ * @param startMicros value returned by profiler_begin_draw()
+ */
+void profiler_end_draw(int elementId,long startMicros);
+
+/**
+ * Finishes the current frame and adds it to the ring buffer.
+ */
+void profiler_end_frame(void);
+
+/**
+ * Copies the most recently completed frames.
+ *
+ * @param frames array to copy frames to, most recent frame first
+ * @param maxFrames array size
+ * @return number of frames copied
+ */
+int profiler_get_frames(frame_profile *frames,int maxFrames);
+
+/**
+ * Returns the name of a phase.
+ */
+const char *profiler_get_phase_name(ProfilePhase phase);
+
+#endif
@@ -0,0 +1,275 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "raster.h"
+#include "log.h"
+#include "global.h"
+#include "mempool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Shape of the top left corner, the other corners are mirrored.
+ * Row 0 is the top row of the box.
+ */
+typedef struct corner_mask
+{
+  int radius;
+  Uint8 *inset; // pixels left out at the start of each row
+  Uint8 *outline; // length of the outline in each row, row 0 is drawn up to the other corner
+} corner_mask;
+
+// published with an atomic compare-and-swap, so drawing threads don't need a lock
+static corner_mask *cornerMasks[RASTER_MAX_RADIUS+1];
+
+static corner_mask *raster_create_mask(int radius)
+{
+  corner_mask *mask = mem_calloc(1,sizeof(corner_mask) + 2 * radius);
+  if ( mask == NULL ) {
+    return NULL;
+  }
+  mask->radius = radius;
+  mask->inset = (Uint8*) (mask + 1);
+  mask->outline = mask->inset + radius;
+
+  // a pixel is inside if x^2 + y^2 <= r^2 + r, which rounds like a midpoint circle
+  for ( int row = 0 ; row < radius ; row++ )
+  {
+    int dy = radius - row;
+    int dx = (int) sqrt( (double) ( radius * radius - dy * dy + radius ) );
+    mask->inset[row] = radius - min(dx,radius);
+  }
+  // the outline of a row reaches to the start of the row above it
+  mask->outline[0] = 0;
+  for ( int row = 1 ; row < radius ; row++ ) {
+    mask->outline[row] = max( mask->inset[row-1] - 1, mask->inset[row] ) - mask->inset[row] + 1;
+  }
+  return mask;
+}
+
+static corner_mask *raster_get_mask(int radius)
+{
+  corner_mask *mask = __atomic_load_n(&cornerMasks[radius],__ATOMIC_ACQUIRE);
+  if ( mask ) {
+    return mask;
+  }
+  mask = raster_create_mask(radius);
+  if ( mask == NULL ) {
+    log_error("raster_get_mask(): Failed to allocate mask for radius %d",radius);
+    return NULL;
+  }
+  corner_mask *expected = NULL;
+  if ( ! __atomic_compare_exchange_n(&cornerMasks[radius],&expected,mask,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) )
+  {
+    // another thread was faster
+    free(mask);
+    mask = expected;
+  }
+  return mask;
+}
+
+/**
+ * Fills the pixels x1...x2 (inclusive) of a row, clipped to the surface's clip rectangle.
+ * The surface must be locked.
+ */
+static void raster_hline(SDL_Surface *surface,int x1,int x2,int y,Uint32 pixel)
+{
+  SDL_Rect *clip = &surface->clip_rect;
+  if ( y < clip->y || y >= clip->y + clip->h ) {
+    return;
+  }
+  x1 = max(x1,clip->x);
+  x2 = min(x2,clip->x + clip->w - 1);
+  if ( x1 > x2 ) {
+    return;
+  }
+  int count = x2 - x1 + 1;
+  Uint8 *row = (Uint8*) surface->pixels + y * surface->pitch;
+  switch( surface->format->BytesPerPixel )
+  {
+    case 1:
+      memset(row + x1,pixel,count);
+      break;
+    case 2:
+    {
+      Uint16 *dst = (Uint16*) row + x1;
+      for ( int i = 0 ; i < count ; i++ ) {
+        dst[i] = pixel;
+      }
+      break;
+    }
+    case 3:
+    {
+      Uint8 *dst = row + x1 * 3;
+      Uint8 b0 = pixel, b1 = pixel >> 8, b2 = pixel >> 16;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+      Uint8 swap = b0;
+      b0 = b2;
+      b2 = swap;
+#endif
+      for ( int i = 0 ; i < count ; i++, dst += 3 )
+      {
+        dst[0] = b0;
+        dst[1] = b1;
+        dst[2] = b2;
+      }
+      break;
+    }
+    case 4:
+    {
+      Uint32 *dst = (Uint32*) row + x1;
+      for ( int i = 0 ; i < count ; i++ ) {
+        dst[i] = pixel;
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * Fills the pixels y1...y2 (inclusive) of a column, clipped to the surface's clip rectangle.
+ * The surface must be locked.
+ */
+static void raster_vline(SDL_Surface *surface,int x,int y1,int y2,Uint32 pixel)
+{
+  SDL_Rect *clip = &surface->clip_rect;
+  if ( x < clip->x || x >= clip->x + clip->w ) {
+    return;
+  }
+  y1 = max(y1,clip->y);
+  y2 = min(y2,clip->y + clip->h - 1);
+  if ( y1 > y2 ) {
+    return;
+  }
+  int bytesPerPixel = surface->format->BytesPerPixel;
+  Uint8 *dst = (Uint8*) surface->pixels + y1 * surface->pitch + x * bytesPerPixel;
+  int count = y2 - y1 + 1;
+  switch( bytesPerPixel )
+  {
+    case 1:
+      for ( int i = 0 ; i < count ; i++, dst += surface->pitch ) {
+        *dst = pixel;
+      }
+      break;
+    case 2:
+      for ( int i = 0 ; i < count ; i++, dst += surface->pitch ) {
+        *((Uint16*) dst) = pixel;
+      }
+      break;
+    case 4:
+      for ( int i = 0 ; i < count ; i++, dst += surface->pitch ) {
+        *((Uint32*) dst) = pixel;
+      }
+      break;
+    default:
+      for ( int y = y1 ; y <= y2 ; y++ ) {
+        raster_hline(surface,x,x,y,pixel);
+      }
+      break;
+  }
+}
+
+/**
+ * Orders the corners and limits the radius to what fits into the box, like SDL_gfx does.
+ * @return the radius to use
+ */
+static int raster_normalize(Sint16 *x1,Sint16 *y1,Sint16 *x2,Sint16 *y2,int radius)
+{
+  if ( *x1 > *x2 ) {
+    Sint16 swap = *x1; *x1 = *x2; *x2 = swap;
+  }
+  if ( *y1 > *y2 ) {
+    Sint16 swap = *y1; *y1 = *y2; *y2 = swap;
+  }
+  radius = min(radius,RASTER_MAX_RADIUS);
+  radius = min(radius,(*x2 - *x1) / 2);
+  radius = min(radius,(*y2 - *y1) / 2);
+  return max(radius,0);
+}
+
+static int raster_lock(SDL_Surface *surface)
+{
+  if ( SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0 ) {
+    log_error("raster_lock(): Failed to lock surface: %s",SDL_GetError());
+    return 0;
+  }
+  return 1;
+}
+
+static void raster_unlock(SDL_Surface *surface)
+{
+  if ( SDL_MUSTLOCK(surface) ) {
+    SDL_UnlockSurface(surface);
+  }
+}
+
+int raster_fill_rounded_box(SDL_Surface *surface,Sint16 x1,Sint16 y1,Sint16 x2,Sint16 y2,int radius,Uint32 pixel)
+{
+  radius = raster_normalize(&x1,&y1,&x2,&y2,radius);
+  corner_mask *mask = NULL;
+  if ( radius > 0 && ( mask = raster_get_mask(radius) ) == NULL ) {
+    return 0;
+  }
+  // rows between the corners are a single rectangle
+  SDL_Rect middle = { x1, y1 + radius, x2 - x1 + 1, y2 - y1 + 1 - 2 * radius };
+  if ( SDL_FillRect(surface,&middle,pixel) != 0 ) {
+    return 0;
+  }
+  if ( mask == NULL ) {
+    return 1;
+  }
+  if ( ! raster_lock(surface) ) {
+    return 0;
+  }
+  for ( int row = 0 ; row < radius ; row++ )
+  {
+    int inset = mask->inset[row];
+    raster_hline(surface,x1 + inset,x2 - inset,y1 + row,pixel);
+    raster_hline(surface,x1 + inset,x2 - inset,y2 - row,pixel);
+  }
+  raster_unlock(surface);
+  return 1;
+}
+
+int raster_draw_rounded_rect(SDL_Surface *surface,Sint16 x1,Sint16 y1,Sint16 x2,Sint16 y2,int radius,Uint32 pixel)
+{
+  radius = raster_normalize(&x1,&y1,&x2,&y2,radius);
+  corner_mask *mask = NULL;
+  if ( radius > 0 && ( mask = raster_get_mask(radius) ) == NULL ) {
+    return 0;
+  }
+  if ( ! raster_lock(surface) ) {
+    return 0;
+  }
+  // top and bottom edge
+  int inset = mask ? mask->inset[0] : 0;
+  raster_hline(surface,x1 + inset,x2 - inset,y1,pixel);
+  raster_hline(surface,x1 + inset,x2 - inset,y2,pixel);
+
+  // corners
+  for ( int row = 1 ; row < radius ; row++ )
+  {
+    int start = mask->inset[row];
+    int end = start + mask->outline[row] - 1;
+    raster_hline(surface,x1 + start,x1 + end,y1 + row,pixel);
+    raster_hline(surface,x2 - end,x2 - start,y1 + row,pixel);
+    raster_hline(surface,x1 + start,x1 + end,y2 - row,pixel);
+    raster_hline(surface,x2 - end,x2 - start,y2 - row,pixel);
+  }
+
+  // left and right edge
+  int edge = max(radius,1);
+  raster_vline(surface,x1,y1 + edge,y2 - edge,pixel);
+  raster_vline(surface,x2,y1 + edge,y2 - edge,pixel);
+  raster_unlock(surface);
+  return 1;
+}
+
+void raster_close(void)
+{
+  for ( int i = 0 ; i <= RASTER_MAX_RADIUS ; i++ )
+  {
+    free(cornerMasks[i]);
+    cornerMasks[i] = NULL;
+  }
+}
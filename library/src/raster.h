@@ -0,0 +1,60 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Opaque primitives that write pixels in the surface's native format, used instead of
+ * SDL_gfx where the color is always opaque.
+ *
+ * Colors are passed as pixel values mapped with SDL_MapRGB(). Coordinates are inclusive
+ * like in SDL_gfx, so both produce the same pixels. Drawing is clipped to the clip
+ * rectangle of the surface.
+ *
+ * The shape of a rounded corner only depends on its radius and is computed once
+ * per radius: for each row of the corner the number of pixels left out (inset) and
+ * the length of the outline. Rows are then drawn as spans.
+ *
+ * May be called from any thread, as long as a surface is only drawn onto by one thread at a time.
+ */
+
+// larger radii get reduced to this one
+#define RASTER_MAX_RADIUS 255
+
+/**
+ * Fills a box with rounded corners.
+ * The radius gets reduced if the box is too small for it, like with roundedBoxRGBA().
+ *
+ * @param surface
+ * @param x1 left
+ * @param y1 top
+ * @param x2 right (inclusive)
+ * @param y2 bottom (inclusive)
+ * @param radius corner radius, 0 for a plain box
+ * @param pixel color mapped to the surface's format
+ * @return 0 on error, otherwise success
+ */
+int raster_fill_rounded_box(SDL_Surface *surface,Sint16 x1,Sint16 y1,Sint16 x2,Sint16 y2,int radius,Uint32 pixel);
+
+/**
+ * Draws the one pixel wide outline of a box with rounded corners.
+ * The radius gets reduced if the box is too small for it, like with roundedRectangleRGBA().
+ *
+ * @param surface
+ * @param x1 left
+ * @param y1 top
+ * @param x2 right (inclusive)
+ * @param y2 bottom (inclusive)
+ * @param radius corner radius, 0 for a plain rectangle
+ * @param pixel color mapped to the surface's format
+ * @return 0 on error, otherwise success
+ */
+int raster_draw_rounded_rect(SDL_Surface *surface,Sint16 x1,Sint16 y1,Sint16 x2,Sint16 y2,int radius,Uint32 pixel);
+
+/**
+ * Frees the cached corner shapes.
+ * Must not be called while any thread is drawing.
+ */
+void raster_close(void);
+
+#endif
@@ -1,3 +1,5 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
 #include "render.h"
 #include "SDL/SDL.h"
 #include "SDL/SDL_ttf.h"
@@ -13,25 +15,71 @@
 #include <stdarg.h>
 #include "atomic.h"
 #include "global.h"
+#include "labelcache.h"
+#include "mempool.h"
+#include "profiler.h"
+#include "mboxstats.h"
+#include "memstats.h"
+#include "trace.h"
+#include "display.h"
+#include "animation.h"
+#include "layout.h"
+#include "raster.h"
+#include "blend.h"
+#include "rowpool.h"
+#include "imageloader.h"
+#include "imagecache.h"
+#include "bundle.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdint.h>
 
 SDL_Surface* scrMain = NULL;
 
 static TTF_Font* font = NULL;
 
+static const display_backend *display = NULL;
+
+// estimated number of bytes occupied by the font
+static long fontSize = 0;
+
+// asset bundle to open on init or NULL
+static char *bundlePath = NULL;
+
+// number of row workers to start on init, RENDER_ROW_WORKERS_AUTO for one per additional CPU core
+static int rowWorkerCount = RENDER_ROW_WORKERS_AUTO;
+
+// fonts of the row workers, SDL_ttf fonts must not be used by several threads at the same time
+static TTF_Font *workerFonts[ROWPOOL_MAX_WORKERS];
+static long workerFontSize = 0;
+
+// surfaces list view items are rendered into before they get composited, one per job of a batch
+#define RENDER_MAX_ROW_JOBS 32
+static SDL_Surface *rowSurfaces[RENDER_MAX_ROW_JOBS];
+
 static int initFlags = 0;
 
 static viewport_desc viewportInfo = {0};
 
 static volatile pthread_t renderingThreadId;
 
-// rendering thread init stuff
-static pthread_cond_t init_condition = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
+// rendering thread init stuff, signalled once render_init_render_internal() returned
+static int initCompleted = 0;
 
 static volatile int initResult = 0;
 
 static volatile const char *lastRenderError;
 
+// profiler overlay 
+#define HUD_WIDTH 144
+#define HUD_HEIGHT 40
+#define HUD_UPDATE_INTERVAL_MICROS 250000
+
+static int hudEnabled = 0;
+static int hudEnabledProfiler = 0; // profiler was off when the overlay got enabled
+static long hudLastUpdate = 0;
+static char hudLines[2][32];
+
 typedef struct render_text_args {
   const char *text;
   int x;
@@ -43,7 +91,16 @@ typedef struct render_text_args {
 
 static pthread_mutex_t mbox_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-#define MBOX_FLAG_FREED_BY_CREATOR 1<<0
+// frame pacing of the rendering thread
+#define RENDER_FRAME_INTERVAL_MICROS 16666
+// touch input can't wake up the rendering thread so it needs to be polled even if the UI is idle
+#define RENDER_IDLE_POLL_INTERVAL_MICROS 33333
+
+// signalled whenever an entry gets posted so an idle rendering thread wakes up immediately
+static pthread_cond_t mbox_condition = PTHREAD_COND_INITIALIZER;
+
+// the entry belongs to a caller awaiting completion and must not be freed
+#define MBOX_FLAG_SYNCHRONOUS 1<<0
 
 typedef struct mbox_entry 
 {
@@ -51,18 +108,94 @@ typedef struct mbox_entry
   struct mbox_entry *prev;
   RenderCallback func;
   int flags;
-  pthread_cond_t *finished_condition;
-  pthread_mutex_t *finished_mutex;  
+  int completed; // completion the caller waits on (synchronous calls only)
   void *data;
   void *result;
+  long enqueueMicros;
 } mbox_entry;
 
 static mbox_entry *mbox_first = NULL;
 static mbox_entry *mbox_last = NULL;
+static volatile int mbox_depth = 0; // number of pending entries, guarded by mbox_mutex
+
+// pools for long-lived objects
+static slab_pool mboxPool = SLAB_POOL_INITIALIZER("mbox_entry",mbox_entry,32);
+// a thread waits for its synchronous calls, so it never has more than one of them pending
+static __thread mbox_entry syncEntry;
+static slab_pool elementPool = SLAB_POOL_INITIALIZER("ui_element",ui_element,32);
+static slab_pool buttonPool = SLAB_POOL_INITIALIZER("button_entry",button_entry,32);
+static slab_pool listviewPool = SLAB_POOL_INITIALIZER("listview_entry",listview_entry,8);
+static slab_pool containerPool = SLAB_POOL_INITIALIZER("container_entry",container_entry,8);
+static slab_pool progressbarPool = SLAB_POOL_INITIALIZER("progressbar_entry",progressbar_entry,4);
+
+// transient objects that only live until the current frame got flushed
+static frame_arena frameArena = FRAME_ARENA_INITIALIZER;
+
+// scene graph, only accessed by the rendering thread
+static container_entry screenContainer;
+static ui_element screen; // root of the scene graph, parent of all top-level elements
+
+// progress bars that are part of the scene graph
+static ui_element *progressBars = NULL;
+
+// max. number of disjoint rectangles tracked before falling back to the whole screen
+#define RENDER_MAX_DAMAGE_RECTS 16
+
+typedef struct rect_list 
+{
+  SDL_Rect rects[RENDER_MAX_DAMAGE_RECTS];
+  int count;
+  int overflow; // too many rectangles, the whole screen is affected
+} rect_list;
+
+// regions that need to be repainted at the end of the frame
+static rect_list damagedRegions;
+
+// regions of the screen that changed during the current frame
+static rect_list flushRegions = { {{0}}, 0, 1 };
+
+// pages (see render_add_page()), only accessed by the rendering thread
+#define PAGE_STATE_HIDDEN 0 // not on screen, changes get painted onto the off-screen surface
+#define PAGE_STATE_LIVE 1 // the active page, painted onto the screen like any other container
+#define PAGE_STATE_CACHED 2 // on screen during a transition, painted by blitting the off-screen surface
+
+typedef struct page_entry 
+{
+  int state; // PAGE_STATE_xxx
+  SDL_Surface *surface; // up to date unless the page is live
+  rect_list damage; // regions of the surface that need to be repainted, in page coordinates
+} page_entry;
+
+static slab_pool pagePool = SLAB_POOL_INITIALIZER("page_entry",page_entry,4);
+
+// pages the user navigated through, the last one is the active page
+static ui_element *pageStack[RENDER_MAX_PAGE_DEPTH];
+static int pageStackSize = 0;
+
+typedef struct page_transition 
+{
+  ui_element *from; // NULL if no page was active
+  ui_element *to;
+  int animationId; // 0 for a switch without animation
+  int completed; // the last frame of the transition is being painted
+} page_transition;
+
+// only one transition runs at a time
+static page_transition transition;
+
+static void render_register_callback_names(void);
+static void render_add_rect(rect_list *list,SDL_Rect *rect);
+static void render_add_flush_rect(SDL_Rect *rect);
+static int render_rects_intersect(rect_list *list,SDL_Rect *rect);
+static void render_clear_rects(rect_list *list);
+static void render_repaint_damaged_regions(void);
+static void render_update_progressbars(void);
+static void render_repaint_pages(void);
+static void render_end_page_transition(void);
 
 ui_element *render_allocate_element(UIElementType type) 
 {
-  ui_element *element = calloc(1,sizeof(ui_element));
+  ui_element *element = slab_alloc(&elementPool);
   if ( ! element ) {
     log_error("ui_allocate_element(): Failed to allocate memory");      
     return NULL;  
@@ -76,21 +209,69 @@ ui_element *render_allocate_element(UIElementType type)
   return element;
 }
 
+/**
+ * Allocates a zero-initialized button entry.
+ * @return button entry or NULL on OOM
+ */
+button_entry *render_allocate_button_entry(void) 
+{
+  return slab_alloc(&buttonPool);
+}
+
+/**
+ * Allocates a zero-initialized listview entry.
+ * @return listview entry or NULL on OOM
+ */
+listview_entry *render_allocate_listview_entry(void) 
+{
+  return slab_alloc(&listviewPool);
+}
+
+static void *render_release_button_image_internal(void *data) 
+{
+  ui_element *element = data;
+  button_entry *button = element->button;
+  if ( button->imageEntry ) {
+    imagecache_release(button->imageEntry,element);
+    button->imageEntry = NULL;
+  }
+  button->image = NULL;
+  return (void*) (intptr_t) 1;
+}
+
 /**
  * Frees all memory associated with a button entry.
  * 
- * @param entry entry to free
+ * @param element button to free the entry of
  */
-static void render_free_button_entry(button_entry *entry) 
+static void render_free_button_entry(ui_element *element) 
 {
-  if ( entry->image ) 
-  {
-    render_free_surface(entry->image);
+  button_entry *entry = element->button;
+  if ( entry->text == NULL ) {
+    render_exec_on_thread(render_release_button_image_internal,element,1);
   }
   if ( entry->text ) {
     free(entry->text);
   }
-  free(entry);   
+  slab_free(&buttonPool,entry);
+}
+
+/**
+ * Allocates a zero-initialized container entry.
+ * @return container entry or NULL on OOM
+ */
+container_entry *render_allocate_container_entry(void) 
+{
+  return slab_alloc(&containerPool);
+}
+
+/**
+ * Allocates a zero-initialized progress bar entry.
+ * @return progress bar entry or NULL on OOM
+ */
+progressbar_entry *render_allocate_progressbar_entry(void) 
+{
+  return slab_alloc(&progressbarPool);
 }
 
 /**
@@ -99,32 +280,49 @@ static void render_free_button_entry(button_entry *entry)
  */
 static void render_free_listview_entry(listview_entry *listview) 
 {
-  free(listview);  
+  if ( listview->labelCache ) {
+    labelcache_free(listview->labelCache);
+  }
+  if ( listview->surface ) {
+    render_free_surface(listview->surface,MEM_CATEGORY_LISTVIEW_SURFACES);
+  }
+  slab_free(&listviewPool,listview);
 }
 
+static void *render_detach_element_internal(void *data);
+
 /**
  * Frees all memory associated with a UI element.
  * @param element
  */
 void render_free_element(ui_element *current) 
 {
+  if ( current->parent ) {
+    render_exec_on_thread(render_detach_element_internal,current,1);
+  }
   if ( current -> elementData ) 
   {
     switch( current->type ) 
     {
       case UI_BUTTON:
-        render_free_button_entry( current->button );        
+        render_free_button_entry( current );        
         break;        
       case UI_TEXTFIELD:
         break;        
       case UI_LISTVIEW:
         render_free_listview_entry( current->listview );
         break;
+      case UI_CONTAINER:
+        slab_free( &containerPool, current->container );
+        break;
+      case UI_PROGRESSBAR:
+        slab_free( &progressbarPool, current->progressbar );
+        break;
       default:
         log_error("ui_free_all(): Don't know how to free type %d",current->type);
     }
   }
-  free(current);
+  slab_free(&elementPool,current);
 }
 
 void render_error(const char* msg,...) 
@@ -169,31 +367,28 @@ void render_assert_rendering_thread(void) {
 void *render_exec_on_thread(RenderCallback callback,void *data,int awaitCompletion) 
 {
   void *result = 0;
-  pthread_cond_t finished_condition;
-  pthread_mutex_t finished_mutex;     
   
   log_debug("exec_on_thread() called");   
   if ( render_is_on_rendering_thread() ) {
     return callback(data);
   }
   
-  // allocate memory for mail box entry
-  mbox_entry *newEntry = calloc(1,sizeof(mbox_entry));
-  if ( newEntry == NULL ) {
-    return 0;  
-  }
+  // synchronous calls reuse the entry of the calling thread
+  mbox_entry *newEntry;
   if ( awaitCompletion ) 
   {
-    newEntry->flags |= MBOX_FLAG_FREED_BY_CREATOR;   
-    
-    render_init_condition(&finished_mutex,&finished_condition);
-    
-    newEntry->finished_condition = &finished_condition;
-    newEntry->finished_mutex = &finished_mutex;      
+    newEntry = &syncEntry;
+    memset(newEntry,0,sizeof(mbox_entry));
+    newEntry->flags |= MBOX_FLAG_SYNCHRONOUS;
+  } 
+  else if ( ( newEntry = slab_alloc(&mboxPool) ) == NULL ) {
+    return 0;  
   }
   
+  long traceStart = trace_begin();
   newEntry->func = callback;
   newEntry->data = data;
+  newEntry->enqueueMicros = profiler_now_micros();
 
   // insert 
   pthread_mutex_lock(&mbox_mutex);
@@ -209,6 +404,9 @@ void *render_exec_on_thread(RenderCallback callback,void *data,int awaitCompleti
     newEntry->prev=mbox_last;
     mbox_last = newEntry;
   }
+  mbox_depth++;
+  mboxstats_record_depth(mbox_depth);
+  pthread_cond_signal(&mbox_condition);
   
   pthread_mutex_unlock(&mbox_mutex);   
   
@@ -216,12 +414,12 @@ void *render_exec_on_thread(RenderCallback callback,void *data,int awaitCompleti
   {
     log_debug("Awaiting callback completion ...\n");
     
-    render_wait_condition(&finished_mutex,&finished_condition);
+    render_completion_wait(&newEntry->completed);
     
     log_debug("Callback completed.\n");      
     result = newEntry->result;
-    free( newEntry );
   }
+  trace_end_callback("caller",callback,traceStart);
   return result;
 }
 
@@ -244,19 +442,57 @@ mbox_entry *render_poll_mbox(void)
       mbox_last = entry->prev;
       mbox_last->next=NULL;
     }
+    mbox_depth--;
   }  
   pthread_mutex_unlock(&mbox_mutex); 
   
   return entry;
 }
 
+/**
+ * Blocks until a mailbox entry gets posted or the timeout expires.
+ * 
+ * @param timeoutMicros max. time to wait
+ */
+static void render_wait_for_mbox(long timeoutMicros) 
+{
+  if ( timeoutMicros <= 0 ) {
+    return;
+  }
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME,&deadline);
+  deadline.tv_sec += timeoutMicros / 1000000;
+  deadline.tv_nsec += (timeoutMicros % 1000000) * 1000;
+  if ( deadline.tv_nsec >= 1000000000 ) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+  pthread_mutex_lock(&mbox_mutex);
+  if ( mbox_first == NULL ) {
+    pthread_cond_timedwait(&mbox_condition,&mbox_mutex,&deadline);
+  }
+  pthread_mutex_unlock(&mbox_mutex);
+}
+
+/**
+ * Wakes up the rendering thread if it is waiting for mailbox entries.
+ */
+static void render_wake(void) 
+{
+  pthread_mutex_lock(&mbox_mutex);
+  pthread_cond_signal(&mbox_condition);
+  pthread_mutex_unlock(&mbox_mutex);
+}
+
 /**
  * Returns whether the rendering system was initialized.
  * @return 
  */
 int render_is_initialized(void) 
 {
-  if ( initFlags == (RENDER_FLAG_SDL_INIT | RENDER_FLAG_TTF_INIT | RENDER_FLAG_TTF_FONT_LOADED) ) {
+  // the font may only get loaded on demand
+  int required = RENDER_FLAG_DISPLAY_INIT | RENDER_FLAG_TTF_INIT;
+  if ( (initFlags & required) == required ) {
     return 1;
   }
   return 0;
@@ -266,14 +502,15 @@ int render_is_initialized(void)
  * Fills out a viewport description
  * @return 
  */
-static int render_get_viewport_desc_internal(viewport_desc *port) 
+static void *render_get_viewport_desc_internal(void *data) 
 {
+  viewport_desc *port = data;
   log_debug("get_viewport_desc_internal() called");   
   port->width = viewportInfo.width;
   port->height = viewportInfo.height;
   port->bitsPerPixel = viewportInfo.bitsPerPixel;
   render_success();  
-  return 1;  
+  return (void*) (intptr_t) 1;  
 }
 
 /**
@@ -283,13 +520,86 @@ static int render_get_viewport_desc_internal(viewport_desc *port)
 int render_get_viewport_desc(viewport_desc *port) 
 {
   log_debug("get_viewport_desc() called");  
-  return (int) render_exec_on_thread(&render_get_viewport_desc_internal,port,1); 
+  return (int) (intptr_t) render_exec_on_thread(&render_get_viewport_desc_internal,port,1); 
+}
+
+/**
+ * Closes the fonts of the row workers and frees the row surfaces.
+ */
+static void render_stop_row_workers(void) 
+{
+  rowpool_stop();
+  for ( int i = 0 ; i < ROWPOOL_MAX_WORKERS ; i++ ) 
+  {
+    if ( workerFonts[i] ) {
+      TTF_CloseFont(workerFonts[i]);
+      memstats_remove(MEM_CATEGORY_FONTS,workerFontSize);
+      workerFonts[i] = NULL;
+    }
+  }
+  for ( int i = 0 ; i < RENDER_MAX_ROW_JOBS ; i++ ) 
+  {
+    if ( rowSurfaces[i] ) {
+      render_free_surface(rowSurfaces[i],MEM_CATEGORY_LISTVIEW_SURFACES);
+      rowSurfaces[i] = NULL;
+    }
+  }
+}
+
+/**
+ * Restarts the row workers, opening a font for each of them unless the glyphs come from the asset bundle.
+ * @param count number of workers or RENDER_ROW_WORKERS_AUTO
+ * @return 0 if fewer workers were started, otherwise success
+ */
+static void *render_start_row_workers_internal(void *count) 
+{
+  int workerCount = (int) (intptr_t) count;
+  if ( workerCount == RENDER_ROW_WORKERS_AUTO ) {
+    workerCount = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+  workerCount = max( min(workerCount,ROWPOOL_MAX_WORKERS), 0 );
+  
+  render_stop_row_workers();
+  struct stat fontStat;
+  workerFontSize = stat(FONT_PATH,&fontStat) == 0 ? fontStat.st_size : 0;
+  int result = 1;
+  for ( int i = 0 ; i < workerCount && ! bundle_has_font(FONT_PATH,FONT_SIZE) ; i++ ) 
+  {
+    workerFonts[i] = TTF_OpenFont(FONT_PATH,FONT_SIZE);
+    if ( workerFonts[i] == NULL ) {
+      log_warn("render_start_row_workers(): Failed to load font for row worker %d: %s",i,TTF_GetError());
+      workerCount = i;
+      result = 0;
+      break;
+    }
+    memstats_add(MEM_CATEGORY_FONTS,workerFontSize);
+  }
+  if ( ! rowpool_start(workerCount,(void**) workerFonts) ) {
+    result = 0;
+  }
+  initFlags |= RENDER_FLAG_ROW_WORKERS_STARTED;
+  return (void*) (intptr_t) result;
 }
 
-static int render_close_render_internal(void *dummy) 
+static void *render_close_render_internal(void *dummy) 
 {
   log_debug("close_render_internal() called");
   
+  if ( initFlags & RENDER_FLAG_IMAGE_WORKERS_STARTED ) {
+    imagecache_clear();
+    imageloader_stop();
+  }
+  
+  // worker fonts need to be closed before TTF_Quit()
+  if ( initFlags & RENDER_FLAG_ROW_WORKERS_STARTED ) {
+    render_stop_row_workers();
+  }
+  
+  // icons from the bundle are gone with the image cache
+  if ( initFlags & RENDER_FLAG_BUNDLE_OPENED ) {
+    bundle_close();
+  }
+  
   // close IMG_INIT_PNG
   if ( initFlags & RENDER_FLAG_PNG_INITIALIZED ) {
     IMG_Quit();
@@ -298,6 +608,8 @@ static int render_close_render_internal(void *dummy)
   // close font
   if ( initFlags & RENDER_FLAG_TTF_FONT_LOADED) {
     TTF_CloseFont(font);
+    memstats_remove(MEM_CATEGORY_FONTS,fontSize);
+    fontSize = 0;
   }
 
   // Close down TTF
@@ -305,48 +617,135 @@ static int render_close_render_internal(void *dummy)
     TTF_Quit();
   }
 
-  // Close down SDL
-  if ( initFlags & RENDER_FLAG_SDL_INIT ) {
-    SDL_Quit();
+  // Close down display
+  if ( initFlags & RENDER_FLAG_DISPLAY_INIT ) {
+    display->shutdown();
+    scrMain = NULL;
   }
   initFlags = 0;
+  arena_destroy(&frameArena);
+  raster_close();
   render_success();
-  return 1;
+  return (void*) (intptr_t) 1;
 }
 
 void render_close_render(void) {
   render_exec_on_thread(&render_close_render_internal,NULL,1); 
 }
 
-void render_free_render_text_args(render_text_args *args) {
-  free(args->text);
-  free(args);
+/**
+ * Returns the TTF font, loading it on first use.
+ * Text is only rendered through SDL_ttf if the asset bundle holds no glyphs for the font.
+ * 
+ * @return font or NULL on error
+ */
+static TTF_Font *render_get_font(void) 
+{
+  if ( initFlags & RENDER_FLAG_TTF_FONT_LOADED ) {
+    return font;
+  }
+  font = TTF_OpenFont(FONT_PATH, FONT_SIZE);
+  if ( ! font ) {
+    render_error("Failed to load TTF font %s. %s",FONT_PATH,TTF_GetError());
+    return NULL;
+  }
+  initFlags |= RENDER_FLAG_TTF_FONT_LOADED;
+  
+  // SDL_ttf does not expose how much memory a font occupies, use the file size as estimate
+  struct stat fontStat;
+  fontSize = stat(FONT_PATH,&fontStat) == 0 ? fontStat.st_size : 0;
+  memstats_add(MEM_CATEGORY_FONTS,fontSize);
+  return font;
 }
 
-static int render_render_text_onto_internal(SDL_Surface *surface,render_text_args *args) 
+int render_size_text(const char *text,int *width,int *height) 
+{
+  if ( bundle_has_font(FONT_PATH,FONT_SIZE) ) {
+    return bundle_size_text(text,width,height);
+  }
+  TTF_Font *ttfFont = render_get_font();
+  return ttfFont && TTF_SizeText(ttfFont,text,width,height) == 0;
+}
+
+/**
+ * Renders text with a TTF font, may be called from any thread as long 
+ * as no other thread uses the font at the same time.
+ * 
+ * @param surface
+ * @param ttfFont
+ * @param text
+ * @param x
+ * @param y
+ * @param color
+ * @param drawn receives the area drawn
+ * @return 0 on error, otherwise success
+ */
+static int render_ttf_text_onto(SDL_Surface *surface,TTF_Font *ttfFont,const char *text,int x,int y,SDL_Color color,SDL_Rect *drawn) 
 {
-  SDL_Surface* textSurface = TTF_RenderText_Solid(font, args->text, args->color);
-  SDL_Rect dstRect = {args->x,args->y,textSurface->w,textSurface->h};
+  SDL_Surface* textSurface = TTF_RenderText_Solid(ttfFont, text, color);
+  if ( ! textSurface ) {
+    return 0;
+  }
+  long textSize = memstats_surface_size(textSurface);
+  memstats_add(MEM_CATEGORY_TEXT,textSize);
+  
+  SDL_Rect dstRect = {x,y,textSurface->w,textSurface->h};
   SDL_BlitSurface(textSurface, NULL, surface, &dstRect );  
+  *drawn = dstRect;
   
   SDL_FreeSurface(textSurface);
+  memstats_remove(MEM_CATEGORY_TEXT,textSize);
+  return 1;
+}
+
+static int render_render_text_onto_internal(SDL_Surface *surface,render_text_args *args) 
+{
+  SDL_Rect textRect;
+  if ( bundle_has_font(FONT_PATH,FONT_SIZE) && bundle_render_text(surface,args->text,args->x,args->y,args->color,&textRect) ) 
+  {
+    if ( surface == scrMain ) {
+      render_add_flush_rect(&textRect);
+    }
+    render_success();
+    return 1;
+  }
   
-  render_free_render_text_args(args);
+  TTF_Font *ttfFont = render_get_font();
+  if ( ! ttfFont ) {
+    return 0;
+  }
+  if ( ! render_ttf_text_onto(surface,ttfFont,args->text,args->x,args->y,args->color,&textRect) ) {
+    render_error("TTF_RenderText_Solid() failed: %s",TTF_GetError());
+    return 0;
+  }
+  if ( surface == scrMain ) {
+    render_add_flush_rect(&textRect);
+  }
   
   render_success();  
   return 1;
 } 
 
-static int render_render_text_internal(render_text_args *args) 
+static void *render_render_text_internal(void *data) 
 {
-  return render_render_text_onto_internal(scrMain,args);
+  render_text_args *args = data;
+  int result = render_render_text_onto_internal(scrMain,args);
+  free(args);
+  return (void*) (intptr_t) result;
 }  
 
 void render_render_text(const char *text,int x,int y,SDL_Color color) 
 {
-  render_text_args *args = calloc(1,sizeof(render_text_args));
+  // text gets copied right behind the arguments so we only need a single allocation
+  size_t len = strlen(text)+1;
+  render_text_args *args = mem_calloc(1,sizeof(render_text_args)+len);
+  if ( args == NULL ) {
+    render_error("render_render_text(): Failed to alloc memory for render_text_args");
+    return;
+  }
+  memcpy( (char*) (args+1), text, len);
   
-  args->text=strdup(text);
+  args->text=(char*) (args+1);
   args->x=x;
   args->y=y;
   memcpy(&args->color,&color,sizeof(SDL_Color));
@@ -361,45 +760,30 @@ static int render_init_render_internal(void)
   // Initialization
   // --------------------------------------
 
-#ifdef USE_FB
- // Update the environment variables for SDL to
- // work correctly with the external display on
- // LINUX frame buffer 1 (fb1).
- putenv((char*)"FRAMEBUFFER=/dev/fb1");
- putenv((char*)"SDL_FBDEV=/dev/fb1");
-#endif
-
-  // Initialize SDL
-  if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-    render_error("SDL_Init() failed: %s",SDL_GetError());
-    render_close_render();
-    return 0;
-  }
-  initFlags |= RENDER_FLAG_SDL_INIT;
+  viewportInfo.width = 320;
+  viewportInfo.height = 240;
+  viewportInfo.bitsPerPixel = 16;
 
-  // Fetch the best video mode
-  // - Note that the Raspberry Pi generally defaults
-  //   to a 16bits/pixel framebuffer
-  const SDL_VideoInfo* vInfo = SDL_GetVideoInfo();
-  if (!vInfo) {
-    render_error("SDL_GetVideoInfo() failed: %s",SDL_GetError());
-    render_close_render();
-    return 0;
+  if ( display == NULL ) {
+    display = display_get_backend(DISPLAY_BACKEND_SDL);
   }
+  log_info("Using display backend '%s'",display->name);
   
-  viewportInfo.width = 320; // vInfo->current_w;
-  viewportInfo.height = 240; // vInfo->current_h;
-  viewportInfo.bitsPerPixel = 16; // vInfo->vfmt->BitsPerPixel;
-
-  // Configure the video mode
-  // - SDL_SWSURFACE appears to be most robust mode
-  int     nFlags = SDL_SWSURFACE;
-  scrMain = SDL_SetVideoMode(viewportInfo.width,viewportInfo.height,viewportInfo.bitsPerPixel,nFlags);
-  if (scrMain == 0) {
-    render_error("SDL_SetVideoMode() failed: %s",SDL_GetError());
+  // shutdown() also needs to be invoked if init() failed half-way
+  initFlags |= RENDER_FLAG_DISPLAY_INIT;
+  if ( ! display->init(viewportInfo.width,viewportInfo.height,viewportInfo.bitsPerPixel) ) {
+    render_error("Failed to initialize display backend '%s'",display->name);
     render_close_render();
     return 0;
   }
+  scrMain = display->get_back_buffer();
+  
+  // root of the scene graph covers the whole screen
+  screen.type = UI_CONTAINER;
+  screen.container = &screenContainer;
+  screen.bounds.w = viewportInfo.width;
+  screen.bounds.h = viewportInfo.height;
+  ASSIGN_COLOR(&screen.backgroundColor,0,0,0);
 
   // --------------------------------------
   // Setup TTF
@@ -413,13 +797,23 @@ static int render_init_render_internal(void)
   
   initFlags |= RENDER_FLAG_TTF_INIT;  
 
-  font = TTF_OpenFont(FONT_PATH, FONT_SIZE);
-  if ( ! font ) {
-    render_error("Failed to load TTF font %s. %s",FONT_PATH,TTF_GetError());
+  // a missing or outdated bundle only costs startup time, everything can still be loaded from the original files
+  if ( bundlePath ) 
+  {
+    if ( bundle_open(bundlePath) ) {
+      initFlags |= RENDER_FLAG_BUNDLE_OPENED;
+    } else {
+      log_warn("Failed to open asset bundle %s, loading fonts and images from their files",bundlePath);
+    }
+  }
+  
+  if ( ! bundle_has_font(FONT_PATH,FONT_SIZE) && ! render_get_font() ) {
     render_close_render();
     return 0;
   }
-  initFlags |= RENDER_FLAG_TTF_FONT_LOADED;
+  
+  memstats_set_evictor(MEM_CATEGORY_LABEL_CACHE,labelcache_evict);
+  memstats_set_evictor(MEM_CATEGORY_IMAGES,imagecache_evict);
   
   // ----------------
   // Setup SDL Image
@@ -435,18 +829,143 @@ static int render_init_render_internal(void)
   }
   initFlags |= RENDER_FLAG_PNG_INITIALIZED;
   
+  if ( ! imageloader_start() ) {
+    render_error("Failed to start image loader");
+    render_close_render();
+    return 0;
+  }
+  initFlags |= RENDER_FLAG_IMAGE_WORKERS_STARTED;
+  
+  // rendering still works on this thread only if the workers can't be started
+  render_start_row_workers_internal((void*) (intptr_t) rowWorkerCount);
+  
   render_success();
   
   return 1;
 }
 
+/**
+ * Draws frame time, the most expensive phase and the
+ * mailbox depth of the last completed frame into
+ * the top-right corner of the screen.
+ * 
+ * The text is updated every HUD_UPDATE_INTERVAL_MICROS, in between
+ * the overlay only gets redrawn if something painted over it.
+ */
+static void render_draw_profiler_hud_internal(void) 
+{
+  frame_profile frame;
+  
+  SDL_Rect hudRect = { viewportInfo.width - HUD_WIDTH, 0, HUD_WIDTH, HUD_HEIGHT };
+  
+  long now = profiler_now_micros();
+  if ( now - hudLastUpdate >= HUD_UPDATE_INTERVAL_MICROS && profiler_get_frames(&frame,1) ) 
+  {
+    hudLastUpdate = now;
+    
+    int worstPhase = 0;
+    for ( int i = 1 ; i < PROFILE_PHASE_COUNT ; i++ ) 
+    {
+      if ( frame.phaseMicros[i] > frame.phaseMicros[worstPhase] ) {
+        worstPhase = i;
+      }
+    }
+    snprintf(hudLines[0],sizeof(hudLines[0]),"%ld.%ldms q:%d",frame.totalMicros/1000,(frame.totalMicros%1000)/100,frame.mailboxDepth);
+    snprintf(hudLines[1],sizeof(hudLines[1]),"%s %ld.%ldms",profiler_get_phase_name(worstPhase),frame.phaseMicros[worstPhase]/1000,(frame.phaseMicros[worstPhase]%1000)/100);
+  } 
+  else if ( ! render_rects_intersect(&flushRegions,&hudRect) ) {
+    return;
+  }
+  if ( hudLines[0][0] == 0 ) {
+    return;
+  }
+  
+  Sint16 x = hudRect.x;
+  boxRGBA(scrMain,x,0,x+HUD_WIDTH-1,HUD_HEIGHT-1,0,0,0,255);
+  render_add_flush_rect(&hudRect);
+  
+  render_text_args text = { hudLines[0], x+2, 1, {255,255,0} };
+  render_render_text_onto_internal(scrMain,&text);
+  text.text = hudLines[1];
+  text.y += HUD_HEIGHT/2;
+  render_render_text_onto_internal(scrMain,&text);
+}
+
+static void *render_set_profiler_hud_internal(void *enable) 
+{
+  if ( hudEnabled && enable == NULL ) 
+  {
+    // repaint what the overlay covered
+    SDL_Rect hudRect = { viewportInfo.width - HUD_WIDTH, 0, HUD_WIDTH, HUD_HEIGHT };
+    render_add_rect(&damagedRegions,&hudRect);
+    if ( hudEnabledProfiler ) {
+      profiler_set_enabled(0);
+      hudEnabledProfiler = 0;
+    }
+  }
+  if ( ! hudEnabled && enable != NULL && ! profiler_is_enabled() ) 
+  {
+    profiler_set_enabled(1);
+    hudEnabledProfiler = 1;
+  }
+  hudEnabled = enable != NULL;
+  hudLastUpdate = 0;
+  hudLines[0][0] = 0;
+  return (void*) (intptr_t) 1;
+}
+
+/**
+ * Enables/disables the profiler overlay.
+ * Enabling the overlay also enables the profiler, disabling it turns
+ * the profiler off again unless it was on before.
+ * 
+ * @param enabled
+ */
+void render_set_profiler_hud(int enabled) 
+{
+  render_exec_on_thread(render_set_profiler_hud_internal,enabled ? (void*) 1 : NULL,1);
+}
+
+/**
+ * Lays out elements whose size changed, repaints invalidated regions, flushes the parts of the screen that changed
+ * during this frame and discards all transient per-frame allocations.
+ * Must be called on the rendering thread.
+ */
+void render_present_frame(void) 
+{
+  layout_run(&screen);
+  render_update_progressbars();
+  render_repaint_pages();
+  render_repaint_damaged_regions();
+  if ( transition.completed ) {
+    render_end_page_transition();
+  }
+  if ( hudEnabled ) {
+    render_draw_profiler_hud_internal();
+  }
+  
+  profiler_begin_phase(PROFILE_PHASE_FLUSH);
+  long traceStart = trace_begin();
+  if ( flushRegions.overflow ) {
+    display->flush(NULL,0);
+  } else if ( flushRegions.count > 0 ) {
+    display->flush(flushRegions.rects,flushRegions.count);
+  }
+  render_clear_rects(&flushRegions);
+  trace_end("frame","flip",traceStart,TRACE_NO_ARG);
+  profiler_end_phase(PROFILE_PHASE_FLUSH);
+  arena_reset(&frameArena);
+  memstats_enforce_budgets();
+}
+
 void *render_main_event_loop(void* data) 
 {
   TouchEvent touchEvent;
   
+  trace_set_thread_name("render");
   initResult = render_init_render_internal();
 
-  render_signal_condition(&init_mutex,&init_condition);
+  render_completion_signal(&initCompleted);
   
   if ( ! initResult ) {
     render_error("init_render_internal() failed");        
@@ -458,10 +977,22 @@ void *render_main_event_loop(void* data)
   int terminate = 0;
   while ( ! terminate ) 
   {
+    long frameClock = profiler_now_micros();
+    long frameStart = trace_begin();
+    profiler_begin_frame(mbox_depth);
+    
+    // keep running at full frame rate while the user interacts with the UI 
+    // or something is animated, otherwise only wake up to poll input 
+    int busy = 0;
+    
+    profiler_begin_phase(PROFILE_PHASE_INPUT);
     while ( ! terminate && input_poll_touch(&touchEvent) ) {
         input_invoke_input_handler(&touchEvent);
+        busy = 1;
     }
+    profiler_end_phase(PROFILE_PHASE_INPUT);
       
+    profiler_begin_phase(PROFILE_PHASE_MAILBOX);
     mbox_entry *entry = NULL;
     while ( ! terminate && ( entry = render_poll_mbox() ) ) 
     {
@@ -469,17 +1000,31 @@ void *render_main_event_loop(void* data)
           log_info("Rendering thread shutting down...");              
           terminate = 1;  
         }
+        long start = profiler_now_micros();
+        long traceStart = trace_begin();
+        profiler_begin_callback();
         entry->result = entry->func(entry->data);
+        profiler_end_callback(entry->func);
+        trace_end_callback("mailbox",entry->func,traceStart);
+        mboxstats_record_execution(entry->func,start - entry->enqueueMicros,profiler_now_micros() - start);
         
-        if ( (entry->flags & MBOX_FLAG_FREED_BY_CREATOR) != 0 ) { // code awaiting completion will free the entry
-          render_signal_condition(entry->finished_mutex,entry->finished_condition);  
+        if ( (entry->flags & MBOX_FLAG_SYNCHRONOUS) != 0 ) { // the caller may reuse the entry as soon as it is signalled
+          render_completion_signal(&entry->completed);  
         } else {
-          free(entry);
+          slab_free(&mboxPool,entry);
         }
     }           
+    profiler_end_phase(PROFILE_PHASE_MAILBOX);
+    
     if ( ! terminate ) {
-      SDL_Flip(scrMain);       
-      SDL_Delay(16);        
+      animation_tick(frameClock);
+      render_present_frame();
+      profiler_end_frame();
+      trace_end("frame","frame",frameStart,TRACE_NO_ARG);
+      
+      busy |= animation_is_active();
+      long interval = busy ? RENDER_FRAME_INTERVAL_MICROS : RENDER_IDLE_POLL_INTERVAL_MICROS;
+      render_wait_for_mbox(frameClock + interval - profiler_now_micros());
     }
   }
   log_info("Rendering thread terminated.");      
@@ -492,9 +1037,13 @@ int render_init_render(void)
   if ( render_is_initialized() ) {
     return 1;
   }
+  render_register_callback_names();
+  animation_init();
+  layout_init();
   initResult = 0;
+  render_completion_reset(&initCompleted);
   
-  int err = pthread_create(&renderingThreadId, NULL, &render_main_event_loop, NULL); 
+  int err = pthread_create((pthread_t*) &renderingThreadId, NULL, &render_main_event_loop, NULL); 
   if ( err != 0 ) {
     render_error("ERROR - failed to spawn rendering thread");
     return 0;  
@@ -502,12 +1051,59 @@ int render_init_render(void)
   
   log_info("Waiting for init_render_internal()...");
   
-  render_wait_condition(&init_mutex,&init_condition);
+  render_completion_wait(&initCompleted);
   
   log_info("init_render() returned %d",initResult);
   return initResult;
 }
 
+int render_set_display_backend(const display_backend *backend) 
+{
+  if ( backend == NULL || render_is_initialized() ) {
+    return 0;
+  }
+  display = backend;
+  return 1;
+}
+
+int render_set_asset_bundle(const char *path) 
+{
+  if ( render_is_initialized() ) {
+    return 0;
+  }
+  char *copy = mem_strdup(path);
+  if ( copy == NULL ) {
+    return 0;
+  }
+  free(bundlePath);
+  bundlePath = copy;
+  return 1;
+}
+
+int render_set_row_workers(int count) 
+{
+  if ( count != RENDER_ROW_WORKERS_AUTO && ( count < 0 || count > ROWPOOL_MAX_WORKERS ) ) {
+    log_error("render_set_row_workers(): Invalid number of workers %d",count);
+    return 0;
+  }
+  rowWorkerCount = count;
+  if ( ! render_is_initialized() ) {
+    return 1;
+  }
+  return (int) (intptr_t) render_exec_on_thread(render_start_row_workers_internal,(void*) (intptr_t) count,1);
+}
+
+static void *render_capture_frame_internal(void *data) 
+{
+  SDL_Surface *target = data;
+  return (void*) (intptr_t) (SDL_BlitSurface(scrMain,NULL,target,NULL) == 0);
+}
+
+int render_capture_frame(SDL_Surface *target) 
+{
+  return (int) (intptr_t) render_exec_on_thread(render_capture_frame_internal,target,1);
+}
+
 int render_has_error(void) {
   return lastRenderError != NULL;
 }
@@ -521,49 +1117,27 @@ volatile const char* render_get_error(void) {
  * Draws a rectangle using the given color.
  * @param surface surface to draw onto
  * @param button button to draw
+ * @param bounds where to draw the button
  * @return 0 on error, otherwise success
  */
-static int render_draw_button_onto_internal(SDL_Surface *surface, ui_element *element) 
+static int render_draw_button_onto_internal(SDL_Surface *surface, ui_element *element, SDL_Rect *bounds) 
 {  
   button_entry *button = element->button;
  
-  log_error("render_draw_button_onto_internal(): About to render button...\n");
+  log_debug("render_draw_button_onto_internal(): About to render button...");
     
-  Sint16 x1 = element->bounds.x;
-  Sint16 y1 = element->bounds.y;
-  Sint16 x2 = element->bounds.x+element->bounds.w;
-  Sint16 y2 = element->bounds.y+element->bounds.h;
+  Sint16 x1 = bounds->x;
+  Sint16 y1 = bounds->y;
+  Sint16 x2 = bounds->x+bounds->w;
+  Sint16 y2 = bounds->y+bounds->h;
   
   SDL_Color *bgColor = button->pressed ? &button->clickedColor : &element->backgroundColor;
   
-  if ( button->cornerRadius > 0 ) 
-  {
-    roundedBoxRGBA(surface,x1,y1,x2,y2,button->cornerRadius,
-                  bgColor->r,
-                  bgColor->g,
-                  bgColor->b,
-                  255);
-
-    roundedRectangleRGBA(surface,x1,y1,x2,y2,button->cornerRadius,
-                  element->borderColor.r,
-                  element->borderColor.g,
-                  element->borderColor.b,
-                  255);  
-  }
-  else 
-  {
-    boxRGBA(surface,x1,y1,x2,y2,
-                  bgColor->r,
-                  bgColor->g,
-                  bgColor->b,
-                  255);
-
-    rectangleRGBA(surface,x1,y1,x2,y2,
-                  element->borderColor.r,
-                  element->borderColor.g,
-                  element->borderColor.b,
-                  255);      
-  }
+  // opaque, so the colors get mapped once and written without blending
+  Uint32 background = SDL_MapRGB(surface->format,bgColor->r,bgColor->g,bgColor->b);
+  Uint32 border = SDL_MapRGB(surface->format,element->borderColor.r,element->borderColor.g,element->borderColor.b);
+  raster_fill_rounded_box(surface,x1,y1,x2,y2,button->cornerRadius,background);
+  raster_draw_rounded_rect(surface,x1,y1,x2,y2,button->cornerRadius,border);
   
   int textWidth;
   int textHeight;
@@ -571,42 +1145,38 @@ static int render_draw_button_onto_internal(SDL_Surface *surface, ui_element *el
   if ( button->text == NULL ) 
   {
     if ( button->image == NULL ) {
-      render_error("render_draw_button_onto_internal(): Button has neither text nor image assigned?");
-      return 0;    
+      // still loading (or loading failed), the button's background serves as placeholder
+      return 1;    
     }
-    // render image
-    SDL_Rect srcRect = {0,0,button->image->w,button->image->h};
+    // render image, small images are part of the texture atlas
+    SDL_Rect srcRect = button->imageRect;
+    srcRect.w = min(button->imageRect.w,bounds->w);
+    srcRect.h = min(button->imageRect.h,bounds->h);
     SDL_Rect dstRect;
-    dstRect.w = min(button->image->w,element->bounds.w);
-    dstRect.h = min(button->image->h,element->bounds.h);    
-    dstRect.x = element->bounds.x + element->bounds.w/2 - dstRect.w/2;
-    dstRect.y = element->bounds.y + element->bounds.h/2 - dstRect.h/2;
+    dstRect.w = srcRect.w;
+    dstRect.h = srcRect.h;    
+    dstRect.x = bounds->x + bounds->w/2 - dstRect.w/2;
+    dstRect.y = bounds->y + bounds->h/2 - dstRect.h/2;
     
-    return SDL_BlitSurface(button->image,&srcRect,surface,&dstRect) == 0;
+    return blend_blit(button->image,&srcRect,surface,&dstRect);
   } 
   // render text
     
-  int result = TTF_SizeText(font, button->text, &textWidth, &textHeight);
-  if ( result != 0 ) {
+  if ( ! render_size_text(button->text,&textWidth,&textHeight) ) {
     log_error("render_draw_button_onto_internal(): Failed to size text\n");
     render_error("Failed to size text");
     return 0;    
   }
-  int textX = element->bounds.x + element->bounds.w/2 - textWidth/2;
-  int textY = element->bounds.y + element->bounds.h/2 - textHeight/2;
-  log_error("render_draw_button_onto_internal(): Rendering text at (%d,%d) with w=%d,h=%d\n",textX,textY,textWidth,textHeight);
+  int textX = bounds->x + bounds->w/2 - textWidth/2;
+  int textY = bounds->y + bounds->h/2 - textHeight/2;
+  log_debug("render_draw_button_onto_internal(): Rendering text at (%d,%d) with w=%d,h=%d",textX,textY,textWidth,textHeight);
   
-  render_text_args *text = calloc(1,sizeof(render_text_args));
+  render_text_args *text = arena_alloc(&frameArena,sizeof(render_text_args));
   if ( text == NULL ) {
     render_error("render_draw_button_onto_internal(): Failed to alloc memory for render_text_args");
     return 0;    
   }
-  text->text = strdup(button->text);
-  if ( text->text == NULL ) {
-    render_error("render_draw_button_onto_internal(): strdup() failed");    
-    free(text);
-    return 0;
-  }
+  text->text = button->text;
   text->x = textX;
   text->y = textY;
   text->color.r = element->foregroundColor.r; 
@@ -616,22 +1186,14 @@ static int render_draw_button_onto_internal(SDL_Surface *surface, ui_element *el
   return render_render_text_onto_internal(surface,text);    
 }
 
-static int render_draw_button_internal(ui_element *button) {
-  return render_draw_button_onto_internal(scrMain,button);
-}
-
-static int render_draw_button(ui_element *button) {
-    log_info("drawing button with %lx",button);
-    return (int) render_exec_on_thread(render_draw_button_internal,button,1);
-}
-
 /**
  * Create surface.
  * @param width
  * @param height
+ * @param category memory category the surface is accounted for
  * @return surface
  */
-SDL_Surface *render_create_surface(int width,int height) 
+SDL_Surface *render_create_surface(int width,int height,MemCategory category) 
 {
   /* Create a 32-bit surface with the bytes of each pixel in R,G,B,A order,
   as expected by OpenGL for textures */
@@ -656,41 +1218,151 @@ SDL_Surface *render_create_surface(int width,int height)
                                   rmask, gmask, bmask, amask);
   if(surface == NULL) {
       log_error("CreateRGBSurface failed: %s\n", SDL_GetError());
-  } 
+  } else {
+    memstats_add(category,memstats_surface_size(surface));
+  }
   return surface;
 }
 
-static int render_draw_listview_item_internal(SDL_Surface *surface,char *label,int x,int y,int width,int height) 
+typedef struct render_row_args {
+  const char *label; // copied into the frame arena, the label provider may reuse its buffer
+  int width; // right edge of the item
+} render_row_args;
+
+/**
+ * Renders a list view item into its row surface, looking like a text button.
+ * Runs on a row worker or the rendering thread (see rowpool.h).
+ * 
+ * @param row surface of the job
+ * @param data render_row_args of the item
+ * @param context font of the thread, NULL if the glyphs come from the asset bundle
+ * @return 0 on error, otherwise success
+ */
+static int render_draw_listview_row(SDL_Surface *row,void *data,void *context) 
 {
-  int result = 0;
+  render_row_args *args = data;
+  TTF_Font *ttfFont = context;
+  Uint32 background = SDL_MapRGB(row->format,128,128,128);
+  Uint32 border = SDL_MapRGB(row->format,255,255,255);
+  raster_fill_rounded_box(row,0,0,args->width,LISTVIEW_ITEM_HEIGHT,0,background);
+  raster_draw_rounded_rect(row,0,0,args->width,LISTVIEW_ITEM_HEIGHT,0,border);
+  
+  int useBundle = bundle_has_font(FONT_PATH,FONT_SIZE);
+  int textWidth;
+  int textHeight;
+  if ( useBundle ) {
+    bundle_size_text(args->label,&textWidth,&textHeight);
+  } else if ( ttfFont == NULL || TTF_SizeText(ttfFont,args->label,&textWidth,&textHeight) != 0 ) {
+    return 0;
+  }
+  int textX = args->width/2 - textWidth/2;
+  int textY = LISTVIEW_ITEM_HEIGHT/2 - textHeight/2;
+  SDL_Color color = {255,255,255};
+  SDL_Rect drawn;
+  if ( useBundle && bundle_render_text(row,args->label,textX,textY,color,&drawn) ) {
+    return 1;
+  }
+  return ttfFont && render_ttf_text_onto(row,ttfFont,args->label,textX,textY,color,&drawn);
+}
+
+/**
+ * Returns a row surface at least as wide as requested.
+ * @param index job index
+ * @param width
+ * @return surface or NULL on error
+ */
+static SDL_Surface *render_get_row_surface(int index,int width) 
+{
+  SDL_Surface *surface = rowSurfaces[index];
+  if ( surface && surface->w >= width ) {
+    return surface;
+  }
+  if ( surface ) {
+    render_free_surface(surface,MEM_CATEGORY_LISTVIEW_SURFACES);
+  }
+  // items overlap by one line, the bottom line of an item is the top line of the next one
+  surface = rowSurfaces[index] = render_create_surface(width,LISTVIEW_ITEM_HEIGHT+1,MEM_CATEGORY_LISTVIEW_SURFACES);
+  if ( surface ) {
+    // composited by copying
+    SDL_SetAlpha(surface,0,SDL_ALPHA_OPAQUE);
+  }
+  return surface;
+}
+
+/**
+ * Invokes a list view's item count provider.
+ * @param element list view
+ * @return item count
+ */
+static int render_listview_count_items(ui_element *element) 
+{
+  long traceStart = trace_begin();
+  int result = (*element->listview->itemCountProvider)( element->elementId );
+  trace_end("user","listview_item_count_provider",traceStart,element->elementId);
+  return result;
+}
+
+/**
+ * Returns the number of items of a list view, asking
+ * the item count provider only if the count is not cached.
+ * 
+ * Must be called from the rendering thread.
+ * 
+ * @param element list view
+ * @return item count
+ */
+int render_listview_get_item_count(ui_element *element) 
+{
+  listview_entry *listView = element->listview;
+  label_cache *cache = listView->labelCache;
   
-  ui_element *element = render_allocate_element(UI_BUTTON);
+  if ( cache == NULL ) {
+    return render_listview_count_items(element);
+  }
+  if ( cache->itemCount == LABELCACHE_UNKNOWN_ITEM_COUNT ) {
+    labelcache_set_item_count( cache, render_listview_count_items(element) );
+  }
+  return cache->itemCount;
+}
 
-  element->bounds.x = x;  
-  element->bounds.y = y;  
-  element->bounds.w = width;  
-  element->bounds.h = height;  
+/**
+ * Returns the label of a list view item, asking
+ * the label provider only if the label is not cached.
+ * 
+ * @param element list view
+ * @param index item index
+ * @return label
+ */
+static const char *render_listview_get_label(ui_element *element,int index) 
+{
+  listview_entry *listView = element->listview;
+  label_cache *cache = listView->labelCache;
   
-  button_entry *button = calloc(1,sizeof(button_entry));
-  if ( button ) 
+  const char *label = cache ? labelcache_get(cache,index) : NULL;
+  if ( label == NULL ) 
   {
-    element->button = button;
-    button->cornerRadius = 0;
-    button->fontSize = 16;
-    button->text = strdup(label);
-  
-    result = render_draw_button_onto_internal(surface,element);
+    long traceStart = trace_begin();
+    label = (*listView->labelProvider)(element->elementId, index);
+    trace_end("user","listview_label_provider",traceStart,index);
+    if ( cache && label ) 
+    {
+      const char *cached = labelcache_put(cache,index,label);
+      if ( cached ) {
+        label = cached;
+      }
+    }
   }
-  render_free_element(element);
-  return result;
+  return label ? label : "";
 }
 
 /**
  * Render list view.
  * @param listView
+ * @param target surface to draw onto
+ * @param bounds where to draw the list view
  * @return 0 on error, otherwise success
  */
-static int render_draw_listview_internal(ui_element *element) 
+static int render_draw_listview_internal(SDL_Surface *target,ui_element *element,SDL_Rect *bounds) 
 {
   listview_entry *listView = element->listview;
   
@@ -703,11 +1375,23 @@ static int render_draw_listview_internal(ui_element *element)
   int surfaceHeight = (listView->visibleItemCount+1) * LISTVIEW_ITEM_HEIGHT;
   int visibleHeight = listView->visibleItemCount * LISTVIEW_ITEM_HEIGHT;  
   
-  SDL_Surface *surface = render_create_surface(element->bounds.w,surfaceHeight);
-  if ( ! surface ) {
-    log_error("listview_internal(): Failed to allocate surface");
-    return 0;  
+  // off-screen surface is kept until the listview's size changes
+  SDL_Surface *surface = listView->surface;
+  if ( surface && ( surface->w != element->bounds.w || surface->h != surfaceHeight ) ) 
+  {
+    memstats_remove(MEM_CATEGORY_LISTVIEW_SURFACES,memstats_surface_size(surface));
+    SDL_FreeSurface(surface);
+    surface = listView->surface = NULL;
+  }
+  if ( ! surface ) 
+  {
+    surface = listView->surface = render_create_surface(element->bounds.w,surfaceHeight,MEM_CATEGORY_LISTVIEW_SURFACES);
+    if ( ! surface ) {
+      log_error("listview_internal(): Failed to allocate surface");
+      return 0;  
+    }
   }
+  SDL_FillRect(surface,NULL,0);
   
   // fill background
   Uint8 r = 128;
@@ -715,31 +1399,64 @@ static int render_draw_listview_internal(ui_element *element)
   Uint8 b = 128;
   Uint8 a = 255;
   
-  boxRGBA(scrMain,element->bounds.x,element->bounds.y,element->bounds.x + element->bounds.w, element->bounds.y + visibleHeight,r,g,b,a);   
+  boxRGBA(target,bounds->x,bounds->y,bounds->x + bounds->w, bounds->y + visibleHeight,r,g,b,a);   
   
   // calculate index of first item to render
   int firstItemIndex = listView->yStartOffset / LISTVIEW_ITEM_HEIGHT;
   
-  // draw items
-  int maxIdx = (*listView->itemCountProvider)( element->elementId );
-  for ( int i = firstItemIndex,len=0 ; i < maxIdx && len < listView->visibleItemCount+1 ; i++,len++) 
+  // draw items, labels are fetched on this thread and the items rendered in parallel by the row workers
+  int maxIdx = render_listview_get_item_count( element );
+  int itemCount = max( min(maxIdx - firstItemIndex,listView->visibleItemCount+1), 0 );
+  TTF_Font *ttfFont = bundle_has_font(FONT_PATH,FONT_SIZE) ? NULL : render_get_font();
+  for ( int first = 0 ; first < itemCount && returnCode ; first += RENDER_MAX_ROW_JOBS ) 
   {
-    char *label = (*listView->labelProvider)(element->elementId, i);  
-    
-    if ( ! render_draw_listview_item_internal(surface,label,0,len*LISTVIEW_ITEM_HEIGHT,element->bounds.w-1,LISTVIEW_ITEM_HEIGHT) ) 
-    {
-      log_error("render_listview_internal(): Failed to render item %d",i);      
+    int count = min(itemCount - first,RENDER_MAX_ROW_JOBS);
+    row_job *jobs = arena_alloc(&frameArena,count * sizeof(row_job));
+    render_row_args *args = arena_alloc(&frameArena,count * sizeof(render_row_args));
+    if ( ! jobs || ! args ) {
+      log_error("render_listview_internal(): Failed to allocate %d jobs",count);
       returnCode = 0;
       break;
-    }    
+    }
+    for ( int i = 0 ; i < count ; i++ ) 
+    {
+      const char *label = render_listview_get_label(element, firstItemIndex + first + i);  
+      char *copy = arena_alloc(&frameArena,strlen(label)+1);
+      jobs[i].surface = render_get_row_surface(i,element->bounds.w);
+      if ( ! copy || ! jobs[i].surface ) {
+        log_error("render_listview_internal(): Failed to allocate item %d",firstItemIndex + first + i);
+        returnCode = 0;
+        break;
+      }
+      strcpy(copy,label);
+      args[i].label = copy;
+      args[i].width = element->bounds.w-1;
+      jobs[i].render = render_draw_listview_row;
+      jobs[i].data = &args[i];
+    }
+    if ( ! returnCode ) {
+      break;
+    }
+    if ( ! rowpool_run(jobs,count,ttfFont) ) 
+    {
+      log_error("render_listview_internal(): Failed to render items %d-%d",firstItemIndex + first,firstItemIndex + first + count - 1);      
+      returnCode = 0;
+    }
+    // composite in order, so the top line of an item covers the bottom line of the item above
+    for ( int i = 0 ; i < count ; i++ ) 
+    {
+      SDL_Rect srcRect = { 0, 0, element->bounds.w, LISTVIEW_ITEM_HEIGHT+1 };
+      SDL_Rect dstRect = { 0, (first + i) * LISTVIEW_ITEM_HEIGHT, 0, 0 };
+      SDL_BlitSurface(jobs[i].surface,&srcRect,surface,&dstRect);
+    }
   }
   
   // blit fraction of surface onto 
   // int SDL_BlitSurface(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
   int yOffset = listView->yStartOffset - firstItemIndex * LISTVIEW_ITEM_HEIGHT;
   SDL_Rect srcRect = { 0 ,yOffset, element->bounds.w, visibleHeight };  
-  SDL_Rect dstRect = { element->bounds.x, element->bounds.y, element->bounds.w, visibleHeight };
-  if ( 0 != SDL_BlitSurface(surface,&srcRect,scrMain,&dstRect) ) 
+  SDL_Rect dstRect = { bounds->x, bounds->y, bounds->w, visibleHeight };
+  if ( 0 != SDL_BlitSurface(surface,&srcRect,target,&dstRect) ) 
   {
     log_error("render_listview_internal(): Failed to blit to destination");
     returnCode = 0;  
@@ -750,65 +1467,1352 @@ static int render_draw_listview_internal(ui_element *element)
   g = 255;
   b = 255;
   a = 255;  
-  rectangleRGBA(scrMain,element->bounds.x,element->bounds.y,element->bounds.x+ element->bounds.w, element->bounds.y + visibleHeight,r,g,b,a);    
+  rectangleRGBA(target,bounds->x,bounds->y,bounds->x+ bounds->w, bounds->y + visibleHeight,r,g,b,a);    
   
-  SDL_FreeSurface(surface);
   return returnCode;
 }
 
 /**
- * Render list view.
- * @param listView
+ * Paints a progress bar with the fill width it was last updated to.
+ * @param surface surface to draw onto
+ * @param element progress bar
+ * @param bounds where to draw the progress bar
  * @return 0 on error, otherwise success
  */
-static int render_draw_listview(ui_element *listView) 
+static int render_draw_progressbar_internal(SDL_Surface *surface,ui_element *element,SDL_Rect *bounds) 
 {
-   return (int) render_exec_on_thread(render_draw_listview_internal,listView,1);     
+  progressbar_entry *bar = element->progressbar;
+  int result = 1;
+  
+  SDL_Rect filled = { bounds->x + 1, bounds->y + 1, bar->drawnFill, max(bounds->h - 1,0) };
+  Uint32 color = SDL_MapRGB(surface->format,element->foregroundColor.r,element->foregroundColor.g,element->foregroundColor.b);
+  if ( filled.w > 0 && SDL_FillRect(surface,&filled,color) != 0 ) {
+    result = 0;
+  }
+  
+  SDL_Rect empty = { bounds->x + 1 + bar->drawnFill, bounds->y + 1, max(bounds->w - 1 - bar->drawnFill,0), max(bounds->h - 1,0) };
+  color = SDL_MapRGB(surface->format,element->backgroundColor.r,element->backgroundColor.g,element->backgroundColor.b);
+  if ( empty.w > 0 && SDL_FillRect(surface,&empty,color) != 0 ) {
+    result = 0;
+  }
+  
+  rectangleRGBA(surface,bounds->x,bounds->y,bounds->x + bounds->w,bounds->y + bounds->h,
+                element->borderColor.r,element->borderColor.g,element->borderColor.b,255);
+  return result;
 }
 
-static SDL_Surface *render_load_image_internal(char *file) 
+/**
+ * Paints the background of a container. Pages that are on screen during a 
+ * transition are painted by blitting their off-screen surface instead, including their children.
+ * 
+ * @param surface surface to draw onto
+ * @param element container
+ * @param bounds where to draw the container
+ * @return 0 on error, otherwise success
+ */
+static int render_draw_container_internal(SDL_Surface *surface,ui_element *element,SDL_Rect *bounds) 
 {
-  SDL_Surface* result = NULL; 
-  
-  SDL_Surface* image = IMG_Load( file ); 
-  if( image == NULL ) { 
-      printf( "Unable to load image %s! SDL_image Error: %s\n", file, IMG_GetError() ); 
-  } else { 
-      //Convert surface to screen format 
-      result = SDL_ConvertSurface( image, scrMain->format, SDL_SWSURFACE ); 
-      if( result == NULL ) { 
-        printf( "Unable to optimize image %s! SDL Error: %s\n", file, SDL_GetError() );         
-        result = image;
-      } else {
-        SDL_FreeSurface( image ); 
-      }
-  } 
-  return result;    
+  page_entry *page = element->container->page;
+  if ( page && page->state == PAGE_STATE_CACHED && surface != page->surface ) 
+  {
+    SDL_Rect dstRect = *bounds;
+    return SDL_BlitSurface(page->surface,NULL,surface,&dstRect) == 0;
+  }
+  if ( element->container->transparent ) {
+    return 1;
+  }
+  SDL_Rect rect = *bounds;
+  Uint32 color = SDL_MapRGB(surface->format,element->backgroundColor.r,element->backgroundColor.g,element->backgroundColor.b);
+  return SDL_FillRect(surface,&rect,color) == 0;
 }
 
-SDL_Surface *render_load_image(char *file) 
+/**
+ * Draws a single UI element (without its children).
+ * Must be called on the rendering thread.
+ * 
+ * @param surface surface to draw onto, the screen or the off-screen surface of a page
+ * @param element
+ * @param bounds coordinates to draw the element at
+ * @return 0 on error, otherwise success
+ */
+static int render_draw_element_at(SDL_Surface *surface,ui_element *element,SDL_Rect *bounds)
 {
-  return (SDL_Surface*) render_exec_on_thread(render_load_image_internal,file,1);
+  int result = 0;
+  long start = profiler_begin_draw();
+  long traceStart = trace_begin();
+  switch(element->type) {
+    case UI_BUTTON: 
+      result = render_draw_button_onto_internal(surface,element,bounds);
+      trace_end("draw","draw_button",traceStart,element->elementId);
+      break;
+    case UI_LISTVIEW:      
+      result = render_draw_listview_internal(surface,element,bounds);
+      trace_end("draw","draw_listview",traceStart,element->elementId);
+      break;
+    case UI_CONTAINER:      
+      result = render_draw_container_internal(surface,element,bounds);
+      trace_end("draw","draw_container",traceStart,element->elementId);
+      break;
+    case UI_PROGRESSBAR:
+      result = render_draw_progressbar_internal(surface,element,bounds);
+      trace_end("draw","draw_progressbar",traceStart,element->elementId);
+      break;
+    default:
+      log_error("render_draw(): Don't know how to draw %d",element->type);
+  }
+  profiler_end_draw(element->elementId,start);
+  return result;
 }
 
-static void *render_free_surface_internal(SDL_Surface *surface) {
-  SDL_FreeSurface(surface);  
-  return NULL;
+// ========================== scene graph ==========================
+
+/**
+ * Intersects two rectangles.
+ * @param a
+ * @param b
+ * @param result intersection, may point to a or b
+ * @return 0 if the rectangles do not intersect
+ */
+static int render_intersect_rects(SDL_Rect *a,SDL_Rect *b,SDL_Rect *result) 
+{
+  int x1 = max(a->x,b->x);
+  int y1 = max(a->y,b->y);
+  int x2 = min(a->x+a->w,b->x+b->w);
+  int y2 = min(a->y+a->h,b->y+b->h);
+  if ( x2 <= x1 || y2 <= y1 ) {
+    return 0;
+  }
+  result->x = x1;
+  result->y = y1;
+  result->w = x2-x1;
+  result->h = y2-y1;
+  return 1;
 }
 
-void render_free_surface(SDL_Surface *surface) {
-  render_exec_on_thread(render_free_surface_internal,surface,1);
+/**
+ * Adds a rectangle to a list, merging it with any rectangle it overlaps.
+ * @param list
+ * @param rect
+ */
+static void render_add_rect(rect_list *list,SDL_Rect *rect) 
+{
+  SDL_Rect clipped;
+  if ( list->overflow || ! render_intersect_rects(rect,&screen.bounds,&clipped) ) {
+    return;
+  }
+  for ( int i = 0 ; i < list->count ; i++ ) 
+  {
+    SDL_Rect *existing = &list->rects[i];
+    SDL_Rect dummy;
+    if ( render_intersect_rects(existing,&clipped,&dummy) ) 
+    {
+      int x2 = max(existing->x+existing->w,clipped.x+clipped.w);
+      int y2 = max(existing->y+existing->h,clipped.y+clipped.h);
+      existing->x = min(existing->x,clipped.x);
+      existing->y = min(existing->y,clipped.y);
+      existing->w = x2 - existing->x;
+      existing->h = y2 - existing->y;
+      return;
+    }
+  }
+  if ( list->count == RENDER_MAX_DAMAGE_RECTS ) {
+    list->overflow = 1;
+    return;
+  }
+  list->rects[list->count++] = clipped;
 }
 
-int render_draw(ui_element *element)
+/**
+ * Checks whether a rectangle intersects any rectangle of a list.
+ */
+static int render_rects_intersect(rect_list *list,SDL_Rect *rect) 
 {
-  switch(element->type) {
-    case UI_BUTTON: 
-      return render_draw_button(element);
-    case UI_LISTVIEW:      
-      return render_draw_listview(element);
+  SDL_Rect dummy;
+  if ( list->overflow ) {
+    return 1;
+  }
+  for ( int i = 0 ; i < list->count ; i++ ) {
+    if ( render_intersect_rects(&list->rects[i],rect,&dummy) ) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void render_clear_rects(rect_list *list) 
+{
+  list->count = 0;
+  list->overflow = 0;
+}
+
+/**
+ * Marks a region of the screen as changed so it gets flushed with the current frame.
+ * Must be called on the rendering thread.
+ * 
+ * @param rect region in absolute screen coordinates
+ */
+static void render_add_flush_rect(SDL_Rect *rect) 
+{
+  render_add_rect(&flushRegions,rect);
+}
+
+/**
+ * Calculates the bounds of an element in absolute screen coordinates.
+ * @param element
+ * @param result
+ */
+void render_get_absolute_bounds(ui_element *element,SDL_Rect *result) 
+{
+  *result = element->bounds;
+  for ( ui_element *parent = element->parent ; parent ; parent = parent->parent ) {
+    result->x += parent->bounds.x;
+    result->y += parent->bounds.y;
+  }
+}
+
+/**
+ * Calculates the area covered by an element when painted 
+ * (outlines are drawn on x+w and y+h).
+ */
+static void render_get_extent(ui_element *element,SDL_Rect *result) 
+{
+  render_get_absolute_bounds(element,result);
+  result->w++;
+  result->h++;
+}
+
+/**
+ * Calculates the part of an element that is not clipped by any of its ancestors.
+ * @param element
+ * @param result visible area in absolute screen coordinates
+ * @return 0 if the element is not visible at all
+ */
+int render_get_visible_bounds(ui_element *element,SDL_Rect *result) 
+{
+  render_get_extent(element,result);
+  for ( ui_element *parent = element->parent ; parent ; parent = parent->parent ) 
+  {
+    SDL_Rect parentExtent;
+    render_get_extent(parent,&parentExtent);
+    if ( ! render_intersect_rects(result,&parentExtent,result) ) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Returns the page an element belongs to.
+ * @param element
+ * @return the page (a top-level container) or NULL if the element is not part of a page
+ */
+static ui_element *render_get_page(ui_element *element) 
+{
+  if ( element->parent == NULL ) {
+    return NULL;
+  }
+  while ( element->parent != &screen ) 
+  {
+    element = element->parent;
+    if ( element == NULL ) {
+      return NULL;
+    }
+  }
+  return element->type == UI_CONTAINER && element->container->page ? element : NULL;
+}
+
+/**
+ * Marks the visible part of an element for repainting at the end of the frame. Elements 
+ * of pages that are not live get repainted onto the off-screen surface of their page.
+ * 
+ * @param element
+ * @param area part of the element in absolute screen coordinates or NULL for the whole element
+ */
+static void render_damage_element(ui_element *element,SDL_Rect *area) 
+{
+  if ( element->parent == NULL ) {
+    return;
+  }
+  ui_element *pageElement = render_get_page(element);
+  page_entry *page = pageElement ? pageElement->container->page : NULL;
+  // moving a cached page (during a transition) does not change its surface
+  if ( page && page->state != PAGE_STATE_LIVE && ! ( element == pageElement && page->state == PAGE_STATE_CACHED ) ) 
+  {
+    // clipped to the page but not to the screen, a cached page may be partially off-screen
+    SDL_Rect visible;
+    render_get_extent(element,&visible);
+    for ( ui_element *parent = element->parent ; parent != &screen ; parent = parent->parent ) 
+    {
+      SDL_Rect parentExtent;
+      render_get_extent(parent,&parentExtent);
+      if ( ! render_intersect_rects(&visible,&parentExtent,&visible) ) {
+        return;
+      }
+    }
+    if ( area && ! render_intersect_rects(&visible,area,&visible) ) {
+      return;
+    }
+    SDL_Rect local = { visible.x - pageElement->bounds.x, visible.y - pageElement->bounds.y, visible.w, visible.h };
+    render_add_rect(&page->damage,&local);
+    if ( page->state == PAGE_STATE_HIDDEN ) {
+      return;
+    }
+  }
+  SDL_Rect visible;
+  if ( render_get_visible_bounds(element,&visible) && ( area == NULL || render_intersect_rects(&visible,area,&visible) ) ) {
+    render_add_rect(&damagedRegions,&visible);
+  }
+}
+
+/*
+ * An element that intersects the region being painted.
+ */
+typedef struct paint_entry 
+{
+  ui_element *element;
+  SDL_Rect bounds; // absolute screen coordinates
+  SDL_Rect clip; // visible part of the element within the region
+  int occluded; // completely covered by elements painted later
+} paint_entry;
+
+/**
+ * Collects an element and its children in paint (back to front) order.
+ * 
+ * @param element
+ * @param originX x coordinate of the parent element on the surface being painted
+ * @param originY y coordinate of the parent element on the surface being painted
+ * @param clip region to paint in surface coordinates
+ * @param onScreen whether the screen is painted (otherwise the off-screen surface of a page)
+ * @param entries array to store entries in or NULL to only count them
+ * @param count number of entries collected so far
+ * @return number of entries collected
+ */
+static int render_collect_paint_entries(ui_element *element,int originX,int originY,SDL_Rect *clip,int onScreen,paint_entry *entries,int count) 
+{
+  // hidden pages are not on screen, the children of cached pages are part of the blitted surface
+  page_entry *page = element->type == UI_CONTAINER ? element->container->page : NULL;
+  if ( onScreen && page && page->state == PAGE_STATE_HIDDEN ) {
+    return count;
+  }
+  SDL_Rect bounds = element->bounds;
+  bounds.x += originX;
+  bounds.y += originY;
+  
+  SDL_Rect visible = { bounds.x, bounds.y, bounds.w+1, bounds.h+1 };
+  if ( ! render_intersect_rects(&visible,clip,&visible) ) {
+    return count;
+  }
+  if ( entries ) 
+  {
+    entries[count].element = element;
+    entries[count].bounds = bounds;
+    entries[count].clip = visible;
+    entries[count].occluded = 0;
+  }
+  count++;
+  
+  if ( onScreen && page && page->state == PAGE_STATE_CACHED ) {
+    return count;
+  }
+  for ( ui_element *child = element->firstChild ; child ; child = child->nextSibling ) {
+    count = render_collect_paint_entries(child,bounds.x,bounds.y,&visible,onScreen,entries,count);
+  }
+  return count;
+}
+
+/**
+ * Returns the part of an element that gets completely covered when the element is painted.
+ * 
+ * @param element
+ * @param bounds absolute screen coordinates of the element
+ * @param result opaque area
+ * @return 0 if the element has no opaque area
+ */
+static int render_get_opaque_rect(ui_element *element,SDL_Rect *bounds,SDL_Rect *result) 
+{
+  *result = *bounds;
+  switch(element->type) 
+  {
+    case UI_BUTTON:
+      // rounded corners leave the edges partially transparent, but the 
+      // middle columns are filled from top to bottom (outline included)
+      result->x += element->button->cornerRadius;
+      result->w = max( bounds->w + 1 - 2 * element->button->cornerRadius, 0 );
+      result->h++;
+      return result->w > 0;
+    case UI_LISTVIEW:
+    case UI_PROGRESSBAR:
+      result->w++;
+      result->h++;
+      return 1;
+    case UI_CONTAINER:
+      return ! element->container->transparent;
     default:
-      log_error("render_draw(): Don't know how to draw %d",element->type);
       return 0;
   }
+}
+
+/**
+ * Removes the part of a clip rectangle that is covered by an opaque rectangle, 
+ * as long as what remains is still a rectangle.
+ * 
+ * @param clip clip rectangle to shrink
+ * @param opaque opaque rectangle
+ * @return 0 if the clip rectangle is completely covered
+ */
+static int render_subtract_opaque_rect(SDL_Rect *clip,SDL_Rect *opaque) 
+{
+  SDL_Rect covered;
+  if ( ! render_intersect_rects(clip,opaque,&covered) ) {
+    return 1;
+  }
+  if ( covered.x == clip->x && covered.w == clip->w ) 
+  {
+    if ( covered.h == clip->h ) {
+      return 0;
+    }
+    if ( covered.y == clip->y ) {
+      clip->y += covered.h;
+      clip->h -= covered.h;
+    } else if ( covered.y + covered.h == clip->y + clip->h ) {
+      clip->h -= covered.h;
+    }
+  } 
+  else if ( covered.y == clip->y && covered.h == clip->h ) 
+  {
+    if ( covered.x == clip->x ) {
+      clip->x += covered.w;
+      clip->w -= covered.w;
+    } else if ( covered.x + covered.w == clip->x + clip->w ) {
+      clip->w -= covered.w;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Repaints a region of the screen or of the off-screen surface of a page.
+ * 
+ * All elements intersecting the region get painted back to front, clipped to 
+ * the part of them that is not covered by opaque elements painted later.
+ * Elements that are completely covered are skipped.
+ * 
+ * Must be called on the rendering thread.
+ * 
+ * @param surface the screen or the surface of the page
+ * @param root root of the scene graph or the page
+ * @param region region in surface coordinates
+ * @return 0 on error, otherwise success
+ */
+static int render_paint_region_onto(SDL_Surface *surface,ui_element *root,SDL_Rect *region) 
+{
+  // pages are painted onto their surface as if they were at 0,0
+  int onScreen = root == &screen;
+  int originX = -root->bounds.x;
+  int originY = -root->bounds.y;
+  int count = render_collect_paint_entries(root,originX,originY,region,onScreen,NULL,0);
+  if ( count == 0 ) {
+    return 1;
+  }
+  paint_entry *entries = arena_alloc(&frameArena,count * sizeof(paint_entry));
+  if ( ! entries ) {
+    log_error("render_paint_region(): Failed to allocate %d entries",count);
+    return 0;
+  }
+  render_collect_paint_entries(root,originX,originY,region,onScreen,entries,0);
+  
+  // occlusion pass, front to back
+  SDL_Rect *occluders = arena_alloc(&frameArena,count * sizeof(SDL_Rect));
+  int occluderCount = 0;
+  for ( int i = count-1 ; i >= 0 && occluders ; i-- ) 
+  {
+    paint_entry *entry = &entries[i];
+    for ( int j = 0 ; j < occluderCount && ! entry->occluded ; j++ ) {
+      entry->occluded = ! render_subtract_opaque_rect(&entry->clip,&occluders[j]);
+    }
+    SDL_Rect opaque;
+    if ( ! entry->occluded && render_get_opaque_rect(entry->element,&entry->bounds,&opaque) 
+         && render_intersect_rects(&opaque,&entry->clip,&opaque) ) 
+    {
+      occluders[occluderCount++] = opaque;
+    }
+  }
+  
+  int result = 1;
+  for ( int i = 0 ; i < count ; i++ ) 
+  {
+    if ( ! entries[i].occluded ) 
+    {
+      SDL_SetClipRect(surface,&entries[i].clip);
+      if ( ! render_draw_element_at(surface,entries[i].element,&entries[i].bounds) ) {
+        result = 0;
+      }
+    }
+  }
+  SDL_SetClipRect(surface,NULL);
+  if ( onScreen ) {
+    render_add_flush_rect(region);
+  }
+  return result;
+}
+
+/**
+ * Repaints a region of the screen.
+ * @param region region in absolute screen coordinates
+ * @return 0 on error, otherwise success
+ */
+static int render_paint_region(SDL_Rect *region) 
+{
+  return render_paint_region_onto(scrMain,&screen,region);
+}
+
+/**
+ * Repaints all regions that were invalidated during the current frame.
+ * Must be called on the rendering thread.
+ */
+static void render_repaint_damaged_regions(void) 
+{
+  if ( damagedRegions.overflow ) {
+    render_paint_region(&screen.bounds);
+  } else {
+    for ( int i = 0 ; i < damagedRegions.count ; i++ ) {
+      render_paint_region(&damagedRegions.rects[i]);
+    }
+  }
+  render_clear_rects(&damagedRegions);
+}
+
+/**
+ * Inserts an element into its parent's list of children, which is sorted by z-order.
+ * Children are painted in list order, so the element ends up on top of all 
+ * siblings with the same or a lower z-order.
+ * 
+ * @param parent
+ * @param element
+ */
+static void render_insert_child(ui_element *parent,ui_element *element) 
+{
+  ui_element **current = &parent->firstChild;
+  while ( *current && (*current)->zOrder <= element->zOrder ) {
+    current = &(*current)->nextSibling;
+  }
+  element->nextSibling = *current;
+  *current = element;
+}
+
+/**
+ * Removes an element from its parent's list of children.
+ * @param parent
+ * @param element
+ */
+static void render_remove_child(ui_element *parent,ui_element *element) 
+{
+  ui_element **current = &parent->firstChild;
+  while ( *current && *current != element ) {
+    current = &(*current)->nextSibling;
+  }
+  if ( *current ) {
+    *current = element->nextSibling;
+  }
+  element->nextSibling = NULL;
+}
+
+/**
+ * Returns the width of a progress bar's fill for its current value.
+ * @param element progress bar
+ * @return width in pixels
+ */
+static int render_progressbar_get_fill(ui_element *element) 
+{
+  progressbar_entry *bar = element->progressbar;
+  int value = bar->seeking ? bar->seekValue : __atomic_load_n(&bar->value,__ATOMIC_RELAXED);
+  int maximum = __atomic_load_n(&bar->maximum,__ATOMIC_RELAXED);
+  int width = element->bounds.w - 1;
+  if ( maximum <= 0 || width <= 0 ) {
+    return 0;
+  }
+  value = min(max(value,0),maximum);
+  return (int) ( (long) width * value / maximum );
+}
+
+/**
+ * Invalidates the pixel columns of all progress bars whose fill changed since they were last painted.
+ */
+static void render_update_progressbars(void) 
+{
+  for ( ui_element *element = progressBars ; element ; element = element->progressbar->nextProgressBar ) 
+  {
+    progressbar_entry *bar = element->progressbar;
+    int fill = render_progressbar_get_fill(element);
+    if ( fill == bar->drawnFill ) {
+      continue;
+    }
+    SDL_Rect absolute;
+    render_get_absolute_bounds(element,&absolute);
+    SDL_Rect columns = { absolute.x + 1 + min(fill,bar->drawnFill), absolute.y + 1, abs(fill - bar->drawnFill), max(absolute.h - 1,0) };
+    bar->drawnFill = fill;
+    
+    render_damage_element(element,&columns);
+  }
+}
+
+/**
+ * Updates the value of a progress bar. Does not wait for the rendering thread,
+ * the bar gets repainted at the end of the next frame.
+ * 
+ * @param element progress bar
+ * @param value
+ */
+void render_progressbar_set_value(ui_element *element,int value) 
+{
+  __atomic_store_n(&element->progressbar->value,value,__ATOMIC_RELAXED);
+  render_wake();
+}
+
+/**
+ * Updates the value a progress bar displays as completely filled. Does not wait for the rendering thread.
+ * 
+ * @param element progress bar
+ * @param maximum
+ */
+void render_progressbar_set_maximum(ui_element *element,int maximum) 
+{
+  __atomic_store_n(&element->progressbar->maximum,maximum,__ATOMIC_RELAXED);
+  render_wake();
+}
+
+typedef struct render_attach_args {
+  ui_element *parent;
+  ui_element *element;
+} render_attach_args;
+
+static void *render_attach_element_internal(void *data) 
+{
+  render_attach_args *args = data;
+  ui_element *element = args->element;
+  ui_element *parent = args->parent ? args->parent : &screen;
+  if ( parent->type != UI_CONTAINER ) {
+    log_error("render_attach_element(): Element %d is not a container",parent->elementId);
+    return NULL;
+  }
+  element->parent = parent;
+  render_insert_child(parent,element);
+  layout_element_attached(element);
+  
+  if ( element->type == UI_PROGRESSBAR ) 
+  {
+    element->progressbar->drawnFill = render_progressbar_get_fill(element);
+    element->progressbar->nextProgressBar = progressBars;
+    progressBars = element;
+  }
+  return (void*) (intptr_t) 1;
+}
+
+/**
+ * Adds an element to the scene graph, on top of all existing children of its parent.
+ * Does not paint the element.
+ * 
+ * @param parent parent container or NULL to add a top-level element
+ * @param element
+ * @return 0 on error, otherwise success
+ */
+int render_attach_element(ui_element *parent,ui_element *element) 
+{
+  render_attach_args args = { parent, element };
+  return (int) (intptr_t) render_exec_on_thread(render_attach_element_internal,&args,1);
+}
+
+static void render_remove_page(ui_element *element);
+
+static void *render_detach_element_internal(void *data) 
+{
+  ui_element *element = data;
+  ui_element *parent = element->parent;
+  if ( parent == NULL ) {
+    return (void*) (intptr_t) 1;
+  }
+  animation_cancel_element(element);
+  if ( element->type == UI_CONTAINER && element->container->page ) {
+    render_remove_page(element);
+  }
+  
+  if ( element->type == UI_PROGRESSBAR ) 
+  {
+    ui_element **current = &progressBars;
+    while ( *current && *current != element ) {
+      current = &(*current)->progressbar->nextProgressBar;
+    }
+    if ( *current ) {
+      *current = element->progressbar->nextProgressBar;
+    }
+    element->progressbar->nextProgressBar = NULL;
+  }
+  
+  // whatever the element covered needs to be repainted
+  render_damage_element(element,NULL);
+  
+  render_remove_child(parent,element);
+  layout_element_detached(parent);
+  
+  // children stay allocated but are no longer part of the scene
+  ui_element *child = element->firstChild;
+  while ( child ) 
+  {
+    ui_element *next = child->nextSibling;
+    child->nextSibling = NULL;
+    child = next;
+  }
+  element->firstChild = NULL;
+  element->nextSibling = NULL;
+  element->parent = NULL;
+  return (void*) (intptr_t) 1;
+}
+
+typedef struct render_z_order_args {
+  ui_element *element;
+  int zOrder;
+} render_z_order_args;
+
+static void *render_set_z_order_internal(void *data) 
+{
+  render_z_order_args *args = data;
+  ui_element *element = args->element;
+  element->zOrder = args->zOrder;
+  if ( element->parent ) 
+  {
+    render_remove_child(element->parent,element);
+    render_insert_child(element->parent,element);
+    render_damage_element(element,NULL);
+  }
+  return (void*) (intptr_t) 1;
+}
+
+/**
+ * Changes the z-order of an element. Elements with a higher z-order are painted on top of
+ * siblings with a lower z-order, siblings with the same z-order are painted in the order they were added.
+ * 
+ * @param element
+ * @param zOrder
+ * @return 0 on error, otherwise success
+ */
+int render_set_z_order(ui_element *element,int zOrder) 
+{
+  render_z_order_args args = { element, zOrder };
+  return (int) (intptr_t) render_exec_on_thread(render_set_z_order_internal,&args,1);
+}
+
+/**
+ * Finds the topmost element at the given coordinates among a list of siblings and their children.
+ * 
+ * @param child first sibling
+ * @param originX absolute x coordinate of the parent element
+ * @param originY absolute y coordinate of the parent element
+ * @param x
+ * @param y
+ * @return element or NULL
+ */
+static ui_element *render_find_element_in(ui_element *child,int originX,int originY,int x,int y) 
+{
+  if ( child == NULL ) {
+    return NULL;
+  }
+  // siblings later in the list are painted on top
+  ui_element *result = render_find_element_in(child->nextSibling,originX,originY,x,y);
+  if ( result ) {
+    return result;
+  }
+  // only the live page receives input
+  if ( child->type == UI_CONTAINER && child->container->page && child->container->page->state != PAGE_STATE_LIVE ) {
+    return NULL;
+  }
+  SDL_Rect extent = { child->bounds.x + originX, child->bounds.y + originY, child->bounds.w+1, child->bounds.h+1 };
+  if ( x < extent.x || y < extent.y || x >= extent.x + extent.w || y >= extent.y + extent.h ) {
+    return NULL;
+  }
+  if ( child->type == UI_CONTAINER ) {
+    return render_find_element_in(child->firstChild,extent.x,extent.y,x,y);
+  }
+  return child;
+}
+
+typedef struct render_find_args {
+  int x;
+  int y;
+} render_find_args;
+
+static void *render_find_element_at_internal(void *data) 
+{
+  render_find_args *args = data;
+  return render_find_element_in(screen.firstChild,0,0,args->x,args->y);
+}
+
+/**
+ * Finds the topmost element (that is not a container) at the given coordinates.
+ * 
+ * @param x
+ * @param y
+ * @return element or NULL
+ */
+ui_element *render_find_element_at(int x,int y) 
+{
+  render_find_args args = { x, y };
+  return (ui_element*) render_exec_on_thread(render_find_element_at_internal,&args,1);
+}
+
+static void *render_invalidate_internal(void *data) 
+{
+  ui_element *element = data;
+  render_damage_element(element,NULL);
+  return (void*) (intptr_t) 1;
+}
+
+/**
+ * Marks an element (including its children) for repaint at the end of the current frame.
+ * Invalidating the same region multiple times during a frame only repaints it once.
+ * 
+ * @param element
+ * @return 0 on error, otherwise success
+ */
+int render_invalidate(ui_element *element) 
+{
+  return (int) (intptr_t) render_exec_on_thread(render_invalidate_internal,element,1);
+}
+
+/**
+ * Draws a UI element, must be called on the rendering thread.
+ * 
+ * Elements that are part of the scene graph get repainted along with everything 
+ * overlapping them, clipped to their visible area.
+ * 
+ * @param element
+ * @return 0 on error, otherwise success
+ */
+static void *render_draw_internal(void *data)
+{
+  ui_element *element = data;
+  if ( element->parent == NULL ) 
+  {
+    SDL_Rect extent = { element->bounds.x, element->bounds.y, element->bounds.w+1, element->bounds.h+1 };
+    render_add_flush_rect(&extent);
+    return (void*) (intptr_t) render_draw_element_at(scrMain,element,&element->bounds);
+  }
+  // elements of pages that are not live only get painted onto their page's surface
+  ui_element *page = render_get_page(element);
+  if ( page && page->container->page->state != PAGE_STATE_LIVE ) {
+    render_damage_element(element,NULL);
+    return (void*) (intptr_t) 1;
+  }
+  SDL_Rect visible;
+  if ( ! render_get_visible_bounds(element,&visible) ) {
+    return (void*) (intptr_t) 1;
+  }
+  return (void*) (intptr_t) render_paint_region(&visible);
+}
+
+typedef struct render_listview_update_args {
+  ui_element *element;
+  int firstIndex;
+  int count;
+  int itemCount;
+} render_listview_update_args;
+
+static void *render_listview_invalidate_internal(void *data) 
+{
+  render_listview_update_args *args = data;
+  label_cache *cache = args->element->listview->labelCache;
+  if ( cache ) 
+  {
+    if ( args->count < 0 ) {
+      labelcache_invalidate_all(cache);
+    } else {
+      labelcache_invalidate_range(cache,args->firstIndex,args->count);
+    }
+  }
+  return render_draw_internal(args->element);
+}
+
+/**
+ * Discards cached list view labels and redraws the list view.
+ * 
+ * @param element list view
+ * @param firstIndex index of first item to invalidate
+ * @param count number of items to invalidate, a negative value invalidates all items along with the item count 
+ * @return 0 on error, otherwise success
+ */
+int render_listview_invalidate(ui_element *element,int firstIndex,int count) 
+{
+  render_listview_update_args args = { element, firstIndex, count, 0 };
+  return (int) (intptr_t) render_exec_on_thread(render_listview_invalidate_internal,&args,1);
+}
+
+static void *render_listview_set_item_count_internal(void *data) 
+{
+  render_listview_update_args *args = data;
+  listview_entry *listView = args->element->listview;
+  if ( listView->labelCache ) {
+    labelcache_set_item_count(listView->labelCache,args->itemCount);
+  }
+  
+  // make sure we're not scrolled past the last item
+  int maxOffset = (args->itemCount - listView->visibleItemCount) * LISTVIEW_ITEM_HEIGHT;
+  if ( listView->yStartOffset > maxOffset ) {
+    listView->yStartOffset = max(maxOffset,0);
+  }
+  return render_draw_internal(args->element);
+}
+
+/**
+ * Updates the item count of a list view and redraws it.
+ * 
+ * @param element list view
+ * @param itemCount new item count
+ * @return 0 on error, otherwise success
+ */
+int render_listview_set_item_count(ui_element *element,int itemCount) 
+{
+  render_listview_update_args args = { element, 0, 0, itemCount };
+  return (int) (intptr_t) render_exec_on_thread(render_listview_set_item_count_internal,&args,1);
+}
+
+static void *render_load_image_internal(void *data) 
+{
+  char *file = data;
+  SDL_Surface* result = NULL; 
+  
+  SDL_Surface* image = IMG_Load( file ); 
+  if( image == NULL ) { 
+      printf( "Unable to load image %s! SDL_image Error: %s\n", file, IMG_GetError() ); 
+  } else { 
+      //Convert surface to screen format, translucent images keep their alpha channel
+      SDL_Surface *rgba = imageloader_scale( image, image->w, image->h );
+      result = rgba ? imageloader_convert( rgba, scrMain->format ) : NULL;
+      if( result == NULL ) { 
+        printf( "Unable to optimize image %s! SDL Error: %s\n", file, SDL_GetError() );         
+        result = image;
+      } else {
+        SDL_FreeSurface( image ); 
+      }
+      memstats_add(MEM_CATEGORY_IMAGES,memstats_surface_size(result));
+  } 
+  return result;    
+}
+
+SDL_Surface *render_load_image(char *file) 
+{
+  return (SDL_Surface*) render_exec_on_thread(render_load_image_internal,file,1);
+}
+
+static void render_button_image_loaded(SDL_Surface *image,ui_element *element) 
+{
+  if ( image ) {
+    element->button->image = image;
+    element->button->imageRect = element->button->imageEntry->rect;
+    layout_request(element);
+    render_invalidate(element);
+  }
+}
+
+typedef struct render_load_button_image_args {
+  ui_element *element;
+  const char *file;
+} render_load_button_image_args;
+
+static void *render_load_button_image_internal(void *data) 
+{
+  render_load_button_image_args *args = data;
+  ui_element *element = args->element;
+  button_entry *button = element->button;
+  render_release_button_image_internal(element);
+  
+  // buttons showing the same file at the same size share the image
+  button->imageEntry = imagecache_acquire(args->file,element->bounds.w,element->bounds.h,scrMain->format,
+                                          (ImageLoadedCallback) render_button_image_loaded,element);
+  if ( button->imageEntry && button->imageEntry->image ) {
+    render_button_image_loaded(button->imageEntry->image,element);
+  }
+  return (void*) (intptr_t) (button->imageEntry != NULL);
+}
+
+int render_load_button_image(ui_element *element,const char *file) 
+{
+  render_load_button_image_args args = { element, file };
+  return (int) (intptr_t) render_exec_on_thread(render_load_button_image_internal,&args,1);
+}
+
+typedef struct render_button_set_text_args {
+  ui_element *element;
+  char *text;
+} render_button_set_text_args;
+
+static void *render_button_set_text_internal(void *data) 
+{
+  render_button_set_text_args *args = data;
+  button_entry *button = args->element->button;
+  free(button->text);
+  button->text = args->text;
+  layout_request(args->element);
+  render_invalidate(args->element);
+  return (void*) (intptr_t) 1;
+}
+
+int render_button_set_text(ui_element *element,const char *text) 
+{
+  if ( element->type != UI_BUTTON || element->button->text == NULL ) {
+    log_error("render_button_set_text(): Element %d is no text button",element->elementId);
+    return 0;
+  }
+  render_button_set_text_args args = { element, mem_strdup(text) };
+  if ( args.text == NULL ) {
+    log_error("render_button_set_text(): Failed to allocate memory");
+    return 0;
+  }
+  return (int) (intptr_t) render_exec_on_thread(render_button_set_text_internal,&args,1);
+}
+
+// ========================== pages ==========================
+
+/**
+ * Repaints the damaged regions of the off-screen surfaces of all pages that are not live.
+ */
+static void render_repaint_pages(void) 
+{
+  for ( ui_element *element = screen.firstChild ; element ; element = element->nextSibling ) 
+  {
+    page_entry *page = element->type == UI_CONTAINER ? element->container->page : NULL;
+    if ( page == NULL || page->state == PAGE_STATE_LIVE ) {
+      continue;
+    }
+    SDL_Rect pageBounds = { 0, 0, page->surface->w, page->surface->h };
+    if ( page->damage.overflow ) {
+      render_paint_region_onto(page->surface,element,&pageBounds);
+    } else {
+      for ( int i = 0 ; i < page->damage.count ; i++ ) {
+        render_paint_region_onto(page->surface,element,&page->damage.rects[i]);
+      }
+    }
+    render_clear_rects(&page->damage);
+  }
+}
+
+/**
+ * Makes the off-screen surface of the live page show what the page looks like, 
+ * copying the screen where possible.
+ * 
+ * @param element live page
+ */
+static void render_capture_page(ui_element *element) 
+{
+  page_entry *page = element->container->page;
+  // the screen shows the page unless something else gets painted on top of it
+  if ( element->nextSibling != NULL || hudEnabled || damagedRegions.overflow ) {
+    render_add_rect(&page->damage,&screen.bounds);
+    return;
+  }
+  SDL_BlitSurface(scrMain,NULL,page->surface,NULL);
+  // regions that have not been repainted yet
+  for ( int i = 0 ; i < damagedRegions.count ; i++ ) {
+    render_add_rect(&page->damage,&damagedRegions.rects[i]);
+  }
+}
+
+/**
+ * Puts the pages of the current transition where they end up, without waiting for the animation.
+ * The page the transition leads to stays cached.
+ */
+static void render_abort_page_transition(void) 
+{
+  if ( transition.to == NULL ) {
+    return;
+  }
+  if ( transition.from ) 
+  {
+    animation_cancel_element(transition.from);
+    transition.from->container->page->state = PAGE_STATE_HIDDEN;
+    transition.from->bounds.x = transition.from->bounds.y = 0;
+  }
+  animation_cancel_element(transition.to);
+  transition.to->bounds.x = transition.to->bounds.y = 0;
+  render_add_rect(&damagedRegions,&screen.bounds);
+  memset(&transition,0,sizeof(transition));
+}
+
+/**
+ * Completes the current transition after its last frame has been painted.
+ * The screen already shows the new page, so it does not need to be repainted.
+ */
+static void render_end_page_transition(void) 
+{
+  if ( transition.from ) 
+  {
+    transition.from->container->page->state = PAGE_STATE_HIDDEN;
+    transition.from->bounds.x = transition.from->bounds.y = 0;
+  }
+  transition.to->container->page->state = PAGE_STATE_LIVE;
+  memset(&transition,0,sizeof(transition));
+}
+
+static void render_page_transition_done(int animationId,void *data) 
+{
+  if ( animationId == transition.animationId ) {
+    transition.completed = 1;
+  }
+}
+
+/**
+ * Switches from one page to another. Both pages are painted from their off-screen
+ * surfaces until the transition ends, so none of their elements gets painted.
+ * 
+ * @param from page currently active or NULL
+ * @param to
+ * @param type
+ * @param durationMicros
+ * @return 0 on error, otherwise success
+ */
+static int render_start_page_transition(ui_element *from,ui_element *to,PageTransition type,long durationMicros) 
+{
+  render_abort_page_transition();
+  if ( from == to ) {
+    return 1;
+  }
+  if ( from ) 
+  {
+    page_entry *fromPage = from->container->page;
+    if ( fromPage->state == PAGE_STATE_LIVE ) {
+      render_capture_page(from);
+    }
+    fromPage->state = PAGE_STATE_CACHED;
+  }
+  to->container->page->state = PAGE_STATE_CACHED;
+  transition.from = from;
+  transition.to = to;
+  render_add_rect(&damagedRegions,&screen.bounds);
+  
+  if ( type == PAGE_TRANSITION_NONE || durationMicros <= 0 || from == NULL ) {
+    transition.completed = 1;
+    return 1;
+  }
+  AnimProperty property = type == PAGE_TRANSITION_SLIDE_UP || type == PAGE_TRANSITION_SLIDE_DOWN ? ANIM_PROPERTY_Y : ANIM_PROPERTY_X;
+  int distance = property == ANIM_PROPERTY_X ? viewportInfo.width : viewportInfo.height;
+  // the new page comes in from the side the content moves away from
+  if ( type == PAGE_TRANSITION_SLIDE_RIGHT || type == PAGE_TRANSITION_SLIDE_DOWN ) {
+    distance = -distance;
+  }
+  if ( property == ANIM_PROPERTY_X ) {
+    to->bounds.x = distance;
+  } else {
+    to->bounds.y = distance;
+  }
+  animation_start(from,property,-distance,durationMicros,EASE_OUT_CUBIC,NULL,NULL);
+  transition.animationId = animation_start(to,property,0,durationMicros,EASE_OUT_CUBIC,render_page_transition_done,NULL);
+  if ( ! transition.animationId ) {
+    transition.completed = 1;
+  }
+  return 1;
+}
+
+/**
+ * Removes a page that is being detached from the page stack and frees its surface.
+ */
+static void render_remove_page(ui_element *element) 
+{
+  page_entry *page = element->container->page;
+  if ( transition.from == element || transition.to == element ) {
+    render_abort_page_transition();
+  }
+  int index = 0;
+  for ( int i = 0 ; i < pageStackSize ; i++ ) 
+  {
+    if ( pageStack[i] != element ) {
+      pageStack[index++] = pageStack[i];
+    }
+  }
+  pageStackSize = index;
+  
+  // the page below takes over without transition
+  ui_element *top = pageStackSize > 0 ? pageStack[pageStackSize-1] : NULL;
+  if ( top && top->container->page->state != PAGE_STATE_LIVE && transition.to == NULL ) 
+  {
+    top->container->page->state = PAGE_STATE_LIVE;
+    render_add_rect(&damagedRegions,&screen.bounds);
+  }
+  memstats_remove(MEM_CATEGORY_PAGE_SURFACES,memstats_surface_size(page->surface));
+  SDL_FreeSurface(page->surface);
+  slab_free(&pagePool,page);
+  element->container->page = NULL;
+}
+
+static void *render_add_page_internal(void *data) 
+{
+  ui_element *element = data;
+  SDL_PixelFormat *format = scrMain->format;
+  page_entry *page = slab_alloc(&pagePool);
+  SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE,scrMain->w,scrMain->h,format->BitsPerPixel,
+                                              format->Rmask,format->Gmask,format->Bmask,format->Amask);
+  if ( page == NULL || surface == NULL ) 
+  {
+    log_error("render_add_page(): Failed to allocate page");
+    if ( page ) {
+      slab_free(&pagePool,page);
+    }
+    if ( surface ) {
+      SDL_FreeSurface(surface);
+    }
+    return NULL;
+  }
+  memstats_add(MEM_CATEGORY_PAGE_SURFACES,memstats_surface_size(surface));
+  page->surface = surface;
+  page->state = PAGE_STATE_HIDDEN;
+  
+  element->container->page = page;
+  element->container->transparent = 0;
+  element->bounds = screen.bounds;
+  render_attach_args args = { NULL, element };
+  if ( ! render_attach_element_internal(&args) ) {
+    return NULL;
+  }
+  // the first page becomes the active one, all others get rendered off-screen at the end of the frame
+  if ( pageStackSize == 0 ) 
+  {
+    pageStack[pageStackSize++] = element;
+    page->state = PAGE_STATE_LIVE;
+  }
+  render_damage_element(element,NULL);
+  return (void*) (intptr_t) 1;
+}
+
+int render_add_page(ui_element *element) 
+{
+  if ( element->type != UI_CONTAINER ) {
+    log_error("render_add_page(): Element %d is not a container",element->elementId);
+    return 0;
+  }
+  return (int) (intptr_t) render_exec_on_thread(render_add_page_internal,element,1);
+}
+
+typedef struct render_page_args {
+  int operation; // PAGE_OPERATION_xxx
+  ui_element *element;
+  PageTransition transition;
+  long durationMicros;
+} render_page_args;
+
+#define PAGE_OPERATION_PUSH 0
+#define PAGE_OPERATION_POP 1
+#define PAGE_OPERATION_SHOW 2
+
+static void *render_navigate_page_internal(void *data) 
+{
+  render_page_args *args = data;
+  ui_element *element = args->element;
+  if ( element && element->container->page == NULL ) {
+    log_error("render_navigate_page(): Element %d is not a page",element->elementId);
+    return NULL;
+  }
+  ui_element *from = pageStackSize > 0 ? pageStack[pageStackSize-1] : NULL;
+  switch( args->operation ) 
+  {
+    case PAGE_OPERATION_POP:
+      if ( pageStackSize < 2 ) {
+        log_error("render_pop_page(): No page to go back to");
+        return NULL;
+      }
+      pageStackSize--;
+      break;
+    case PAGE_OPERATION_PUSH:
+    case PAGE_OPERATION_SHOW:
+      for ( int i = 0 ; i < pageStackSize ; i++ ) 
+      {
+        if ( pageStack[i] == element && element != from ) {
+          log_error("render_navigate_page(): Page %d is already on the page stack",element->elementId);
+          return NULL;
+        }
+      }
+      if ( element == from ) {
+        return (void*) (intptr_t) 1;
+      }
+      if ( args->operation == PAGE_OPERATION_SHOW && pageStackSize > 0 ) {
+        pageStackSize--;
+      } else if ( pageStackSize == RENDER_MAX_PAGE_DEPTH ) {
+        log_error("render_push_page(): Too many pages on the page stack");
+        return NULL;
+      }
+      pageStack[pageStackSize++] = element;
+      break;
+  }
+  return (void*) (intptr_t) render_start_page_transition(from,pageStack[pageStackSize-1],args->transition,args->durationMicros);
+}
+
+int render_push_page(ui_element *element,PageTransition transition,long durationMicros) 
+{
+  render_page_args args = { PAGE_OPERATION_PUSH, element, transition, durationMicros };
+  return (int) (intptr_t) render_exec_on_thread(render_navigate_page_internal,&args,1);
+}
+
+int render_pop_page(PageTransition transition,long durationMicros) 
+{
+  render_page_args args = { PAGE_OPERATION_POP, NULL, transition, durationMicros };
+  return (int) (intptr_t) render_exec_on_thread(render_navigate_page_internal,&args,1);
+}
+
+int render_show_page(ui_element *element,PageTransition transition,long durationMicros) 
+{
+  render_page_args args = { PAGE_OPERATION_SHOW, element, transition, durationMicros };
+  return (int) (intptr_t) render_exec_on_thread(render_navigate_page_internal,&args,1);
+}
+
+static void *render_get_active_page_internal(void *dummy) 
+{
+  return pageStackSize > 0 ? pageStack[pageStackSize-1] : NULL;
+}
+
+ui_element *render_get_active_page(void) 
+{
+  return (ui_element*) render_exec_on_thread(render_get_active_page_internal,NULL,1);
+}
+
+static void *render_free_surface_internal(void *data) {
+  SDL_Surface *surface = data;
+  SDL_FreeSurface(surface);  
+  return NULL;
+}
+
+void render_free_surface(SDL_Surface *surface,MemCategory category) {
+  memstats_remove(category,memstats_surface_size(surface));
+  render_exec_on_thread(render_free_surface_internal,surface,1);
+}
+
+int render_draw(ui_element *element)
+{
+  log_debug("drawing element %d",element->elementId);
+  return (int) (intptr_t) render_exec_on_thread(render_draw_internal,element,1);
+}
+
+/**
+ * Registers names for all callbacks this file executes
+ * through the mailbox so they show up in the mailbox statistics.
+ */
+static void render_register_callback_names(void) 
+{
+  mboxstats_set_name(render_get_viewport_desc_internal,"get_viewport_desc");
+  mboxstats_set_name(render_capture_frame_internal,"capture_frame");
+  mboxstats_set_name(render_attach_element_internal,"attach_element");
+  mboxstats_set_name(render_detach_element_internal,"detach_element");
+  mboxstats_set_name(render_invalidate_internal,"invalidate");
+  mboxstats_set_name(render_set_z_order_internal,"set_z_order");
+  mboxstats_set_name(render_find_element_at_internal,"find_element_at");
+  mboxstats_set_name(render_close_render_internal,"close_render");
+  mboxstats_set_name(render_render_text_internal,"render_text");
+  mboxstats_set_name(render_draw_internal,"draw");
+  mboxstats_set_name(render_listview_invalidate_internal,"listview_invalidate");
+  mboxstats_set_name(render_listview_set_item_count_internal,"listview_set_item_count");
+  mboxstats_set_name(render_load_image_internal,"load_image");
+  mboxstats_set_name(render_load_button_image_internal,"load_button_image");
+  mboxstats_set_name(render_release_button_image_internal,"release_button_image");
+  mboxstats_set_name(render_button_set_text_internal,"button_set_text");
+  mboxstats_set_name(render_start_row_workers_internal,"start_row_workers");
+  mboxstats_set_name(render_add_page_internal,"add_page");
+  mboxstats_set_name(render_navigate_page_internal,"navigate_page");
+  mboxstats_set_name(render_get_active_page_internal,"get_active_page");
+  mboxstats_set_name(render_free_surface_internal,"free_surface");
+  mboxstats_set_name(render_set_profiler_hud_internal,"set_profiler_hud");
 }
\ No newline at end of file
@@ -4,18 +4,27 @@
 
 #include "SDL/SDL.h"
 #include "ui.h"
+#include "memstats.h"
+#include "display.h"
 
 #define FONT_PATH "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf"
 
-// #define USE_FB
-
-#define RENDER_FLAG_SDL_INIT (1<<0)
+#define RENDER_FLAG_DISPLAY_INIT (1<<0)
 #define RENDER_FLAG_TTF_INIT (1<<1)
 #define RENDER_FLAG_TTF_FONT_LOADED (1<<2)
 #define RENDER_FLAG_PNG_INITIALIZED (1<<3)
+#define RENDER_FLAG_IMAGE_WORKERS_STARTED (1<<4)
+#define RENDER_FLAG_BUNDLE_OPENED (1<<5)
+#define RENDER_FLAG_ROW_WORKERS_STARTED (1<<6)
 
 #define FONT_SIZE 16
 
+// max. number of pages on the page stack
+#define RENDER_MAX_PAGE_DEPTH 8
+
+// one row worker per CPU core besides the one of the rendering thread
+#define RENDER_ROW_WORKERS_AUTO -1
+
 extern SDL_Surface* scrMain;
 
 typedef struct viewport_desc {
@@ -36,20 +45,171 @@ int render_init_render(void);
 
 void render_close_render(void);
 
+int render_is_on_rendering_thread(void);
+
 void render_text(const char *text,int x,int y,SDL_Color color);
 
+/**
+ * Calculates the size of a text rendered with the UI font, must be called on the rendering thread.
+ * @param text
+ * @param width receives the width in pixels
+ * @param height receives the height in pixels
+ * @return 0 on error, otherwise success
+ */
+int render_size_text(const char *text,int *width,int *height);
+
 int render_has_error(void);
 
 volatile const char* render_get_error(void);
 
 ui_element *render_allocate_element(UIElementType type);
 
+button_entry *render_allocate_button_entry(void);
+
+listview_entry *render_allocate_listview_entry(void);
+
+container_entry *render_allocate_container_entry(void);
+
+progressbar_entry *render_allocate_progressbar_entry(void);
+
+void render_progressbar_set_value(ui_element *element,int value);
+
+void render_progressbar_set_maximum(ui_element *element,int maximum);
+
+int render_attach_element(ui_element *parent,ui_element *element);
+
+int render_invalidate(ui_element *element);
+
+int render_set_z_order(ui_element *element,int zOrder);
+
+ui_element *render_find_element_at(int x,int y);
+
+void render_get_absolute_bounds(ui_element *element,SDL_Rect *result);
+
+int render_get_visible_bounds(ui_element *element,SDL_Rect *result);
+
 void render_free_element(ui_element *element);
 
 int render_draw(ui_element *element);
 
+int render_listview_get_item_count(ui_element *element);
+
+int render_listview_invalidate(ui_element *element,int firstIndex,int count);
+
+int render_listview_set_item_count(ui_element *element,int itemCount);
+
+/**
+ * Loads an image in the screen's format. Translucent images are premultiplied 
+ * ARGB8888 instead if the screen is RGB565 and must be drawn with blend_blit().
+ * 
+ * @param file image file
+ * @return image or NULL on error
+ */
 SDL_Surface *render_load_image(char *file);
 
-void render_free_surface(SDL_Surface *surface);
+/**
+ * Loads the image of a button in the background, the button is drawn
+ * without image until loading completed. Images larger than the button get downscaled.
+ * Buttons showing the same file at the same size share the image.
+ * 
+ * @param element image button
+ * @param file image file
+ * @return 0 on error, otherwise success
+ */
+int render_load_button_image(ui_element *element,const char *file);
+
+/**
+ * Replaces the text of a button, the button is laid out again and repainted at the end of the frame.
+ * 
+ * @param element text button
+ * @param text new text
+ * @return 0 on error, otherwise success
+ */
+int render_button_set_text(ui_element *element,const char *text);
+
+/**
+ * Turns a container into a page: a full-screen child of the root that gets pre-rendered
+ * into an off-screen surface while it is not active. The first page becomes the active page,
+ * all others stay hidden until they are pushed or shown.
+ * Only the active page receives input and gets painted onto the screen directly.
+ * 
+ * @param element container, must not be attached yet
+ * @return 0 on error, otherwise success
+ */
+int render_add_page(ui_element *element);
+
+/**
+ * Makes a page the active page, keeping the current page on the page stack.
+ * 
+ * @param element page
+ * @param transition
+ * @param durationMicros duration of the transition
+ * @return 0 if the element is no page, the page is on the page stack already or the stack is full, otherwise success
+ */
+int render_push_page(ui_element *element,PageTransition transition,long durationMicros);
+
+/**
+ * Removes the active page from the page stack, returning to the page below it.
+ * 
+ * @param transition
+ * @param durationMicros duration of the transition
+ * @return 0 if there is no page to return to, otherwise success
+ */
+int render_pop_page(PageTransition transition,long durationMicros);
+
+/**
+ * Replaces the active page by another page.
+ * 
+ * @param element page
+ * @param transition
+ * @param durationMicros duration of the transition
+ * @return 0 if the element is no page or the page is further down the page stack, otherwise success
+ */
+int render_show_page(ui_element *element,PageTransition transition,long durationMicros);
+
+/**
+ * Returns the active page.
+ * @return page on top of the page stack or NULL if no page has been added
+ */
+ui_element *render_get_active_page(void);
+
+void render_set_profiler_hud(int enabled);
+
+void render_present_frame(void);
+
+void render_free_surface(SDL_Surface *surface,MemCategory category);
+
+/**
+ * Selects the display backend, must be called before render_init_render().
+ * @param backend
+ * @return 0 if rendering is already initialized, otherwise success
+ */
+int render_set_display_backend(const display_backend *backend);
+
+/**
+ * Selects an asset bundle (see bundle.h) to take icons and glyphs from,
+ * must be called before render_init_render().
+ * The TTF font only gets opened if the bundle holds no glyphs for it.
+ * 
+ * @param path bundle file
+ * @return 0 if rendering is already initialized or on OOM, otherwise success
+ */
+int render_set_asset_bundle(const char *path);
+
+/**
+ * Sets the number of worker threads that render list view items besides the rendering thread.
+ * Takes effect immediately if rendering is already initialized, otherwise on render_init_render().
+ * 
+ * @param count number of workers (at most ROWPOOL_MAX_WORKERS, 0 renders all items on the rendering thread) or RENDER_ROW_WORKERS_AUTO
+ * @return 0 if the count is invalid or not all workers could be started, otherwise success
+ */
+int render_set_row_workers(int count);
+
+/**
+ * Copies the current contents of the screen.
+ * @param target surface to copy to
+ * @return 0 on error, otherwise success
+ */
+int render_capture_frame(SDL_Surface *target);
 #endif
 
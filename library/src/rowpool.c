@@ -0,0 +1,147 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "rowpool.h"
+#include "log.h"
+#include "atomic.h"
+#include "trace.h"
+#include <pthread.h>
+
+typedef struct row_worker
+{
+  pthread_t thread;
+  void *context;
+  unsigned long generation; // last batch the worker took part in
+} row_worker;
+
+static row_worker workers[ROWPOOL_MAX_WORKERS];
+static int workerCount = 0;
+
+// guards batchGeneration and stopping
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_condition = PTHREAD_COND_INITIALIZER;
+
+// incremented for each batch, workers wait for it to change
+static unsigned long batchGeneration = 0;
+static int stopping = 0;
+
+// current batch, written by the rendering thread before the generation gets incremented
+static row_job *batchJobs = NULL;
+static int batchCount = 0;
+static int nextJob = 0; // index of the next job to pick up
+// threads (workers and the rendering thread) that have not finished the batch yet,
+// so no worker is still looking at a batch once rowpool_run() returned
+static int activeThreads = 0;
+static int batchCompleted = 0;
+
+/**
+ * Renders jobs of the current batch until none is left.
+ */
+static void rowpool_work(void *context)
+{
+  int index;
+  while ( ( index = __atomic_fetch_add(&nextJob,1,__ATOMIC_RELAXED) ) < batchCount )
+  {
+    row_job *job = &batchJobs[index];
+    long traceStart = trace_begin();
+    job->result = job->render(job->surface,job->data,context);
+    trace_end("draw","render_row",traceStart,index);
+  }
+  if ( __atomic_sub_fetch(&activeThreads,1,__ATOMIC_ACQ_REL) == 0 ) {
+    render_completion_signal(&batchCompleted);
+  }
+}
+
+static void *rowpool_worker(void *data)
+{
+  row_worker *worker = data;
+  trace_set_thread_name("row_worker");
+  pthread_mutex_lock(&pool_mutex);
+  while ( 1 )
+  {
+    while ( batchGeneration == worker->generation && ! stopping ) {
+      pthread_cond_wait(&pool_condition,&pool_mutex);
+    }
+    if ( stopping ) {
+      break;
+    }
+    worker->generation = batchGeneration;
+    pthread_mutex_unlock(&pool_mutex);
+
+    rowpool_work(worker->context);
+
+    pthread_mutex_lock(&pool_mutex);
+  }
+  pthread_mutex_unlock(&pool_mutex);
+  return NULL;
+}
+
+int rowpool_start(int count,void **contexts)
+{
+  rowpool_stop();
+  count = count > ROWPOOL_MAX_WORKERS ? ROWPOOL_MAX_WORKERS : count;
+  stopping = 0;
+  for ( int i = 0 ; i < count ; i++ )
+  {
+    workers[i].context = contexts ? contexts[i] : NULL;
+    // a batch started before the worker got to run must not be missed
+    workers[i].generation = batchGeneration;
+    if ( pthread_create(&workers[i].thread,NULL,rowpool_worker,&workers[i]) != 0 ) {
+      log_error("rowpool_start(): Failed to start worker %d of %d",i+1,count);
+      return 0;
+    }
+    workerCount++;
+  }
+  log_info("rowpool_start(): Started %d row workers",workerCount);
+  return 1;
+}
+
+void rowpool_stop(void)
+{
+  pthread_mutex_lock(&pool_mutex);
+  stopping = 1;
+  pthread_cond_broadcast(&pool_condition);
+  pthread_mutex_unlock(&pool_mutex);
+  for ( int i = 0 ; i < workerCount ; i++ ) {
+    pthread_join(workers[i].thread,NULL);
+  }
+  workerCount = 0;
+}
+
+int rowpool_get_worker_count(void)
+{
+  return workerCount;
+}
+
+int rowpool_run(row_job *jobs,int count,void *context)
+{
+  // waking up workers costs more than rendering a single row
+  if ( workerCount == 0 || count < 2 )
+  {
+    int result = 1;
+    for ( int i = 0 ; i < count ; i++ )
+    {
+      jobs[i].result = jobs[i].render(jobs[i].surface,jobs[i].data,context);
+      result &= jobs[i].result != 0;
+    }
+    return result;
+  }
+  batchJobs = jobs;
+  batchCount = count;
+  nextJob = 0;
+  activeThreads = workerCount + 1;
+  render_completion_reset(&batchCompleted);
+
+  pthread_mutex_lock(&pool_mutex);
+  batchGeneration++;
+  pthread_cond_broadcast(&pool_condition);
+  pthread_mutex_unlock(&pool_mutex);
+
+  rowpool_work(context);
+  render_completion_wait(&batchCompleted);
+
+  int result = 1;
+  for ( int i = 0 ; i < count ; i++ ) {
+    result &= jobs[i].result != 0;
+  }
+  return result;
+}
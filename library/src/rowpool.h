@@ -0,0 +1,63 @@
+#ifndef ROWPOOL_H
+#define ROWPOOL_H
+
+#include "SDL/SDL.h"
+
+/*
+ * Pool of worker threads that render rows (list view items, ...) in parallel.
+ *
+ * Each job renders into its own surface, so jobs never touch the same pixels.
+ * The rendering thread hands over a batch of jobs, works on the batch as well and
+ * returns once all jobs are done, it then composites the surfaces of the jobs.
+ *
+ * Renderers must only use thread-safe functions. State that is not thread-safe
+ * (fonts, ...) is passed as a context, each worker has its own.
+ *
+ * All functions must be called on the rendering thread.
+ */
+
+// max. number of worker threads, the rendering thread works on batches as well
+#define ROWPOOL_MAX_WORKERS 4
+
+// renders a job into its surface, returns 0 on error
+// int renderer(surface,job data,context of the thread running the job)
+typedef int (*RowRenderer)(SDL_Surface*,void*,void*);
+
+typedef struct row_job
+{
+  RowRenderer render;
+  SDL_Surface *surface;
+  void *data;
+  int result; // return value of the renderer
+} row_job;
+
+/**
+ * Starts the worker threads, stopping the ones already running.
+ *
+ * @param workerCount number of workers, at most ROWPOOL_MAX_WORKERS. 0 runs all jobs on the rendering thread.
+ * @param contexts context of each worker (may be NULL), must stay valid until the pool is stopped
+ * @return 0 if not all workers could be started, otherwise success
+ */
+int rowpool_start(int workerCount,void **contexts);
+
+/**
+ * Stops all worker threads.
+ */
+void rowpool_stop(void);
+
+/**
+ * Returns the number of worker threads running.
+ */
+int rowpool_get_worker_count(void);
+
+/**
+ * Runs a batch of jobs, returns once all of them have been rendered.
+ *
+ * @param jobs
+ * @param count number of jobs
+ * @param context context of the rendering thread
+ * @return 0 if any job failed, otherwise success
+ */
+int rowpool_run(row_job *jobs,int count,void *context);
+
+#endif
@@ -0,0 +1,725 @@
+#include "screen.h"
+#include "ui.h"
+#include "render.h"
+#include "imagecache.h"
+#include "log.h"
+#include "global.h"
+#include "mempool.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#define SCREEN_MAX_LINE_LENGTH 1024
+
+// screen currently shown, only accessed from the rendering thread
+static screen_definition *shownScreen = NULL;
+
+static const char *callbackAttributes[SCREEN_CALLBACK_TYPE_COUNT] = { "onclick", "labels", "count", "onclick", "onseek" };
+
+/**
+ * Splits the next token off a line. Values may be quoted ("..."), \" and \\ are unescaped.
+ *
+ * @param cursor position in the line, advanced behind the token
+ * @param token receives the token
+ * @return 0 if there are no more tokens, -1 if the token is malformed, otherwise 1
+ */
+static int screen_next_token(char **cursor,char *token)
+{
+  char *current = *cursor;
+  while ( *current == ' ' || *current == '\t' || *current == '\r' || *current == '\n' ) {
+    current++;
+  }
+  if ( *current == 0 || *current == '#' ) {
+    return 0;
+  }
+  int length = 0;
+  int quoted = 0;
+  while ( *current )
+  {
+    char c = *current;
+    if ( ! quoted && ( c == ' ' || c == '\t' || c == '\r' || c == '\n' ) ) {
+      break;
+    }
+    current++;
+    if ( c == '"' ) {
+      quoted = ! quoted;
+      continue;
+    }
+    if ( quoted && c == '\\' && ( *current == '"' || *current == '\\' ) ) {
+      c = *current++;
+    }
+    token[length++] = c;
+  }
+  token[length] = 0;
+  *cursor = current;
+  return quoted ? -1 : 1;
+}
+
+static int screen_parse_int(const char *value,int *result)
+{
+  char *end;
+  long number = strtol(value,&end,10);
+  if ( *value == 0 || *end != 0 || number < -32768 || number > 65535 ) {
+    return 0;
+  }
+  *result = number;
+  return 1;
+}
+
+static int screen_parse_color(const char *value,SDL_Color *result)
+{
+  char *end;
+  if ( value[0] != '#' || strlen(value) != 7 ) {
+    return 0;
+  }
+  long rgb = strtol(value+1,&end,16);
+  if ( *end != 0 ) {
+    return 0;
+  }
+  ASSIGN_COLOR(result,(rgb >> 16) & 0xff,(rgb >> 8) & 0xff,rgb & 0xff);
+  return 1;
+}
+
+static void screen_free_widget(screen_widget *widget)
+{
+  free(widget->name);
+  free(widget->text);
+  free(widget->image);
+  for ( int i = 0 ; i < SCREEN_CALLBACK_TYPE_COUNT ; i++ ) {
+    free(widget->callbackNames[i]);
+  }
+}
+
+/**
+ * Appends a zero-initialized widget.
+ * @return widget or NULL on OOM
+ */
+static screen_widget *screen_add_widget(screen_definition *screen)
+{
+  if ( screen->widgetCount == screen->capacity )
+  {
+    int capacity = screen->capacity ? screen->capacity * 2 : 16;
+    screen_widget *widgets = realloc(screen->widgets,capacity * sizeof(screen_widget));
+    if ( widgets == NULL ) {
+      return NULL;
+    }
+    screen->widgets = widgets;
+    screen->capacity = capacity;
+  }
+  screen_widget *widget = &screen->widgets[screen->widgetCount++];
+  memset(widget,0,sizeof(screen_widget));
+  widget->screen = screen;
+  return widget;
+}
+
+/**
+ * Applies a key=value attribute to a widget.
+ * @return 0 if the attribute is unknown or its value is invalid
+ */
+static int screen_parse_attribute(screen_widget *widget,char *key,char *value,int *given)
+{
+  const char *names[4] = { "x", "y", "w", "h" };
+  for ( int i = 0 ; i < 4 ; i++ )
+  {
+    int number;
+    if ( strcmp(key,names[i]) != 0 ) {
+      continue;
+    }
+    if ( ! screen_parse_int(value,&number) || ( i >= 2 && number <= 0 ) ) {
+      return 0;
+    }
+    switch ( i ) 
+    {
+      case 0: widget->bounds.x = number; break;
+      case 1: widget->bounds.y = number; break;
+      case 2: widget->bounds.w = number; break;
+      default: widget->bounds.h = number;
+    }
+    given[i] = 1;
+    return 1;
+  }
+  if ( strcmp(key,"z") == 0 ) {
+    return screen_parse_int(value,&widget->zOrder);
+  }
+  if ( strcmp(key,"background") == 0 ) {
+    return widget->hasBackground = screen_parse_color(value,&widget->background);
+  }
+  if ( strcmp(key,"foreground") == 0 ) {
+    return widget->hasForeground = screen_parse_color(value,&widget->foreground);
+  }
+  if ( strcmp(key,"border") == 0 ) {
+    return widget->hasBorder = screen_parse_color(value,&widget->border);
+  }
+  if ( strcmp(key,"maximum") == 0 && widget->type == UI_PROGRESSBAR ) {
+    return screen_parse_int(value,&widget->maximum) && widget->maximum >= 0;
+  }
+
+  char **string = NULL;
+  if ( strcmp(key,"name") == 0 ) {
+    string = &widget->name;
+  } else if ( strcmp(key,"text") == 0 && widget->type == UI_BUTTON && given[4] == 0 ) {
+    string = &widget->text;
+  } else if ( strcmp(key,"image") == 0 && widget->type == UI_BUTTON && given[4] == 1 ) {
+    string = &widget->image;
+  } else {
+    for ( int i = 0 ; i < SCREEN_CALLBACK_TYPE_COUNT && string == NULL ; i++ )
+    {
+      // list views and buttons both have an onclick attribute
+      int clickType = widget->type == UI_LISTVIEW ? SCREEN_CALLBACK_ITEM_CLICK : SCREEN_CALLBACK_CLICK;
+      if ( strcmp(key,callbackAttributes[i]) == 0 && ( strcmp(key,"onclick") != 0 || i == clickType ) ) {
+        string = &widget->callbackNames[i];
+      }
+    }
+  }
+  if ( string == NULL || *string != NULL ) {
+    return 0;
+  }
+  *string = mem_strdup(value);
+  return *string != NULL;
+}
+
+/**
+ * Checks that a widget has all attributes its type requires and resolves its callbacks.
+ * @return error message or NULL if the widget is valid
+ */
+static const char *screen_validate_widget(screen_widget *widget,int *given,ScreenCallbackResolver resolver,void *resolverData)
+{
+  // list views determine their height from the number of visible items
+  if ( ! given[0] || ! given[1] || ! given[2] || ( ! given[3] && widget->type != UI_LISTVIEW ) ) {
+    return "missing x, y, w or h";
+  }
+  int required[SCREEN_CALLBACK_TYPE_COUNT] = {0};
+  int allowed[SCREEN_CALLBACK_TYPE_COUNT] = {0};
+  switch ( widget->type )
+  {
+    case UI_BUTTON:
+      if ( widget->text == NULL && widget->image == NULL ) {
+        return given[4] ? "image_button without image" : "button without text";
+      }
+      if ( widget->image && access(widget->image,R_OK) != 0 ) {
+        return "image not readable";
+      }
+      required[SCREEN_CALLBACK_CLICK] = allowed[SCREEN_CALLBACK_CLICK] = 1;
+      break;
+    case UI_LISTVIEW:
+      required[SCREEN_CALLBACK_LABELS] = allowed[SCREEN_CALLBACK_LABELS] = 1;
+      required[SCREEN_CALLBACK_ITEM_COUNT] = allowed[SCREEN_CALLBACK_ITEM_COUNT] = 1;
+      allowed[SCREEN_CALLBACK_ITEM_CLICK] = 1;
+      break;
+    case UI_PROGRESSBAR:
+      allowed[SCREEN_CALLBACK_SEEK] = 1;
+      break;
+    default:
+      break;
+  }
+  for ( int i = 0 ; i < SCREEN_CALLBACK_TYPE_COUNT ; i++ )
+  {
+    if ( widget->callbackNames[i] == NULL )
+    {
+      if ( required[i] ) {
+        return "missing callback";
+      }
+      continue;
+    }
+    if ( ! allowed[i] ) {
+      return "callback not supported by this widget";
+    }
+    widget->callbacks[i] = resolver ? resolver(widget->callbackNames[i],i,resolverData) : NULL;
+    if ( widget->callbacks[i] == NULL ) {
+      return "unknown callback";
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Parses a widget line.
+ * @param keyword widget type
+ * @param cursor rest of the line
+ * @param parent index of the enclosing container or -1
+ * @param line line number
+ * @param opensContainer set if the line ends with '{'
+ * @return error message or NULL on success
+ */
+static const char *screen_parse_widget(screen_definition *screen,const char *keyword,char *cursor,int parent,int line,
+                                       int *opensContainer,ScreenCallbackResolver resolver,void *resolverData)
+{
+  // x,y,w,h given and whether this is an image button
+  int given[5] = {0};
+  UIElementType type;
+  if ( strcmp(keyword,"button") == 0 ) {
+    type = UI_BUTTON;
+  } else if ( strcmp(keyword,"image_button") == 0 ) {
+    type = UI_BUTTON;
+    given[4] = 1;
+  } else if ( strcmp(keyword,"listview") == 0 ) {
+    type = UI_LISTVIEW;
+  } else if ( strcmp(keyword,"progressbar") == 0 ) {
+    type = UI_PROGRESSBAR;
+  } else if ( strcmp(keyword,"container") == 0 ) {
+    type = UI_CONTAINER;
+  } else {
+    return "unknown widget";
+  }
+
+  screen_widget *widget = screen_add_widget(screen);
+  if ( widget == NULL ) {
+    return "out of memory";
+  }
+  widget->type = type;
+  widget->parent = parent;
+  widget->line = line;
+
+  char token[SCREEN_MAX_LINE_LENGTH];
+  int tokenResult;
+  *opensContainer = 0;
+  while ( ( tokenResult = screen_next_token(&cursor,token) ) > 0 )
+  {
+    if ( strcmp(token,"{") == 0 && type == UI_CONTAINER && ! *opensContainer ) {
+      *opensContainer = 1;
+      continue;
+    }
+    char *value = strchr(token,'=');
+    if ( value == NULL || *opensContainer ) {
+      return "expected key=value";
+    }
+    *value++ = 0;
+    if ( ! screen_parse_attribute(widget,token,value,given) ) {
+      return "invalid, unknown or duplicate attribute";
+    }
+  }
+  if ( tokenResult < 0 ) {
+    return "unterminated quote";
+  }
+  if ( type == UI_CONTAINER && ! *opensContainer ) {
+    return "container without {";
+  }
+  const char *error = screen_validate_widget(widget,given,resolver,resolverData);
+  if ( error ) {
+    return error;
+  }
+  if ( type == UI_LISTVIEW ) {
+    // default height of ui_create_listview()
+    widget->bounds.h = LISTVIEW_DEFAULT_VISIBLE_ITEMS * LISTVIEW_ITEM_HEIGHT;
+  }
+
+  // children must lie within their parent
+  SDL_Rect *parentBounds = parent < 0 ? &screen->bounds : &screen->widgets[parent].bounds;
+  if ( widget->bounds.x < 0 || widget->bounds.y < 0 || widget->bounds.x + widget->bounds.w > parentBounds->w
+       || widget->bounds.y + widget->bounds.h > parentBounds->h ) {
+    return "bounds exceed the parent";
+  }
+  if ( widget->name )
+  {
+    for ( int i = 0 ; i < screen->widgetCount - 1 ; i++ ) {
+      if ( screen->widgets[i].name && strcmp(screen->widgets[i].name,widget->name) == 0 ) {
+        return "duplicate name";
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Parses and validates a screen file.
+ * @return 0 on error, otherwise success
+ */
+static int screen_parse(screen_definition *screen,FILE *file,ScreenCallbackResolver resolver,void *resolverData)
+{
+  char line[SCREEN_MAX_LINE_LENGTH];
+  char keyword[SCREEN_MAX_LINE_LENGTH];
+  int containers[SCREEN_MAX_DEPTH];
+  int depth = 0;
+  int lineNumber = 0;
+  while ( fgets(line,sizeof(line),file) )
+  {
+    lineNumber++;
+    const char *error = NULL;
+    char *cursor = line;
+    int tokenResult = screen_next_token(&cursor,keyword);
+    if ( tokenResult == 0 ) {
+      continue;
+    }
+    if ( strchr(line,'\n') == NULL && ! feof(file) ) {
+      error = "line too long";
+    }
+    else if ( tokenResult < 0 ) {
+      error = "unterminated quote";
+    }
+    else if ( strcmp(keyword,"}") == 0 )
+    {
+      if ( depth == 0 ) {
+        error = "} without container";
+      } else if ( screen_next_token(&cursor,keyword) != 0 ) {
+        error = "unexpected text after }";
+      } else {
+        depth--;
+      }
+    }
+    else if ( strcmp(keyword,"screen") == 0 )
+    {
+      while ( error == NULL && ( tokenResult = screen_next_token(&cursor,keyword) ) != 0 )
+      {
+        if ( tokenResult < 0 || strncmp(keyword,"background=",11) != 0 || ! screen_parse_color(keyword+11,&screen->background) ) {
+          error = "expected background=#rrggbb";
+        }
+      }
+    }
+    else
+    {
+      int opensContainer;
+      error = screen_parse_widget(screen,keyword,cursor,depth > 0 ? containers[depth-1] : -1,lineNumber,
+                                  &opensContainer,resolver,resolverData);
+      if ( error == NULL && opensContainer )
+      {
+        if ( depth == SCREEN_MAX_DEPTH ) {
+          error = "containers nested too deeply";
+        } else {
+          containers[depth++] = screen->widgetCount - 1;
+        }
+      }
+    }
+    if ( error ) {
+      log_error("screen_load(): %s:%d: %s",screen->path,lineNumber,error);
+      return 0;
+    }
+  }
+  if ( depth > 0 ) {
+    log_error("screen_load(): %s: container at line %d is not closed",screen->path,screen->widgets[containers[depth-1]].line);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Invoked on the rendering thread once an image of a screen has been loaded.
+ */
+static void screen_image_loaded(SDL_Surface *image,screen_widget *widget)
+{
+  screen_definition *screen = widget->screen;
+  pthread_mutex_lock(&screen->preload_mutex);
+  screen->pendingImages--;
+  pthread_cond_broadcast(&screen->preload_condition);
+  pthread_mutex_unlock(&screen->preload_mutex);
+}
+
+/**
+ * Starts loading all images of a screen, they are loaded in parallel by the image loader's workers.
+ * The screen keeps the images cached until it is freed.
+ */
+static void *screen_preload_internal(void *data)
+{
+  screen_definition *screen = data;
+  for ( int i = 0 ; i < screen->widgetCount ; i++ )
+  {
+    screen_widget *widget = &screen->widgets[i];
+    if ( widget->image == NULL ) {
+      continue;
+    }
+    pthread_mutex_lock(&screen->preload_mutex);
+    screen->pendingImages++;
+    pthread_mutex_unlock(&screen->preload_mutex);
+
+    widget->imageEntry = imagecache_acquire(widget->image,widget->bounds.w,widget->bounds.h,scrMain->format,
+                                            (ImageLoadedCallback) screen_image_loaded,widget);
+    if ( widget->imageEntry == NULL || widget->imageEntry->image ) {
+      screen_image_loaded(NULL,widget);
+    }
+  }
+  return (void*) (intptr_t) 1;
+}
+
+static void screen_free_definition(screen_definition *screen)
+{
+  for ( int i = 0 ; i < screen->widgetCount ; i++ ) {
+    screen_free_widget(&screen->widgets[i]);
+  }
+  free(screen->widgets);
+  free(screen->path);
+  pthread_mutex_destroy(&screen->preload_mutex);
+  pthread_cond_destroy(&screen->preload_condition);
+  free(screen);
+}
+
+screen_definition *screen_load(const char *path,ScreenCallbackResolver resolver,void *resolverData)
+{
+  viewport_desc viewport;
+  if ( ! render_get_viewport_desc(&viewport) ) {
+    log_error("screen_load(): Rendering is not initialized");
+    return NULL;
+  }
+  FILE *file = fopen(path,"r");
+  if ( file == NULL ) {
+    log_error("screen_load(): Failed to open %s",path);
+    return NULL;
+  }
+  screen_definition *screen = mem_calloc(1,sizeof(screen_definition));
+  char *pathCopy = mem_strdup(path);
+  if ( screen == NULL || pathCopy == NULL ) {
+    log_error("screen_load(): Failed to allocate screen");
+    free(screen);
+    free(pathCopy);
+    fclose(file);
+    return NULL;
+  }
+  screen->path = pathCopy;
+  screen->bounds.w = viewport.width;
+  screen->bounds.h = viewport.height;
+  pthread_mutex_init(&screen->preload_mutex,NULL);
+  pthread_cond_init(&screen->preload_condition,NULL);
+
+  long traceStart = trace_begin();
+  int parsed = screen_parse(screen,file,resolver,resolverData);
+  trace_end("ui","parse_screen",traceStart,screen->widgetCount);
+  fclose(file);
+  if ( ! parsed ) {
+    screen_free_definition(screen);
+    return NULL;
+  }
+  render_exec_on_thread(screen_preload_internal,screen,1);
+  log_info("screen_load(): Loaded %s with %d widgets",path,screen->widgetCount);
+  return screen;
+}
+
+/**
+ * Frees elements created for a screen, children before their parents.
+ * @param count number of elements, elements may be NULL
+ */
+static void screen_free_elements(ui_element *root,ui_element **elements,int count)
+{
+  for ( int i = count - 1 ; i >= 0 ; i-- )
+  {
+    if ( elements[i] ) {
+      ui_unregister_element(elements[i]);
+      render_free_element(elements[i]);
+    }
+  }
+  if ( root ) {
+    ui_unregister_element(root);
+    render_free_element(root);
+  }
+  free(elements);
+}
+
+/**
+ * Hides the shown screen, invoked on the rendering thread.
+ */
+static void *screen_hide_internal(void *dummy)
+{
+  if ( shownScreen )
+  {
+    screen_free_elements(shownScreen->root,shownScreen->elements,shownScreen->widgetCount);
+    shownScreen->root = NULL;
+    shownScreen->elements = NULL;
+    shownScreen = NULL;
+  }
+  return (void*) (intptr_t) 1;
+}
+
+typedef struct screen_install_args {
+  screen_definition *screen;
+  ui_element *root;
+  ui_element **elements;
+} screen_install_args;
+
+/**
+ * Replaces the shown screen by elements created for another one, all in the same frame.
+ */
+static void *screen_install_internal(void *data)
+{
+  screen_install_args *args = data;
+  screen_definition *screen = args->screen;
+  if ( screen == shownScreen ) {
+    // shown by another thread in the meantime
+    screen_free_elements(args->root,args->elements,screen->widgetCount);
+    return (void*) (intptr_t) 1;
+  }
+  screen_hide_internal(NULL);
+
+  // runs on the rendering thread, so none of these calls waits for the mailbox
+  int result = render_attach_element(NULL,args->root);
+  for ( int i = 0 ; i < screen->widgetCount && result ; i++ )
+  {
+    screen_widget *widget = &screen->widgets[i];
+    ui_element *parent = widget->parent < 0 ? args->root : args->elements[widget->parent];
+    result = render_attach_element(parent,args->elements[i]);
+    if ( result && widget->image ) {
+      // cache hit as the screen preloaded the image
+      render_load_button_image(args->elements[i],widget->image);
+    }
+  }
+  if ( ! result ) {
+    log_error("screen_show(): Failed to attach elements of %s",screen->path);
+    screen_free_elements(args->root,args->elements,screen->widgetCount);
+    return NULL;
+  }
+  screen->root = args->root;
+  screen->elements = args->elements;
+  shownScreen = screen;
+  render_invalidate(args->root);
+  return (void*) (intptr_t) 1;
+}
+
+/**
+ * Creates the element of a widget, it is neither attached nor registered.
+ */
+static ui_element *screen_create_element(screen_widget *widget)
+{
+  ui_element *element = NULL;
+  switch ( widget->type )
+  {
+    case UI_BUTTON:
+      element = ui_create_button(widget->text,&widget->bounds,(ButtonHandler) widget->callbacks[SCREEN_CALLBACK_CLICK]);
+      break;
+    case UI_LISTVIEW:
+      element = ui_create_listview(&widget->bounds,
+                                   (ListViewLabelProvider) widget->callbacks[SCREEN_CALLBACK_LABELS],
+                                   (ListViewItemCountProvider) widget->callbacks[SCREEN_CALLBACK_ITEM_COUNT],
+                                   (ListViewClickCallback) widget->callbacks[SCREEN_CALLBACK_ITEM_CLICK]);
+      break;
+    case UI_PROGRESSBAR:
+      element = ui_create_progressbar(&widget->bounds,widget->maximum,(ProgressBarSeekCallback) widget->callbacks[SCREEN_CALLBACK_SEEK]);
+      break;
+    case UI_CONTAINER:
+      element = ui_create_container(&widget->bounds,widget->hasBackground ? &widget->background : NULL);
+      break;
+    default:
+      log_error("screen_create_element(): Unsupported type %d",widget->type);
+  }
+  if ( element == NULL ) {
+    return NULL;
+  }
+  element->zOrder = widget->zOrder;
+  if ( widget->hasBackground ) {
+    element->backgroundColor = widget->background;
+  }
+  if ( widget->hasForeground ) {
+    element->foregroundColor = widget->foreground;
+  }
+  if ( widget->hasBorder ) {
+    element->borderColor = widget->border;
+  }
+  return element;
+}
+
+int screen_show(screen_definition *screen)
+{
+  // images get delivered through the mailbox, the rendering thread can't wait for them
+  if ( ! render_is_on_rendering_thread() )
+  {
+    pthread_mutex_lock(&screen->preload_mutex);
+    while ( screen->pendingImages > 0 ) {
+      pthread_cond_wait(&screen->preload_condition,&screen->preload_mutex);
+    }
+    pthread_mutex_unlock(&screen->preload_mutex);
+  }
+
+  long traceStart = trace_begin();
+  screen_install_args args = { screen, NULL, NULL };
+  args.root = ui_create_container(&screen->bounds,&screen->background);
+  args.elements = mem_calloc(screen->widgetCount ? screen->widgetCount : 1,sizeof(ui_element*));
+  int result = args.root && args.elements;
+  for ( int i = 0 ; i < screen->widgetCount && result ; i++ ) {
+    args.elements[i] = screen_create_element(&screen->widgets[i]);
+    result = args.elements[i] != NULL;
+  }
+  if ( ! result )
+  {
+    log_error("screen_show(): Failed to create elements of %s",screen->path);
+    if ( args.elements ) {
+      screen_free_elements(args.root,args.elements,screen->widgetCount);
+    } else if ( args.root ) {
+      render_free_element(args.root);
+    }
+    return 0;
+  }
+  ui_add_element(args.root);
+  for ( int i = 0 ; i < screen->widgetCount ; i++ ) {
+    ui_add_element(args.elements[i]);
+  }
+  result = (int) (intptr_t) render_exec_on_thread(screen_install_internal,&args,1);
+  trace_end("ui","show_screen",traceStart,screen->widgetCount);
+  return result;
+}
+
+typedef struct screen_lookup_args {
+  screen_definition *screen;
+  const char *name;
+  int elementId;
+  ScreenCallbackType type;
+} screen_lookup_args;
+
+static void *screen_find_element_internal(void *data)
+{
+  screen_lookup_args *args = data;
+  screen_definition *screen = args->screen;
+  if ( screen != shownScreen ) {
+    return NULL;
+  }
+  for ( int i = 0 ; i < screen->widgetCount ; i++ ) {
+    if ( screen->widgets[i].name && strcmp(screen->widgets[i].name,args->name) == 0 ) {
+      return (void*) (intptr_t) screen->elements[i]->elementId;
+    }
+  }
+  return NULL;
+}
+
+int screen_find_element(screen_definition *screen,const char *name)
+{
+  screen_lookup_args args = { screen, name, 0, 0 };
+  return (int) (intptr_t) render_exec_on_thread(screen_find_element_internal,&args,1);
+}
+
+static void *screen_get_callback_name_internal(void *data)
+{
+  screen_lookup_args *args = data;
+  if ( shownScreen == NULL ) {
+    return NULL;
+  }
+  for ( int i = 0 ; i < shownScreen->widgetCount ; i++ ) {
+    if ( shownScreen->elements[i]->elementId == args->elementId ) {
+      return (void*) shownScreen->widgets[i].callbackNames[args->type];
+    }
+  }
+  return NULL;
+}
+
+const char *screen_get_callback_name(int elementId,ScreenCallbackType type)
+{
+  if ( type < 0 || type >= SCREEN_CALLBACK_TYPE_COUNT ) {
+    return NULL;
+  }
+  screen_lookup_args args = { NULL, NULL, elementId, type };
+  return render_exec_on_thread(screen_get_callback_name_internal,&args,1);
+}
+
+void screen_close(void)
+{
+  render_exec_on_thread(screen_hide_internal,NULL,1);
+}
+
+static void *screen_release_internal(void *data)
+{
+  screen_definition *screen = data;
+  if ( screen == shownScreen ) {
+    screen_hide_internal(NULL);
+  }
+  for ( int i = 0 ; i < screen->widgetCount ; i++ )
+  {
+    screen_widget *widget = &screen->widgets[i];
+    if ( widget->imageEntry ) {
+      imagecache_release(widget->imageEntry,widget);
+      widget->imageEntry = NULL;
+    }
+  }
+  return (void*) (intptr_t) 1;
+}
+
+void screen_free(screen_definition *screen)
+{
+  render_exec_on_thread(screen_release_internal,screen,1);
+  screen_free_definition(screen);
+}
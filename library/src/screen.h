@@ -0,0 +1,138 @@
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "SDL/SDL.h"
+#include "ui_types.h"
+#include <pthread.h>
+
+/*
+ * Screens described by a text file.
+ *
+ * Loading a screen parses and validates the file on the calling thread and
+ * starts loading all images in the background. Showing a screen creates all of
+ * its elements up front and then replaces the previously shown screen with a
+ * single call to the rendering thread, the new screen is painted in the next frame.
+ * A screen can be shown any number of times, its images stay cached until it is freed.
+ *
+ * Each line of the file holds one widget:
+ *
+ *   # comment
+ *   screen background=#000000
+ *   container name=controls x=0 y=180 w=320 h=60 background=#202020 {
+ *     image_button name=play x=10 y=10 w=40 h=40 image=/usr/share/icons/play.png onclick=play
+ *     button x=60 y=10 w=80 h=40 text="Next track" onclick=next
+ *   }
+ *   progressbar name=position x=10 y=160 w=300 h=10 maximum=1000 onseek=seek
+ *   listview name=tracks x=0 y=0 w=320 labels=track_label count=track_count onclick=track_selected
+ *
+ * Widgets: button (text,onclick), image_button (image,onclick), listview (labels,count[,onclick]),
+ * progressbar (maximum[,onseek]) and container ([background]), containers enclose their children in { }.
+ * All widgets need x,y,w and h (list views: x,y and w) relative to their parent and may have a name,
+ * a z-order (z) and background, foreground and border colors (#rrggbb).
+ * Callback names are looked up through a resolver when the file is loaded.
+ */
+
+typedef enum {
+  SCREEN_CALLBACK_CLICK=0, // ButtonHandler (onclick of buttons)
+  SCREEN_CALLBACK_LABELS=1, // ListViewLabelProvider (labels)
+  SCREEN_CALLBACK_ITEM_COUNT=2, // ListViewItemCountProvider (count)
+  SCREEN_CALLBACK_ITEM_CLICK=3, // ListViewClickCallback (onclick of list views)
+  SCREEN_CALLBACK_SEEK=4 // ProgressBarSeekCallback (onseek)
+} ScreenCallbackType;
+
+#define SCREEN_CALLBACK_TYPE_COUNT 5
+
+// max. nesting depth of containers
+#define SCREEN_MAX_DEPTH 8
+
+// returns the function to invoke for a callback name, NULL if there is no such callback
+// void *resolver(callback name,callback type,resolver data)
+typedef void *(*ScreenCallbackResolver)(const char*,ScreenCallbackType,void*);
+
+typedef struct screen_widget
+{
+  struct screen_definition *screen;
+  UIElementType type;
+  int parent; // index of the parent container, -1 for top-level widgets
+  int line; // line of the file the widget was defined in
+  char *name; // NULL if the widget has no name
+  SDL_Rect bounds; // relative to the parent
+  int zOrder;
+  int hasBackground;
+  int hasForeground;
+  int hasBorder;
+  SDL_Color background;
+  SDL_Color foreground;
+  SDL_Color border;
+  char *text; // buttons
+  char *image; // image buttons
+  int maximum; // progress bars
+  char *callbackNames[SCREEN_CALLBACK_TYPE_COUNT];
+  void *callbacks[SCREEN_CALLBACK_TYPE_COUNT];
+  struct image_cache_entry *imageEntry; // keeps the image cached, only accessed from the rendering thread
+} screen_widget;
+
+typedef struct screen_definition
+{
+  char *path;
+  SDL_Color background;
+  SDL_Rect bounds; // the whole display
+  screen_widget *widgets; // parents come before their children
+  int widgetCount;
+  int capacity;
+  // while the screen is shown, only accessed from the rendering thread
+  ui_element *root;
+  ui_element **elements; // indexed like widgets
+  // images that have not been loaded yet
+  pthread_mutex_t preload_mutex;
+  pthread_cond_t preload_condition;
+  int pendingImages;
+} screen_definition;
+
+/**
+ * Loads a screen. Must not be called on the rendering thread.
+ *
+ * @param path screen file
+ * @param resolver looks up the callbacks named in the file
+ * @param resolverData data passed to the resolver
+ * @return screen (free with screen_free()) or NULL if the file could not be read or is invalid
+ */
+screen_definition *screen_load(const char *path,ScreenCallbackResolver resolver,void *resolverData);
+
+/**
+ * Replaces the currently shown screen (if any). Unless called on the rendering thread
+ * (from a callback), waits until all images of the screen have been loaded so that it appears at once.
+ *
+ * @param screen
+ * @return 0 on error, otherwise success
+ */
+int screen_show(screen_definition *screen);
+
+/**
+ * Looks up the ID of a named element of a screen.
+ * @param screen
+ * @param name
+ * @return element ID or 0 if the screen is not shown or has no such element
+ */
+int screen_find_element(screen_definition *screen,const char *name);
+
+/**
+ * Looks up the callback name an element of the shown screen was defined with.
+ * @param elementId
+ * @param type
+ * @return callback name or NULL if the element is not part of the shown screen or has no such callback
+ */
+const char *screen_get_callback_name(int elementId,ScreenCallbackType type);
+
+/**
+ * Hides the screen currently shown (if any).
+ */
+void screen_close(void);
+
+/**
+ * Frees a screen, hiding it first if it is shown. Must be called before the UI gets closed.
+ * @param screen
+ */
+void screen_free(screen_definition *screen);
+
+#endif
@@ -1,10 +1,11 @@
 #include "render.h"
 #include "ui_types.h"
+#include <stdint.h>
 
-int textfield_render_internal(ui_element *tf) 
+void *textfield_render_internal(void *tf) 
 {
   // TODO: Implement me!
-  return 0;
+  return NULL;
 }
 
 /**
@@ -13,7 +14,7 @@ int textfield_render_internal(ui_element *tf)
 int textfield_render(ui_element *tf) 
 {
   // TODO: Implement me!
-  return (int) render_exec_on_thread(textfield_render_internal,tf,1);
+  return (int) (intptr_t) render_exec_on_thread(textfield_render_internal,tf,1);
 }
 
 /**
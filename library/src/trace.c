@@ -0,0 +1,341 @@
+#define LOG_MODULE LOG_MODULE_RENDER
+
+#include "trace.h"
+#include "log.h"
+#include "mboxstats.h"
+#include "mempool.h"
+#include "memstats.h"
+#include "profiler.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct trace_event
+{
+  const char *category;
+  const char *name; // NULL for mailbox callbacks
+  void *func; // mailbox callback, resolved to a name when the event gets written
+  long startMicros;
+  long durationMicros;
+  long arg;
+} trace_event;
+
+/*
+ * Single-producer/single-consumer ring, the owning thread
+ * advances 'head', trace_flush() advances 'tail'.
+ */
+typedef struct trace_buffer
+{
+  struct trace_buffer *next;
+  int threadId;
+  const char *threadName; // only accessed while holding buffers_mutex
+  int threadNameWritten; // only accessed while holding buffers_mutex
+  int inUse; // cleared when the owning thread exits, only accessed while holding buffers_mutex
+  unsigned long head;
+  unsigned long tail;
+  unsigned long dropped;
+  trace_event events[TRACE_BUFFER_SIZE];
+} trace_buffer;
+
+// guards the list of thread buffers
+static pthread_mutex_t buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// guards the trace file
+static pthread_mutex_t file_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static trace_buffer *buffers = NULL;
+static int threadCount = 0;
+
+// incremented whenever all buffers get freed, invalidates the threads' buffer pointers
+static int bufferGeneration = 0;
+
+// holds the threadId of the calling thread's buffer, releases the buffer when the thread exits
+static pthread_key_t bufferKey;
+static pthread_once_t bufferKeyOnce = PTHREAD_ONCE_INIT;
+
+static int enabled = 0;
+
+// number of threads currently inside trace_record(), trace_stop() waits for them
+static int activeRecorders = 0;
+
+static FILE *traceFile = NULL;
+static int eventsWritten = 0;
+
+static __thread trace_buffer *threadBuffer = NULL;
+static __thread int threadBufferGeneration = 0;
+static __thread const char *threadName = NULL;
+
+int trace_is_enabled(void)
+{
+  return __atomic_load_n(&enabled,__ATOMIC_RELAXED);
+}
+
+void trace_set_thread_name(const char *name)
+{
+  threadName = name;
+  // the buffer is stale if trace_stop() freed it
+  pthread_mutex_lock(&buffers_mutex);
+  if ( threadBuffer && threadBufferGeneration == bufferGeneration ) {
+    threadBuffer->threadName = name;
+  }
+  pthread_mutex_unlock(&buffers_mutex);
+}
+
+/**
+ * Invoked when a thread that recorded events exits, its buffer
+ * can be reused by another thread once it has been drained.
+ * @param threadId threadId of the buffer
+ */
+static void trace_release_thread_buffer(void *threadId)
+{
+  pthread_mutex_lock(&buffers_mutex);
+  // the buffer is gone if all buffers were freed after the thread recorded its last event
+  for ( trace_buffer *buffer = buffers ; buffer ; buffer = buffer->next ) {
+    if ( buffer->threadId == (int) (intptr_t) threadId ) {
+      buffer->inUse = 0;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&buffers_mutex);
+}
+
+static void trace_create_buffer_key(void)
+{
+  if ( pthread_key_create(&bufferKey,trace_release_thread_buffer) != 0 ) {
+    log_error("trace_create_buffer_key(): Failed to create key, buffers of exited threads won't be reused");
+  }
+}
+
+/**
+ * Returns the calling thread's buffer, reusing the drained buffer
+ * of an exited thread or allocating a new one on first use.
+ * Must be called while tracing is enabled.
+ */
+static trace_buffer *trace_get_thread_buffer(void)
+{
+  int generation = __atomic_load_n(&bufferGeneration,__ATOMIC_ACQUIRE);
+  if ( threadBuffer && threadBufferGeneration == generation ) {
+    return threadBuffer;
+  }
+  pthread_once(&bufferKeyOnce,trace_create_buffer_key);
+
+  pthread_mutex_lock(&buffers_mutex);
+  trace_buffer *buffer = buffers;
+  while ( buffer && ( buffer->inUse || __atomic_load_n(&buffer->head,__ATOMIC_ACQUIRE) != buffer->tail ) ) {
+    buffer = buffer->next;
+  }
+  if ( buffer == NULL )
+  {
+    buffer = mem_calloc(1,sizeof(trace_buffer));
+    if ( ! buffer ) {
+      pthread_mutex_unlock(&buffers_mutex);
+      log_error("trace_get_thread_buffer(): Failed to allocate %d bytes",sizeof(trace_buffer));
+      return NULL;
+    }
+    memstats_add(MEM_CATEGORY_POOLS,sizeof(trace_buffer));
+    buffer->next = buffers;
+    buffers = buffer;
+  }
+  // a new ID, so the viewer does not mix up the events of the previous owner with this thread's
+  buffer->threadId = ++threadCount;
+  buffer->threadName = threadName;
+  buffer->threadNameWritten = 0;
+  buffer->inUse = 1;
+  pthread_mutex_unlock(&buffers_mutex);
+
+  pthread_setspecific(bufferKey,(void*) (intptr_t) buffer->threadId);
+  threadBuffer = buffer;
+  threadBufferGeneration = generation;
+  return buffer;
+}
+
+/**
+ * Frees all thread buffers.
+ * Must be called while holding file_mutex with tracing disabled and no thread inside trace_record().
+ */
+static void trace_free_buffers(void)
+{
+  pthread_mutex_lock(&buffers_mutex);
+  while ( buffers )
+  {
+    trace_buffer *next = buffers->next;
+    free(buffers);
+    memstats_remove(MEM_CATEGORY_POOLS,sizeof(trace_buffer));
+    buffers = next;
+  }
+  __atomic_fetch_add(&bufferGeneration,1,__ATOMIC_RELEASE);
+  pthread_mutex_unlock(&buffers_mutex);
+}
+
+long trace_begin(void)
+{
+  if ( ! trace_is_enabled() ) {
+    return 0;
+  }
+  return profiler_now_micros();
+}
+
+static void trace_record(const char *category,const char *name,void *func,long startMicros,long arg)
+{
+  if ( startMicros == 0 ) {
+    return;
+  }
+  long now = profiler_now_micros();
+  // spans that were still open when tracing stopped are dropped, their buffer may be gone
+  __atomic_fetch_add(&activeRecorders,1,__ATOMIC_SEQ_CST);
+  if ( ! __atomic_load_n(&enabled,__ATOMIC_SEQ_CST) ) {
+    __atomic_fetch_sub(&activeRecorders,1,__ATOMIC_SEQ_CST);
+    return;
+  }
+  trace_buffer *buffer = trace_get_thread_buffer();
+  if ( ! buffer ) {
+    __atomic_fetch_sub(&activeRecorders,1,__ATOMIC_SEQ_CST);
+    return;
+  }
+  unsigned long head = buffer->head;
+  if ( head - __atomic_load_n(&buffer->tail,__ATOMIC_ACQUIRE) >= TRACE_BUFFER_SIZE ) {
+    __atomic_fetch_add(&buffer->dropped,1,__ATOMIC_RELAXED);
+    __atomic_fetch_sub(&activeRecorders,1,__ATOMIC_SEQ_CST);
+    return;
+  }
+  trace_event *event = &buffer->events[head % TRACE_BUFFER_SIZE];
+  event->category = category;
+  event->name = name;
+  event->func = func;
+  event->startMicros = startMicros;
+  event->durationMicros = now - startMicros;
+  event->arg = arg;
+  __atomic_store_n(&buffer->head,head+1,__ATOMIC_RELEASE);
+  __atomic_fetch_sub(&activeRecorders,1,__ATOMIC_SEQ_CST);
+}
+
+void trace_end(const char *category,const char *name,long startMicros,long arg)
+{
+  trace_record(category,name,NULL,startMicros,arg);
+}
+
+void trace_end_callback(const char *category,void *func,long startMicros)
+{
+  trace_record(category,NULL,func,startMicros,TRACE_NO_ARG);
+}
+
+/**
+ * Writes an event to the trace file.
+ * Must be called while holding file_mutex.
+ */
+static void trace_write_event(trace_buffer *buffer,trace_event *event)
+{
+  char address[32];
+  const char *name = event->name;
+  if ( ! name ) {
+    name = mboxstats_get_name(event->func);
+  }
+  if ( ! name ) {
+    snprintf(address,sizeof(address),"%p",event->func);
+    name = address;
+  }
+  fprintf(traceFile,"%s{\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%ld,\"dur\":%ld,\"cat\":\"%s\",\"name\":\"%s\"",
+          eventsWritten++ > 0 ? ",\n" : "",(int) getpid(),buffer->threadId,event->startMicros,event->durationMicros,event->category,name);
+  if ( event->arg != TRACE_NO_ARG ) {
+    fprintf(traceFile,",\"args\":{\"arg\":%ld}",event->arg);
+  }
+  fputs("}",traceFile);
+}
+
+/**
+ * Writes the events of all thread buffers to the trace file.
+ * Must be called while holding file_mutex.
+ */
+static void trace_drain(void)
+{
+  pthread_mutex_lock(&buffers_mutex);
+  for ( trace_buffer *buffer = buffers ; buffer ; buffer = buffer->next )
+  {
+    unsigned long head = __atomic_load_n(&buffer->head,__ATOMIC_ACQUIRE);
+    unsigned long tail = buffer->tail;
+    const char *name = buffer->threadName;
+    if ( ! buffer->threadNameWritten && name )
+    {
+      fprintf(traceFile,"%s{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+              eventsWritten++ > 0 ? ",\n" : "",(int) getpid(),buffer->threadId,name);
+      buffer->threadNameWritten = 1;
+    }
+    for ( ; tail != head ; tail++ ) {
+      trace_write_event(buffer,&buffer->events[tail % TRACE_BUFFER_SIZE]);
+    }
+    __atomic_store_n(&buffer->tail,head,__ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&buffers_mutex);
+}
+
+int trace_start(const char *path)
+{
+  pthread_mutex_lock(&file_mutex);
+  if ( traceFile ) {
+    pthread_mutex_unlock(&file_mutex);
+    log_warn("trace_start(): Already writing a trace");
+    return 0;
+  }
+  traceFile = fopen(path,"w");
+  if ( ! traceFile ) {
+    pthread_mutex_unlock(&file_mutex);
+    log_error("trace_start(): Failed to open %s",path);
+    return 0;
+  }
+  // nothing is recorded while tracing is disabled, all buffers were freed by trace_stop()
+  eventsWritten = 0;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n",traceFile);
+  __atomic_store_n(&enabled,1,__ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&file_mutex);
+
+  log_info("Writing trace to %s",path);
+  return 1;
+}
+
+void trace_flush(void)
+{
+  pthread_mutex_lock(&file_mutex);
+  if ( traceFile ) {
+    trace_drain();
+    fflush(traceFile);
+  }
+  pthread_mutex_unlock(&file_mutex);
+}
+
+void trace_stop(void)
+{
+  pthread_mutex_lock(&file_mutex);
+  if ( traceFile )
+  {
+    __atomic_store_n(&enabled,0,__ATOMIC_SEQ_CST);
+    // threads inside trace_record() may still be writing into their buffers
+    while ( __atomic_load_n(&activeRecorders,__ATOMIC_SEQ_CST) > 0 ) {
+      sched_yield();
+    }
+    trace_drain();
+    fputs("\n]}\n",traceFile);
+    fclose(traceFile);
+    traceFile = NULL;
+
+    unsigned long dropped = trace_get_dropped_count();
+    if ( dropped > 0 ) {
+      log_warn("trace_stop(): %lu events were dropped, flush more often",dropped);
+    }
+    trace_free_buffers();
+  }
+  pthread_mutex_unlock(&file_mutex);
+}
+
+unsigned long trace_get_dropped_count(void)
+{
+  unsigned long result = 0;
+  pthread_mutex_lock(&buffers_mutex);
+  for ( trace_buffer *buffer = buffers ; buffer ; buffer = buffer->next ) {
+    result += __atomic_load_n(&buffer->dropped,__ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&buffers_mutex);
+  return result;
+}
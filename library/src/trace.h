@@ -0,0 +1,83 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Records spans (frames, mailbox callbacks, draws, touch dispatch, user callbacks)
+ * in Chrome's trace event format so they can be viewed in chrome://tracing or Perfetto.
+ *
+ * Each thread records into its own fixed-size buffer without taking any locks,
+ * buffers get drained into the trace file by trace_flush(). Events that do not fit
+ * into a thread's buffer are dropped and counted.
+ *
+ * Thread buffers are allocated on first use (while tracing is active) and
+ * accounted under MEM_CATEGORY_POOLS. The drained buffer of an exited thread
+ * is reused by the next thread, trace_stop() frees all buffers.
+ */
+
+// number of events each thread can buffer between two flushes
+#define TRACE_BUFFER_SIZE 8192
+
+// value to pass as 'arg' if a span has no argument
+#define TRACE_NO_ARG -1
+
+/**
+ * Starts writing a trace file. Tracing is disabled until this function is called.
+ * Events recorded before this call are discarded.
+ *
+ * @param path file to write
+ * @return 0 on error or if a trace is already being written, otherwise success
+ */
+int trace_start(const char *path);
+
+/**
+ * Writes all buffered events to the trace file.
+ * Does nothing if no trace is being written.
+ */
+void trace_flush(void);
+
+/**
+ * Flushes all buffered events and closes the trace file.
+ * Does nothing if no trace is being written.
+ */
+void trace_stop(void);
+
+int trace_is_enabled(void);
+
+/**
+ * Assigns a name to the calling thread that is shown in the trace viewer.
+ * @param name name, must be a string literal
+ */
+void trace_set_thread_name(const char *name);
+
+/**
+ * Starts a span.
+ * @return timestamp to pass to trace_end(), 0 if tracing is disabled
+ */
+long trace_begin(void);
+
+/**
+ * Records a span on the calling thread.
+ *
+ * @param category category, must be a string literal
+ * @param name name, must be a string literal
+ * @param startMicros value returned by trace_begin(), the span is ignored if this is 0
+ * @param arg numeric argument (element ID, event type, ...) or TRACE_NO_ARG
+ */
+void trace_end(const char *category,const char *name,long startMicros,long arg);
+
+/**
+ * Records a span for a mailbox callback, the span is named after the callback
+ * (see mboxstats_set_name()).
+ *
+ * @param category category, must be a string literal
+ * @param func callback
+ * @param startMicros value returned by trace_begin(), the span is ignored if this is 0
+ */
+void trace_end_callback(const char *category,void *func,long startMicros);
+
+/**
+ * Returns the number of events dropped because a thread's buffer was full.
+ */
+unsigned long trace_get_dropped_count(void);
+
+#endif
@@ -10,6 +10,8 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include "global.h"
+#include "mempool.h"
+#include "trace.h"
 
 static pthread_mutex_t ui_mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -21,27 +23,35 @@ static ui_element *uiElements = NULL;
 // UI element that currently receives all input events
 static ui_element *focusedElement = NULL;
 
+// max. nesting depth of ui_begin_container() calls
+#define UI_MAX_CONTAINER_DEPTH 8
+
+// containers new elements get added to, guarded by ui_mutex
+static ui_element *containerStack[UI_MAX_CONTAINER_DEPTH];
+static int containerStackSize = 0;
+
 /*
  * Data specific to the focused list view (if any)
  */
 static int listViewMaxYDelta = 0;
 static int listViewTouchStartY = -1;
 
-/**
- * Frees all UI elements.
- */
-void ui_free_all() 
+void ui_free_all(void) 
 {
   pthread_mutex_lock(&ui_mutex);
   ui_element *current = uiElements;
+  uiElements  = NULL;
+  focusedElement = NULL;
+  containerStackSize = 0;
+  pthread_mutex_unlock(&ui_mutex);
+  
+  // freeing waits for the rendering thread, which takes ui_mutex while handling input
   while ( current ) 
   {
     ui_element *next = current -> next;
     render_free_element(current);
     current = next;
   }
-  uiElements  = NULL;
-  pthread_mutex_unlock(&ui_mutex);
 }
 
 /**
@@ -69,99 +79,307 @@ int ui_add_element(ui_element *entry)
 }
 
 /**
- * Removes (discards) a UI element.
- * @param entry element to discard.
+ * Unregisters a UI element without freeing it, its ID can no longer be looked up.
+ * @param entry element to unregister
+ * @return 0 if the element was not registered, otherwise success
  */
-void ui_remove_element(ui_element *entry) 
+int ui_unregister_element(ui_element *entry) 
 {
     int removed = 0;
     
     pthread_mutex_lock(&ui_mutex);
     
-    ui_element *previous = NULL;    
-    ui_element *current = uiElements;
-    while ( current ) 
+    ui_element **current = &uiElements;
+    while ( *current ) 
     {
-      if ( current == entry ) 
+      if ( *current == entry ) 
       {
-          previous->next = current->next;
-          render_free_element( current );
+          *current = entry->next;
+          entry->next = NULL;
           removed = 1;
           break;
       }
-      previous = current;
-      current = current->next;
+      current = &(*current)->next;
+    }
+    // a finger may still rest on the element
+    if ( focusedElement == entry ) {
+      focusedElement = NULL;
     }
     
     pthread_mutex_unlock(&ui_mutex);
-    if ( ! removed ) {
+    return removed;
+}
+
+/**
+ * Removes (discards) a UI element.
+ * @param entry element to discard.
+ */
+void ui_remove_element(ui_element *entry) 
+{
+    if ( ui_unregister_element(entry) ) {
+      render_free_element(entry);
+    } else {
       log_error("Failed to remove entry with type %d and ID %d",entry->type,entry->elementId);    
     }
 }
 
-#define CONTAINS(bounds,x,y) (( x >= (bounds)->x && y >= (bounds)->y && x <= ((bounds)->x + (bounds)->w) && y <= ((bounds)->y + (bounds)->h) ) ? 1 : 0)
-
 /**
- * Finds the UI element at the given coordinates while NOT aquiring the global lock.
+ * Finds the topmost UI element at the given coordinates while NOT aquiring the global lock.
+ * Containers are never returned.
+ * 
  * @param x
  * @param y
  * @return UI element or NULL
  */
 static ui_element *ui_find_element_nolock(int x,int y) 
 {
-  ui_element * result = NULL;
-  
-  ui_element *current = uiElements;
-  while ( current ) 
-  {
-    if ( CONTAINS(&current->bounds,x,y) ) 
-    {
-      result = current;
-      break;
-    }
-    current = current->next;
-  }
-  return result;
+  return render_find_element_at(x,y);
 }
 
 /**
- * Finds the UI element at the given coordinates.
+ * Finds the topmost UI element at the given coordinates.
+ * 
+ * The lookup runs on the rendering thread, which may itself be
+ * waiting for the global lock, so the lock must NOT be held here.
  * 
  * @param x
  * @param y
  * @return UI element or NULL
  */
 ui_element *ui_find_element(int x,int y) 
+{
+  return ui_find_element_nolock(x,y);
+}
+
+/**
+ * Finds the UI element with the given ID.
+ * 
+ * @param elementId
+ * @return UI element or NULL
+ */
+ui_element *ui_find_element_by_id(int elementId) 
 {
   pthread_mutex_lock(&ui_mutex);
-  ui_element * result = ui_find_element_nolock(x,y);
+  ui_element *current = uiElements;
+  while ( current && current->elementId != elementId ) 
+  {
+    current = current->next;
+  }
+  pthread_mutex_unlock(&ui_mutex);
+  return current;
+}
+
+/**
+ * Returns the container new elements should be added to.
+ * @return container or NULL for top-level elements
+ */
+static ui_element *ui_get_current_container(void) 
+{
+  pthread_mutex_lock(&ui_mutex);
+  ui_element *result = containerStackSize > 0 ? containerStack[containerStackSize-1] : NULL;
   pthread_mutex_unlock(&ui_mutex);
   return result;
 }
 
 /**
- * Create a button.
- * 
- * @param text button label
- * @param bounds button bounds
- * @param clickHandler callback invoked when the button is pressed_button
- * 
- * @return 0 on error, otherwise the button ID of the newly created button
+ * Adds an element to the current container and draws it.
+ * @param element
+ * @return 0 on error, otherwise success
  */
-int ui_add_button(char *text,SDL_Rect *bounds,ButtonHandler clickHandler) 
+static int ui_attach_and_draw(ui_element *element) 
+{
+  return render_attach_element(ui_get_current_container(),element) && render_draw(element);
+}
+
+ui_element *ui_create_container(SDL_Rect *bounds,SDL_Color *background) 
+{
+  ui_element *element = render_allocate_element( UI_CONTAINER );
+  if ( ! element ) {
+    log_error("ui_create_container(): Failed to allocate element");
+    return NULL;        
+  }
+  container_entry *entry = render_allocate_container_entry();
+  if ( ! entry ) {
+    render_free_element(element);
+    log_error("ui_create_container(): Failed to allocate entry");
+    return NULL;  
+  }
+  element->container = entry;
+  element->bounds = *bounds;
+  if ( background ) {
+    element->backgroundColor = *background;
+  } else {
+    entry->transparent = 1;
+  }
+  return element;
+}
+
+int ui_add_container(SDL_Rect *bounds,SDL_Color *background) 
+{
+  ui_element *element = ui_create_container(bounds,background);
+  if ( element == NULL ) {
+    return 0;
+  }
+  if ( ui_attach_and_draw(element) ) {
+    return ui_add_element(element);
+  }
+  render_free_element(element);
+  return 0;
+}
+
+int ui_add_page(SDL_Color *background) 
+{
+  viewport_desc viewport;
+  if ( ! render_get_viewport_desc(&viewport) ) {
+    return 0;
+  }
+  SDL_Rect bounds = { 0, 0, viewport.width, viewport.height };
+  SDL_Color black = {0,0,0};
+  ui_element *element = ui_create_container(&bounds,background ? background : &black);
+  if ( element == NULL ) {
+    return 0;
+  }
+  if ( render_add_page(element) ) {
+    return ui_add_element(element);
+  }
+  render_free_element(element);
+  return 0;
+}
+
+static ui_element *ui_find_page(const char *function,int pageId) 
+{
+  ui_element *element = ui_find_element_by_id(pageId);
+  if ( element == NULL || element->type != UI_CONTAINER ) {
+    log_error("%s(): No page with ID %d",function,pageId);
+    return NULL;
+  }
+  return element;
+}
+
+int ui_push_page(int pageId,PageTransition transition,long durationMicros) 
+{
+  ui_element *element = ui_find_page("ui_push_page",pageId);
+  return element ? render_push_page(element,transition,durationMicros) : 0;
+}
+
+int ui_pop_page(PageTransition transition,long durationMicros) 
+{
+  return render_pop_page(transition,durationMicros);
+}
+
+int ui_show_page(int pageId,PageTransition transition,long durationMicros) 
+{
+  ui_element *element = ui_find_page("ui_show_page",pageId);
+  return element ? render_show_page(element,transition,durationMicros) : 0;
+}
+
+int ui_get_active_page(void) 
+{
+  ui_element *element = render_get_active_page();
+  return element ? element->elementId : 0;
+}
+
+int ui_begin_container(int containerId) 
+{
+  ui_element *element = ui_find_element_by_id(containerId);
+  if ( element == NULL || element->type != UI_CONTAINER ) {
+    log_error("ui_begin_container(): No container with ID %d",containerId);
+    return 0;
+  }
+  int result = 0;
+  pthread_mutex_lock(&ui_mutex);
+  if ( containerStackSize < UI_MAX_CONTAINER_DEPTH ) {
+    containerStack[containerStackSize++] = element;
+    result = 1;
+  }
+  pthread_mutex_unlock(&ui_mutex);
+  
+  if ( ! result ) {
+    log_error("ui_begin_container(): Containers nested too deeply");
+  }
+  return result;
+}
+
+void ui_end_container(void) 
+{
+  pthread_mutex_lock(&ui_mutex);
+  if ( containerStackSize > 0 ) {
+    containerStackSize--;
+  } else {
+    log_warn("ui_end_container(): No matching ui_begin_container()");
+  }
+  pthread_mutex_unlock(&ui_mutex);
+}
+
+int ui_set_z_order(int elementId,int zOrder) 
+{
+  ui_element *element = ui_find_element_by_id(elementId);
+  if ( element == NULL ) {
+    log_error("ui_set_z_order(): No element with ID %d",elementId);
+    return 0;
+  }
+  return render_set_z_order(element,zOrder);
+}
+
+int ui_set_layout(int containerId,LayoutType type,int padding,int spacing,int columns) 
+{
+  ui_element *element = ui_find_element_by_id(containerId);
+  if ( element == NULL ) {
+    log_error("ui_set_layout(): No element with ID %d",containerId);
+    return 0;
+  }
+  return layout_set_params(element,type,padding,spacing,columns);
+}
+
+int ui_set_layout_size(int elementId,int width,int height,int weight) 
+{
+  ui_element *element = ui_find_element_by_id(elementId);
+  if ( element == NULL ) {
+    log_error("ui_set_layout_size(): No element with ID %d",elementId);
+    return 0;
+  }
+  return layout_set_size(element,width,height,weight);
+}
+
+int ui_animate(int elementId,AnimProperty property,long to,long durationMicros,EasingFunction easing) 
+{
+  ui_element *element = ui_find_element_by_id(elementId);
+  if ( element == NULL ) {
+    log_error("ui_animate(): No element with ID %d",elementId);
+    return 0;
+  }
+  return animation_start(element,property,to,durationMicros,easing,NULL,NULL);
+}
+
+int ui_cancel_animation(int animationId) 
+{
+  return animation_cancel(animationId);
+}
+
+int ui_invalidate(int elementId) 
+{
+  ui_element *element = ui_find_element_by_id(elementId);
+  if ( element == NULL ) {
+    log_error("ui_invalidate(): No element with ID %d",elementId);
+    return 0;
+  }
+  return render_invalidate(element);
+}
+
+ui_element *ui_create_button(const char *text,SDL_Rect *bounds,ButtonHandler clickHandler) 
 {
     ui_element *element = render_allocate_element( UI_BUTTON );
     if ( ! element ) {
-      log_error("ui_add_button(): Failed to allocate memory");      
-      return 0;  
+      log_error("ui_create_button(): Failed to allocate memory");      
+      return NULL;  
     }
     
-    button_entry *entry = calloc(1,sizeof(button_entry));
+    button_entry *entry = render_allocate_button_entry();
     if ( entry == NULL ) 
     {
       render_free_element( element );
-      log_error("ui_add_button(): Failed to allocate memory");
-      return 0;
+      log_error("ui_create_button(): Failed to allocate memory");
+      return NULL;
     }
     element->button = entry;
     
@@ -169,9 +387,35 @@ int ui_add_button(char *text,SDL_Rect *bounds,ButtonHandler clickHandler)
     entry->pressed=0;       
     entry->cornerRadius = 3;
     element->bounds = *bounds;
-    entry->text = strdup(text);
-    
-    int result = render_draw(element);
+    if ( text ) 
+    {
+      entry->text = mem_strdup(text);
+      if ( entry->text == NULL ) 
+      {
+        render_free_element( element );
+        log_error("ui_create_button(): Failed to allocate memory");
+        return NULL;
+      }
+    }
+    return element;
+}
+
+/**
+ * Create a button.
+ * 
+ * @param text button label
+ * @param bounds button bounds
+ * @param clickHandler callback invoked when the button is pressed_button
+ * 
+ * @return 0 on error, otherwise the button ID of the newly created button
+ */
+int ui_add_button(char *text,SDL_Rect *bounds,ButtonHandler clickHandler) 
+{
+    ui_element *element = ui_create_button(text,bounds,clickHandler);
+    if ( element == NULL ) {
+      return 0;
+    }
+    int result = ui_attach_and_draw(element);
     if ( result ) 
     {
       return ui_add_element(element);
@@ -182,76 +426,90 @@ int ui_add_button(char *text,SDL_Rect *bounds,ButtonHandler clickHandler)
     return 0;
 }
 
+int ui_set_button_text(int buttonId,const char *text) 
+{
+  ui_element *element = ui_find_element_by_id(buttonId);
+  if ( element == NULL ) {
+    log_error("ui_set_button_text(): No element with ID %d",buttonId);
+    return 0;
+  }
+  return render_button_set_text(element,text);
+}
+
 int ui_add_image_button(char *image,SDL_Rect *bounds,ButtonHandler clickHandler) 
 {
-    ui_element *element = render_allocate_element( UI_BUTTON );
-    if ( ! element ) {
-      log_error("ui_add_image_button(): Failed to allocate image button");
+    ui_element *element = ui_create_button(NULL,bounds,clickHandler);
+    if ( element == NULL ) {
       return 0;
     }
-    button_entry *entry = calloc(1,sizeof(button_entry));
-    if ( entry == NULL ) 
+    if ( ! ui_attach_and_draw(element) ) 
     {
       render_free_element(element);
-      log_error("ui_add_image_button(): Failed to allocate image button");
-      return 0;
+      return 0;    
     }
-    element->button = entry;
-    
-    entry->clickHandler = clickHandler;
-    entry->pressed=0;       
-    entry->cornerRadius = 3;
-    element->bounds = *bounds;
-    entry->image = render_load_image(image);
-    
-    if ( entry->image && render_draw(element) ) 
-    {
-      return ui_add_element(element);        
+    int buttonId = ui_add_element(element);
+    if ( ! render_load_button_image(element,image) ) {
+      log_error("ui_add_image_button(): Failed to queue loading %s",image);
     }
-    render_free_element(element);
-    return 0;    
+    return buttonId;
 }
 
 // ================================================
 
-/**
- * Adds a new button.
- * @param bounds the button's bounds
- * @param labelProvider callback that gets invoked to retrieve the label for a given item
- * @param itemCountProvider callback that gets invoked to determine the number of items that are available
- * @param clickCallback callback that gets invoked when the user clicks on an item
- * 
- * @return the listview's ID (always >0) if everything worked ok, otherwise 0
- */
-int ui_add_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListViewItemCountProvider itemCountProvider, ListViewClickCallback clickCallback) 
+ui_element *ui_create_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListViewItemCountProvider itemCountProvider, ListViewClickCallback clickCallback) 
 {
   ui_element *element = render_allocate_element( UI_LISTVIEW );
   if ( ! element ) {
-    log_error("ui_add_listview(): Failed to allocate element");
-    return 0;        
+    log_error("ui_create_listview(): Failed to allocate element");
+    return NULL;        
   }
   
-  listview_entry *entry = calloc(1,sizeof(listview_entry));
+  listview_entry *entry = render_allocate_listview_entry();
   if ( ! entry  ) {
     render_free_element(element);
-    log_error("ui_add_listview(): Failed to allocate entry");
-    return 0;  
+    log_error("ui_create_listview(): Failed to allocate entry");
+    return NULL;  
   }
   element->listview = entry;
   
+  entry->labelCache = labelcache_allocate();
+  if ( ! entry->labelCache ) {
+    render_free_element(element);
+    log_error("ui_create_listview(): Failed to allocate label cache");
+    return NULL;  
+  }
+  
   entry->labelProvider = labelProvider;
   entry->itemCountProvider = itemCountProvider;
   entry->clickCallback = clickCallback;
   
   entry->yStartOffset = 15;
-  entry->visibleItemCount=5;
+  // only whole items are shown
+  entry->visibleItemCount = bounds->h >= LISTVIEW_ITEM_HEIGHT ? bounds->h / LISTVIEW_ITEM_HEIGHT : LISTVIEW_DEFAULT_VISIBLE_ITEMS;
   
   element->bounds.x = bounds->x;
   element->bounds.y = bounds->y;
   element->bounds.w = bounds->w;
   element->bounds.h = entry->visibleItemCount * LISTVIEW_ITEM_HEIGHT;  
-  
-  if ( render_draw(element) ) 
+  return element;
+}
+
+/**
+ * Adds a new button.
+ * @param bounds the button's bounds
+ * @param labelProvider callback that gets invoked to retrieve the label for a given item
+ * @param itemCountProvider callback that gets invoked to determine the number of items that are available
+ * @param clickCallback callback that gets invoked when the user clicks on an item
+ * 
+ * @return the listview's ID (always >0) if everything worked ok, otherwise 0
+ */
+int ui_add_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListViewItemCountProvider itemCountProvider, ListViewClickCallback clickCallback) 
+{
+  ui_element *element = ui_create_listview(bounds,labelProvider,itemCountProvider,clickCallback);
+  if ( element == NULL ) {
+    return 0;
+  }
+  if ( ui_attach_and_draw(element) ) 
   {
     return ui_add_element(element);
   }
@@ -259,12 +517,134 @@ int ui_add_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListVi
   return 0;
 }
 
+/**
+ * Looks up a list view by ID.
+ * @param listViewId
+ * @return list view or NULL 
+ */
+static ui_element *ui_find_listview(int listViewId) 
+{
+  ui_element *element = ui_find_element_by_id(listViewId);
+  if ( element == NULL || element->type != UI_LISTVIEW ) {
+    log_error("ui_find_listview(): No list view with ID %d",listViewId);
+    return NULL;
+  }
+  return element;
+}
+
+int ui_listview_invalidate_item(int listViewId,int itemIndex) 
+{
+  return ui_listview_invalidate_range(listViewId,itemIndex,1);
+}
+
+int ui_listview_invalidate_range(int listViewId,int firstIndex,int count) 
+{
+  ui_element *element = ui_find_listview(listViewId);
+  if ( element == NULL || count < 0 ) {
+    return 0;  
+  }
+  return render_listview_invalidate(element,firstIndex,count);
+}
+
+int ui_listview_invalidate_all(int listViewId) 
+{
+  ui_element *element = ui_find_listview(listViewId);
+  if ( element == NULL ) {
+    return 0;  
+  }
+  return render_listview_invalidate(element,0,-1);
+}
+
+int ui_listview_set_item_count(int listViewId,int itemCount) 
+{
+  ui_element *element = ui_find_listview(listViewId);
+  if ( element == NULL || itemCount < 0 ) {
+    return 0;  
+  }
+  return render_listview_set_item_count(element,itemCount);
+}
+
 // ======================================== END listview ==================
 
+ui_element *ui_create_progressbar(SDL_Rect *bounds,int maximum,ProgressBarSeekCallback seekCallback) 
+{
+  ui_element *element = render_allocate_element( UI_PROGRESSBAR );
+  if ( ! element ) {
+    log_error("ui_create_progressbar(): Failed to allocate element");
+    return NULL;        
+  }
+  progressbar_entry *entry = render_allocate_progressbar_entry();
+  if ( ! entry ) {
+    render_free_element(element);
+    log_error("ui_create_progressbar(): Failed to allocate entry");
+    return NULL;  
+  }
+  element->progressbar = entry;
+  element->bounds = *bounds;
+  ASSIGN_COLOR(&element->backgroundColor,64,64,64);
+  ASSIGN_COLOR(&element->foregroundColor,0,160,255);
+  
+  entry->maximum = maximum;
+  entry->seekCallback = seekCallback;
+  return element;
+}
+
+int ui_add_progressbar(SDL_Rect *bounds,int maximum,ProgressBarSeekCallback seekCallback) 
+{
+  ui_element *element = ui_create_progressbar(bounds,maximum,seekCallback);
+  if ( element == NULL ) {
+    return 0;
+  }
+  if ( ui_attach_and_draw(element) ) {
+    return ui_add_element(element);
+  }
+  render_free_element(element);
+  return 0;
+}
+
+/**
+ * Looks up a progress bar by ID.
+ * @param progressBarId
+ * @return progress bar or NULL 
+ */
+static ui_element *ui_find_progressbar(int progressBarId) 
+{
+  ui_element *element = ui_find_element_by_id(progressBarId);
+  if ( element == NULL || element->type != UI_PROGRESSBAR ) {
+    log_error("ui_find_progressbar(): No progress bar with ID %d",progressBarId);
+    return NULL;
+  }
+  return element;
+}
+
+int ui_progressbar_set_value(int progressBarId,int value) 
+{
+  ui_element *element = ui_find_progressbar(progressBarId);
+  if ( element == NULL ) {
+    return 0;  
+  }
+  render_progressbar_set_value(element,value);
+  return 1;
+}
+
+int ui_progressbar_set_maximum(int progressBarId,int maximum) 
+{
+  ui_element *element = ui_find_progressbar(progressBarId);
+  if ( element == NULL || maximum < 0 ) {
+    return 0;  
+  }
+  render_progressbar_set_maximum(element,maximum);
+  return 1;
+}
+
+// ======================================== END progressbar ==================
+
 static ui_element * ui_handle_touch_event_button(ui_element *element,TouchEvent *event) 
 {
   button_entry *button = element == NULL ? NULL : element->button;
   button_entry *focusedButton = focusedElement == NULL ? NULL : focusedElement->button;
+  ButtonHandler callbackToInvoke = NULL;
+  int clickedButtonId = 0;
   
   if ( event->type == TOUCH_START ) 
   {
@@ -295,7 +675,8 @@ static ui_element * ui_handle_touch_event_button(ui_element *element,TouchEvent
       render_draw(focusedElement);           
       
       log_debug("Detected click on '%s'\n",focusedButton->text);
-      focusedButton->clickHandler(focusedElement->elementId);           
+      callbackToInvoke = focusedButton->clickHandler;
+      clickedButtonId = focusedElement->elementId;
     }
     focusedElement = NULL;    
   } 
@@ -324,6 +705,14 @@ static ui_element * ui_handle_touch_event_button(ui_element *element,TouchEvent
   }  
   
   pthread_mutex_unlock(&ui_mutex);  
+  
+  // the handler may modify the UI (e.g. switch screens), which needs the lock
+  if ( callbackToInvoke != NULL ) 
+  {
+    long traceStart = trace_begin();
+    callbackToInvoke(clickedButtonId);           
+    trace_end("user","button_handler",traceStart,clickedButtonId);
+  }
   return focusedElement;
 }
 
@@ -356,7 +745,9 @@ static ui_element * ui_handle_touch_event_listview(ui_element *element, TouchEve
     {
       log_info("ui_handle_touch_event_listview(): TOUCH_STOP listview %d",listViewId);         
       // calculate item index
-      int realY = (listViewTouchStartY - focusedElement->bounds.y) + listview->yStartOffset;
+      SDL_Rect absolute;
+      render_get_absolute_bounds(focusedElement,&absolute);
+      int realY = (listViewTouchStartY - absolute.y) + listview->yStartOffset;
       clickedItemIdx = ( realY / LISTVIEW_ITEM_HEIGHT ); 
       callbackToInvoke = listview->clickCallback;
     }
@@ -373,7 +764,7 @@ static ui_element * ui_handle_touch_event_listview(ui_element *element, TouchEve
     }
     int newOffset = listview->yStartOffset + delta/2;
     
-    int items = listview->itemCountProvider(focusedElement->elementId);
+    int items = render_listview_get_item_count(focusedElement);
     int maxOffset;
     if ( items <= listview->visibleItemCount ) {
       maxOffset = 0;  
@@ -393,11 +784,59 @@ static ui_element * ui_handle_touch_event_listview(ui_element *element, TouchEve
   
   if ( callbackToInvoke != NULL ) 
   {
+    long traceStart = trace_begin();
     callbackToInvoke(listViewId,clickedItemIdx);
+    trace_end("user","listview_click_handler",traceStart,listViewId);
   }
   return focusedElement;  
 }
 
+/**
+ * Lets the user drag a progress bar, the seek callback gets invoked once the finger is lifted.
+ * Runs on the rendering thread, so the seek state of the bar may be accessed directly.
+ */
+static ui_element * ui_handle_touch_event_progressbar(ui_element *element, TouchEvent *event) 
+{
+  ui_element *bar = focusedElement ? focusedElement : element;
+  progressbar_entry *progressbar = bar->progressbar;
+  ProgressBarSeekCallback callbackToInvoke = NULL;
+  
+  if ( event->type == TOUCH_START && progressbar->seekCallback ) {
+    focusedElement = bar;
+    progressbar->seeking = 1;
+  } 
+  
+  if ( focusedElement ) 
+  {
+    // the finger may leave the bar while dragging, the value is clamped to the bar's range
+    SDL_Rect absolute;
+    render_get_absolute_bounds(bar,&absolute);
+    int maximum = __atomic_load_n(&progressbar->maximum,__ATOMIC_RELAXED);
+    int width = max(bar->bounds.w - 1,1);
+    int x = min(max(event->x - (absolute.x + 1),0),width);
+    progressbar->seekValue = (int) ( (long) x * maximum / width );
+    
+    if ( event->type == TOUCH_STOP ) 
+    {
+      log_info("ui_handle_touch_event_progressbar(): Seek progress bar %d to %d",bar->elementId,progressbar->seekValue);
+      __atomic_store_n(&progressbar->value,progressbar->seekValue,__ATOMIC_RELAXED);
+      progressbar->seeking = 0;
+      callbackToInvoke = progressbar->seekCallback;
+      focusedElement = NULL;
+    }
+  }
+  
+  pthread_mutex_unlock(&ui_mutex);
+  
+  if ( callbackToInvoke != NULL ) 
+  {
+    long traceStart = trace_begin();
+    callbackToInvoke(bar->elementId,progressbar->seekValue);
+    trace_end("user","progressbar_seek_handler",traceStart,bar->elementId);
+  }
+  return focusedElement;
+}
+
 void ui_handle_touch_event(TouchEvent *event) 
 {
   log_info("ui_handle_touch_event(): Called");
@@ -419,6 +858,10 @@ void ui_handle_touch_event(TouchEvent *event)
         // Function UNLOCKS mutex
         focusedElement = ui_handle_touch_event_listview(element, event);
         return;        
+      case UI_PROGRESSBAR:
+        // Function UNLOCKS mutex
+        focusedElement = ui_handle_touch_event_progressbar(element, event);
+        return;
       default:
         log_error("ui_handle_touch_event(): Unhandled element type %d",type);
     }
@@ -3,11 +3,16 @@
 
 #include "SDL/SDL.h"
 #include "ui_types.h"
+#include "animation.h"
+#include "layout.h"
 
 #define LISTVIEW_CLICK_MAXDELTA_Y 3
 
 #define LISTVIEW_ITEM_HEIGHT 20
 
+// number of items a list view shows if its height is less than one item
+#define LISTVIEW_DEFAULT_VISIBLE_ITEMS 5
+
 /**
  * Adds a new button that displays a text label.
  * @param text button text
@@ -27,8 +32,18 @@ int ui_add_button(char *text,SDL_Rect *bounds,ButtonHandler clickHandler);
 int ui_add_image_button(char *image,SDL_Rect *bounds,ButtonHandler clickHandler);
 
 /**
- * Adds a new button.
- * @param bounds the button's bounds
+ * Replaces the text of a button. Inside a layout container,
+ * the container gets laid out again if the button's size changes.
+ * 
+ * @param buttonId button ID
+ * @param text new text
+ * @return 0 on error, otherwise success
+ */
+int ui_set_button_text(int buttonId,const char *text);
+
+/**
+ * Adds a new list view. The height is rounded down to whole items.
+ * @param bounds the list view's bounds
  * @param labelProvider callback that gets invoked to retrieve the label for a given item
  * @param itemCountProvider callback that gets invoked to determine the number of items that are available
  * @param clickCallback callback that gets invoked when the user clicks on an item
@@ -37,6 +52,274 @@ int ui_add_image_button(char *image,SDL_Rect *bounds,ButtonHandler clickHandler)
  */
 int ui_add_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListViewItemCountProvider itemCountProvider, ListViewClickCallback clickCallback);
 
+/**
+ * Adds a progress/seek bar.
+ * @param bounds the progress bar's bounds
+ * @param maximum value at which the bar is completely filled
+ * @param seekCallback callback that gets invoked when the user dragged the bar to a new value or NULL
+ * @return the progress bar's ID (always >0) if everything worked ok, otherwise 0
+ */
+int ui_add_progressbar(SDL_Rect *bounds,int maximum,ProgressBarSeekCallback seekCallback);
+
+/**
+ * Updates the value of a progress bar. Does not wait for the rendering thread,
+ * only the pixel columns that changed get repainted at the end of the next frame.
+ * While the user drags the bar, the value is stored but not displayed.
+ * 
+ * @param progressBarId progress bar ID
+ * @param value new value
+ * @return 0 on error, otherwise success
+ */
+int ui_progressbar_set_value(int progressBarId,int value);
+
+/**
+ * Updates the value at which a progress bar is completely filled.
+ * Does not wait for the rendering thread.
+ * 
+ * @param progressBarId progress bar ID
+ * @param maximum
+ * @return 0 on error, otherwise success
+ */
+int ui_progressbar_set_maximum(int progressBarId,int maximum);
+
+/**
+ * Adds a container (panel, page, ...). Children are positioned relative 
+ * to the container and clipped to its bounds.
+ * 
+ * @param bounds the container's bounds
+ * @param background background color or NULL for a transparent container
+ * @return the container's ID (always >0) if everything worked ok, otherwise 0
+ */
+int ui_add_container(SDL_Rect *bounds,SDL_Color *background);
+
+/**
+ * Adds a page, a full-screen container that is pre-rendered off-screen while it is
+ * not active, so switching to it does not need to paint its elements.
+ * Elements get added to a page with ui_begin_container(). The first page added
+ * becomes the active page, all others are hidden until they get pushed or shown.
+ * 
+ * @param background background color or NULL for black
+ * @return the page's ID (always >0) if everything worked ok, otherwise 0
+ */
+int ui_add_page(SDL_Color *background);
+
+/**
+ * Makes a page the active page, the current page can be returned to with ui_pop_page().
+ * 
+ * @param pageId page ID
+ * @param transition
+ * @param durationMicros duration of the transition
+ * @return 0 on error, otherwise success
+ */
+int ui_push_page(int pageId,PageTransition transition,long durationMicros);
+
+/**
+ * Returns to the page that was active before the last ui_push_page() call.
+ * 
+ * @param transition
+ * @param durationMicros duration of the transition
+ * @return 0 if there is no page to return to, otherwise success
+ */
+int ui_pop_page(PageTransition transition,long durationMicros);
+
+/**
+ * Replaces the active page by another page.
+ * 
+ * @param pageId page ID
+ * @param transition
+ * @param durationMicros duration of the transition
+ * @return 0 on error, otherwise success
+ */
+int ui_show_page(int pageId,PageTransition transition,long durationMicros);
+
+/**
+ * Returns the ID of the active page.
+ * @return page ID or 0 if no page has been added
+ */
+int ui_get_active_page(void);
+
+/**
+ * Makes all elements added until the matching ui_end_container() call
+ * children of the given container. Calls may be nested.
+ * 
+ * @param containerId container ID
+ * @return 0 on error, otherwise success
+ */
+int ui_begin_container(int containerId);
+
+/**
+ * Ends adding elements to the container passed to the last ui_begin_container() call.
+ */
+void ui_end_container(void);
+
+/**
+ * Makes a container position its children as a row, a column or a grid, see layout.h.
+ * The children are laid out at the end of the frame and whenever their size changes.
+ * 
+ * @param containerId container ID
+ * @param type layout type, LAYOUT_NONE keeps the children where they are
+ * @param padding space between the container's edges and its children
+ * @param spacing space between adjacent children
+ * @param columns number of columns (grids only)
+ * @return 0 on error, otherwise success
+ */
+int ui_set_layout(int containerId,LayoutType type,int padding,int spacing,int columns);
+
+/**
+ * Changes the size an element requests from its layout container. By default
+ * elements request the width and height they were added with.
+ * 
+ * @param elementId element ID
+ * @param width LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels
+ * @param height LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels
+ * @param weight share of the space left along the layout direction, 0 for none
+ * @return 0 on error, otherwise success
+ */
+int ui_set_layout_size(int elementId,int width,int height,int weight);
+
+/**
+ * Changes the z-order of an element. Elements with a higher z-order are drawn on top of 
+ * siblings (elements in the same container) with a lower z-order, siblings with the 
+ * same z-order are drawn in the order they were added. The default z-order is 0.
+ * 
+ * @param elementId element ID
+ * @param zOrder
+ * @return 0 on error, otherwise success
+ */
+int ui_set_z_order(int elementId,int zOrder);
+
+/**
+ * Animates a property of an element from its current value to a target value. 
+ * Starting a new animation of a property replaces the one currently running.
+ * 
+ * @param elementId element ID
+ * @param property property (ANIM_PROPERTY_xxx)
+ * @param to target value
+ * @param durationMicros duration
+ * @param easing easing function (EASE_xxx)
+ * @return 0 on error, otherwise the animation's ID (always >0)
+ */
+int ui_animate(int elementId,AnimProperty property,long to,long durationMicros,EasingFunction easing);
+
+/**
+ * Stops an animation, the animated property keeps its current value.
+ * 
+ * @param animationId animation ID
+ * @return 0 if the animation is not running, otherwise success
+ */
+int ui_cancel_animation(int animationId);
+
+/**
+ * Repaints an element along with its children at the end of the current frame.
+ * 
+ * @param elementId element ID
+ * @return 0 on error, otherwise success
+ */
+int ui_invalidate(int elementId);
+
+/**
+ * Discards the cached label of a list view item and redraws the list view.
+ * The label provider will be asked for the label again the next time the item becomes visible.
+ * 
+ * @param listViewId list view ID
+ * @param itemIndex index of item to invalidate
+ * @return 0 on error, otherwise success
+ */
+int ui_listview_invalidate_item(int listViewId,int itemIndex);
+
+/**
+ * Discards the cached labels of a range of list view items and redraws the list view.
+ * 
+ * @param listViewId list view ID
+ * @param firstIndex index of first item to invalidate
+ * @param count number of items to invalidate
+ * @return 0 on error, otherwise success
+ */
+int ui_listview_invalidate_range(int listViewId,int firstIndex,int count);
+
+/**
+ * Discards all cached labels and the cached item count of a list view and redraws it.
+ * 
+ * @param listViewId list view ID
+ * @return 0 on error, otherwise success
+ */
+int ui_listview_invalidate_all(int listViewId);
+
+/**
+ * Updates the number of items of a list view without invoking its item count provider and redraws it.
+ * Cached labels of items beyond the new count are discarded.
+ * 
+ * @param listViewId list view ID
+ * @param itemCount new item count
+ * @return 0 on error, otherwise success
+ */
+int ui_listview_set_item_count(int listViewId,int itemCount);
+
+/**
+ * Finds the UI element at the given coordinates.
+ * 
+ * @param x
+ * @param y
+ * @return UI element or NULL
+ */
+ui_element *ui_find_element(int x,int y);
+
+/**
+ * Finds the UI element with the given ID.
+ * 
+ * @param elementId
+ * @return UI element or NULL
+ */
+ui_element *ui_find_element_by_id(int elementId);
+
+/**
+ * Allocates a button without adding it to the UI, see ui_add_button().
+ * The button must be attached with render_attach_element() and registered with ui_add_element().
+ * 
+ * @param text button text or NULL for an image button
+ * @param bounds the button's bounds
+ * @param clickHandler Invoked when the button is clicked
+ * @return button or NULL on error
+ */
+ui_element *ui_create_button(const char *text,SDL_Rect *bounds,ButtonHandler clickHandler);
+
+/**
+ * Allocates a list view without adding it to the UI, see ui_add_listview().
+ * @return list view or NULL on error
+ */
+ui_element *ui_create_listview(SDL_Rect *bounds,ListViewLabelProvider labelProvider, ListViewItemCountProvider itemCountProvider, ListViewClickCallback clickCallback);
+
+/**
+ * Allocates a progress bar without adding it to the UI, see ui_add_progressbar().
+ * @return progress bar or NULL on error
+ */
+ui_element *ui_create_progressbar(SDL_Rect *bounds,int maximum,ProgressBarSeekCallback seekCallback);
+
+/**
+ * Allocates a container without adding it to the UI, see ui_add_container().
+ * @return container or NULL on error
+ */
+ui_element *ui_create_container(SDL_Rect *bounds,SDL_Color *background);
+
+/**
+ * Registers a UI element so it can be found by its ID.
+ * @param entry element
+ * @return the element's ID (always >0)
+ */
+int ui_add_element(ui_element *entry);
+
+/**
+ * Unregisters and frees all UI elements.
+ */
+void ui_free_all(void);
+
+/**
+ * Unregisters a UI element without freeing it.
+ * @param entry element
+ * @return 0 if the element was not registered, otherwise success
+ */
+int ui_unregister_element(ui_element *entry);
+
 int ui_run_test(void);
 
 int ui_init(void);
@@ -2,6 +2,7 @@
 #define UI_TYPES_H
 
 #include "dynamicstring.h"
+#include "labelcache.h"
 #include "SDL/SDL.h"
 
 // parameter is the button ID of the clicked button
@@ -20,17 +21,58 @@ typedef int (*ListViewItemCountProvider)(int);
 // void callback(listview_id,item id)
 typedef void (*ListViewClickCallback)(int,int);
 
+// invoked when the user finished dragging a progress bar to a new position
+// void callback(progressbar_id,new value)
+typedef void (*ProgressBarSeekCallback)(int,int);
+
 // void callback(textfield_id,entered string)
 typedef void (*TextFieldCallback)(int,const char *);
 
-typedef enum { UI_BUTTON, UI_LISTVIEW, UI_TEXTFIELD } UIElementType;
+typedef enum { UI_BUTTON, UI_LISTVIEW, UI_TEXTFIELD, UI_CONTAINER, UI_PROGRESSBAR } UIElementType;
+
+// how a container positions its children, see layout.h
+typedef enum { LAYOUT_NONE=0, LAYOUT_ROW=1, LAYOUT_COLUMN=2, LAYOUT_GRID=3 } LayoutType;
+
+// animation when switching pages, SLIDE_LEFT moves the current page out to the left
+typedef enum {
+  PAGE_TRANSITION_NONE=0,
+  PAGE_TRANSITION_SLIDE_LEFT=1,
+  PAGE_TRANSITION_SLIDE_RIGHT=2,
+  PAGE_TRANSITION_SLIDE_UP=3,
+  PAGE_TRANSITION_SLIDE_DOWN=4
+} PageTransition;
+
+// requested sizes of elements inside a layout container, other values are a fixed size in pixels
+#define LAYOUT_WRAP_CONTENT 0 // as large as the content
+#define LAYOUT_FILL -1 // as large as the container across the layout direction
+
+/*
+ * Layout state of an element, only accessed from the rendering thread.
+ */
+typedef struct layout_node
+{
+  int width; // requested width (LAYOUT_WRAP_CONTENT, LAYOUT_FILL or pixels)
+  int height; // requested height
+  int weight; // share of the space left along the layout direction, 0 for none
+  int measuredWidth; // cached result of the measure pass
+  int measuredHeight;
+  int flags; // LAYOUT_FLAG_xxx
+} layout_node;
 
 /*
  * Attributes common to all UI elements.
+ *
+ * Elements form a tree (the scene graph), top-level elements are children
+ * of the screen. The tree is only modified by the rendering thread and
+ * an element's parent never changes once it has been attached.
  */
 typedef struct ui_element 
 {
   struct ui_element *next;
+  struct ui_element *parent; // NULL while the element is not attached to the scene graph
+  struct ui_element *firstChild; // only accessed by the rendering thread
+  struct ui_element *nextSibling; // only accessed by the rendering thread
+  int zOrder; // higher values are painted on top of siblings with lower values
   UIElementType type;
   int elementId;
   union {
@@ -38,11 +80,16 @@ typedef struct ui_element
     struct listview_entry *listview;
     struct button_entry *button;
     struct textfield_entry *textfield;
+    struct container_entry *container;
+    struct progressbar_entry *progressbar;
   };
-  SDL_Rect bounds;    
+  SDL_Rect bounds; // relative to the parent element
+
   SDL_Color borderColor;
   SDL_Color backgroundColor;
   SDL_Color foregroundColor;  
+  
+  layout_node layout;
 } ui_element;
 
 
@@ -56,6 +103,8 @@ typedef struct listview_entry
   ListViewClickCallback clickCallback;
   int visibleItemCount;
   int yStartOffset;  
+  label_cache *labelCache; // only accessed from the rendering thread
+  SDL_Surface *surface; // off-screen surface items are rendered to
 } listview_entry;
 
 /*
@@ -71,9 +120,42 @@ typedef struct button_entry
   int fontSize;
   int pressed;
   char *text;
-  SDL_Surface *image;
+  SDL_Surface *image; // owned by imageEntry for image buttons
+  SDL_Rect imageRect; // part of 'image' to draw
+  struct image_cache_entry *imageEntry; // only accessed from the rendering thread
 } button_entry;
 
+/*
+ * A container (panel, page, ...) that clips its children.
+ * Children are painted in the order they were added, so later children appear on top.
+ */
+typedef struct container_entry
+{
+  int transparent; // if set, the background color is not painted
+  // children are positioned by the layout engine unless the layout is LAYOUT_NONE
+  LayoutType layout;
+  int padding; // space between the container's edges and its children
+  int spacing; // space between adjacent children
+  int columns; // number of columns of a LAYOUT_GRID
+  struct page_entry *page; // set if the container is a page (see render_add_page())
+} container_entry;
+
+/*
+ * A progress/seek bar. 
+ * 
+ * Value changes only repaint the pixel columns between the old and the new end of the fill.
+ */
+typedef struct progressbar_entry
+{
+  ProgressBarSeekCallback seekCallback; // NULL if the bar does not react to touch input
+  int value; // may be written by any thread
+  int maximum; // may be written by any thread
+  int seeking; // set while the user drags the bar, only accessed from the rendering thread
+  int seekValue; // value displayed while seeking
+  int drawnFill; // width of the fill in pixels as it is painted, only accessed from the rendering thread
+  struct ui_element *nextProgressBar; // list of attached progress bars, only accessed from the rendering thread
+} progressbar_entry;
+
 /*
  * A text field.
  */
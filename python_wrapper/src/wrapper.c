@@ -1,5 +1,8 @@
+#define LOG_MODULE LOG_MODULE_PYTHON
+
 #include <Python.h>
 #include "mylib.h"
+#include "log.h"
 #include <stdlib.h>
 
 typedef struct callback_entry 
@@ -11,18 +14,38 @@ typedef struct callback_entry
 
 static callback_entry *handlers = NULL;
 
-static void call_python2(PyObject *buttonCallback,int buttonId) 
+typedef struct screen_entry 
+{
+  struct screen_entry *next;
+  int screenId;
+  screen_definition *screen;
+  PyObject *callbacks; // dict mapping callback names to functions
+} screen_entry;
+
+static screen_entry *screens = NULL;
+
+static int uniqueScreenId = 1;
+
+// callbacks of the screen currently shown
+static PyObject *shownScreenCallbacks = NULL;
+
+// 'format' describes the callback arguments, e.g. "(i)" or "(ii)"
+static void call_python2(PyObject *buttonCallback,const char *format,int buttonId,int value) 
 {
-  PyObject *arglist = Py_BuildValue("(i)", buttonId); // need to use '(i)' and not just 'i' as PyEval_CallObject() requires a tuple
+  PyObject *arglist = Py_BuildValue(format, buttonId, value); // need to use '(i)' and not just 'i' as PyEval_CallObject() requires a tuple
   PyObject *result = PyEval_CallObject(buttonCallback, arglist);      
   Py_DECREF(arglist);
   if ( result != NULL ) {
     Py_DECREF(result);
-  }    
+  } else {
+    // nobody up the stack would see the exception, the UI thread called us
+    log_error("Callback for element %d raised an exception",buttonId);
+    PyErr_Print();
+  }
 }
 
 // aquires the GIL if necessary and then proceeds to invoke the actual callback
-static void call_python(PyObject *buttonCallback,int buttonId) 
+static void call_python_with_args(PyObject *buttonCallback,const char *format,int buttonId,int value) 
 {
 
   PyThreadState * currentThread = _PyThreadState_Current;
@@ -30,16 +53,21 @@ static void call_python(PyObject *buttonCallback,int buttonId)
   {
     PyGILState_STATE gstate = PyGILState_Ensure();
     
-    call_python2(buttonCallback,buttonId);
+    call_python2(buttonCallback,format,buttonId,value);
     
     PyGILState_Release(gstate);
   }
   else
   {
-    call_python2(buttonCallback,buttonId);
+    call_python2(buttonCallback,format,buttonId,value);
   }
 }
 
+static void call_python(PyObject *buttonCallback,int buttonId) 
+{
+  call_python_with_args(buttonCallback,"(i)",buttonId,0);
+}
+
 static void myui_clickHandler(int buttonId) {
   
   callback_entry *current=handlers;
@@ -48,10 +76,89 @@ static void myui_clickHandler(int buttonId) {
     if ( current->buttonId == buttonId ) 
     {
       call_python(current->clickHandler,buttonId);
-      break;
+      return;
+    }
+    current = current->next;
+  }
+  log_warn("No click handler registered for element %d",buttonId);
+}
+
+static void myui_seekHandler(int progressBarId,int value) {
+  
+  callback_entry *current=handlers;
+  while( current ) 
+  {
+    if ( current->buttonId == progressBarId ) 
+    {
+      call_python_with_args(current->clickHandler,"(ii)",progressBarId,value);
+      return;
     }
     current = current->next;
   }
+  log_warn("No seek handler registered for element %d",progressBarId);
+}
+
+// looks up the function a screen element's callback is bound to and invokes it, aquiring the GIL if necessary
+static void call_screen_callback(int type,const char *format,int elementId,int value) 
+{
+  const char *name = mylib_get_screen_callback_name(elementId,type);
+  if ( name == NULL ) {
+    return;
+  }
+  PyThreadState * currentThread = _PyThreadState_Current;
+  int aquireGIL = PyGILState_GetThisThreadState() || !currentThread;
+  PyGILState_STATE gstate;
+  if ( aquireGIL ) {
+    gstate = PyGILState_Ensure();
+  }
+  PyObject *callback = shownScreenCallbacks ? PyDict_GetItemString(shownScreenCallbacks,name) : NULL;
+  if ( callback ) {
+    call_python2(callback,format,elementId,value);
+  } else {
+    log_warn("Screen callback '%s' of element %d is not bound to a function",name,elementId);
+  }
+  if ( aquireGIL ) {
+    PyGILState_Release(gstate);
+  }
+}
+
+static void myui_screenClickHandler(int buttonId) {
+  call_screen_callback(SCREEN_CALLBACK_CLICK,"(i)",buttonId,0);
+}
+
+static void myui_screenSeekHandler(int progressBarId,int value) {
+  call_screen_callback(SCREEN_CALLBACK_SEEK,"(ii)",progressBarId,value);
+}
+
+// resolves the callback names of a screen file against the dict passed to load_screen()
+static void *myui_resolve_screen_callback(const char *name,ScreenCallbackType type,void *data) 
+{
+  PyObject *callback = PyDict_GetItemString((PyObject*) data,name);
+  if ( callback == NULL || ! PyCallable_Check(callback) ) {
+    return NULL;
+  }
+  switch( type ) 
+  {
+    case SCREEN_CALLBACK_CLICK:
+      return myui_screenClickHandler;
+    case SCREEN_CALLBACK_SEEK:
+      return myui_screenSeekHandler;
+    default:
+      // list views are not supported by the Python API
+      return NULL;
+  }
+}
+
+static screen_entry *myui_find_screen(int screenId) 
+{
+  screen_entry *current = screens;
+  while ( current && current->screenId != screenId ) {
+    current = current->next;
+  }
+  if ( current == NULL ) {
+    PyErr_SetString(PyExc_ValueError, "No such screen");
+  }
+  return current;
 }
 
 static void myui_free_callback_entry(callback_entry *entry) 
@@ -93,6 +200,15 @@ static PyObject *myui_init(PyObject *self, PyObject *args)
 
 static PyObject *myui_close(PyObject *self, PyObject *args) 
 {
+    while ( screens ) 
+    {
+      screen_entry *next = screens->next;
+      mylib_free_screen(screens->screen);
+      Py_DECREF(screens->callbacks);
+      free(screens);
+      screens = next;
+    }
+    shownScreenCallbacks = NULL;
     mylib_close();
     
     callback_entry *current=handlers;
@@ -165,12 +281,594 @@ static PyObject *myui_add_image_button(PyObject *self, PyObject *args)
     return PyInt_FromLong(0);   
 }
 
+static PyObject *myui_add_progressbar(PyObject *self, PyObject *args)
+{
+    int x;
+    int y;
+    int width;
+    int height;
+    int maximum;
+    PyObject *callback = NULL;
+    
+    if (!PyArg_ParseTuple(args, "iiiii|O", &x, &y, &width, &height, &maximum, &callback)) {      
+        return NULL;
+    }
+    if ( callback != NULL && callback != Py_None && !PyCallable_Check(callback) ) {
+        PyErr_SetString(PyExc_TypeError, "Seek callback must be callable");
+        return NULL;
+    }
+    int seekable = callback != NULL && callback != Py_None;
+    int progressBarId = mylib_add_progressbar(x, y, width, height, maximum, seekable ? myui_seekHandler : NULL);
+    if ( progressBarId > 0 && seekable ) {
+        myui_add_button_handler(progressBarId,callback);
+    }
+    return PyInt_FromLong(progressBarId);
+}
+
+static PyObject *myui_progressbar_set_value(PyObject *self, PyObject *args)
+{
+    int progressBarId;
+    int value;
+    
+    if (!PyArg_ParseTuple(args, "ii", &progressBarId, &value)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_progressbar_set_value(progressBarId, value) );
+}
+
+static PyObject *myui_progressbar_set_maximum(PyObject *self, PyObject *args)
+{
+    int progressBarId;
+    int maximum;
+    
+    if (!PyArg_ParseTuple(args, "ii", &progressBarId, &maximum)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_progressbar_set_maximum(progressBarId, maximum) );
+}
+
+static PyObject *myui_set_log_level(PyObject *self, PyObject *args)
+{
+    int module;
+    int level;
+    
+    if (!PyArg_ParseTuple(args, "ii", &module,&level)) {      
+        return NULL;
+    }
+    if ( ! mylib_set_log_level(module,level) ) {
+        PyErr_SetString(PyExc_ValueError, "Invalid log module or level");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_get_log_level(PyObject *self, PyObject *args)
+{
+    int module;
+    
+    if (!PyArg_ParseTuple(args, "i", &module)) {      
+        return NULL;
+    }
+    int level = mylib_get_log_level(module);
+    if ( level < 0 ) {
+        PyErr_SetString(PyExc_ValueError, "Invalid log module");
+        return NULL;
+    }
+    return PyInt_FromLong(level);
+}
+
+static PyObject *myui_histogram_to_list(unsigned long *histogram)
+{
+    PyObject *list = PyList_New(MBOXSTATS_BUCKETS);
+    if ( list == NULL ) {
+        return NULL;
+    }
+    for ( int i = 0 ; i < MBOXSTATS_BUCKETS ; i++ ) {
+        PyList_SET_ITEM(list, i, PyLong_FromUnsignedLong(histogram[i]));
+    }
+    return list;
+}
+
+static PyObject *myui_get_mailbox_stats(PyObject *self, PyObject *args)
+{
+    mbox_stats stats;
+    mylib_get_mailbox_stats(&stats);
+    
+    PyObject *limits = PyList_New(MBOXSTATS_BUCKETS);
+    PyObject *callbacks = PyList_New(0);
+    if ( limits == NULL || callbacks == NULL ) {
+        Py_XDECREF(limits);
+        Py_XDECREF(callbacks);
+        return NULL;
+    }
+    for ( int i = 0 ; i < MBOXSTATS_BUCKETS ; i++ ) {
+        PyList_SET_ITEM(limits, i, PyInt_FromLong(mboxstats_bucket_limit(i)));
+    }
+    
+    for ( int i = 0 ; i < stats.callbackCount ; i++ ) 
+    {
+        mbox_callback_stats *cb = &stats.callbacks[i];
+        char address[32];
+        snprintf(address,sizeof(address),"%p",cb->func);
+        
+        PyObject *waitHistogram = myui_histogram_to_list(cb->waitHistogram);
+        PyObject *execHistogram = myui_histogram_to_list(cb->execHistogram);
+        PyObject *entry = Py_BuildValue("{s:s,s:k,s:k,s:l,s:l,s:l,s:l,s:N,s:N}",
+                                        "name", cb->name ? cb->name : address,
+                                        "count", cb->count,
+                                        "slow_count", cb->slowCount,
+                                        "total_wait_us", cb->totalWaitMicros,
+                                        "max_wait_us", cb->maxWaitMicros,
+                                        "total_exec_us", cb->totalExecMicros,
+                                        "max_exec_us", cb->maxExecMicros,
+                                        "wait_histogram", waitHistogram,
+                                        "exec_histogram", execHistogram);
+        if ( entry == NULL ) {
+            Py_DECREF(limits);
+            Py_DECREF(callbacks);
+            return NULL;
+        }
+        PyList_Append(callbacks, entry);
+        Py_DECREF(entry);
+    }
+    
+    return Py_BuildValue("{s:i,s:k,s:k,s:l,s:N,s:N}",
+                         "high_water_mark", stats.highWaterMark,
+                         "processed", stats.processed,
+                         "untracked", stats.untracked,
+                         "slow_threshold_us", stats.slowThresholdMicros,
+                         "bucket_limits_us", limits,
+                         "callbacks", callbacks);
+}
+
+static PyObject *myui_reset_mailbox_stats(PyObject *self, PyObject *args)
+{
+    mylib_reset_mailbox_stats();
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_set_slow_callback_threshold(PyObject *self, PyObject *args)
+{
+    long micros;
+    
+    if (!PyArg_ParseTuple(args, "l", &micros)) {      
+        return NULL;
+    }
+    mylib_set_slow_callback_threshold(micros);
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_get_memory_usage(PyObject *self, PyObject *args)
+{
+    mem_usage usage;
+    mylib_get_memory_usage(&usage);
+    
+    PyObject *result = PyDict_New();
+    if ( result == NULL ) {
+        return NULL;
+    }
+    for ( int i = 0 ; i < MEM_CATEGORY_COUNT ; i++ ) 
+    {
+        PyObject *entry = Py_BuildValue("{s:l,s:l,s:l,s:k}",
+                                        "current", usage.currentBytes[i],
+                                        "peak", usage.peakBytes[i],
+                                        "budget", usage.budgetBytes[i],
+                                        "evictions", usage.evictions[i]);
+        if ( entry == NULL || PyDict_SetItemString(result, memstats_get_category_name(i), entry) < 0 ) {
+            Py_XDECREF(entry);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(entry);
+    }
+    return result;
+}
+
+static PyObject *myui_set_memory_budget(PyObject *self, PyObject *args)
+{
+    int category;
+    long bytes;
+    
+    if (!PyArg_ParseTuple(args, "il", &category, &bytes)) {      
+        return NULL;
+    }
+    if ( ! mylib_set_memory_budget(category,bytes) ) {
+        PyErr_SetString(PyExc_ValueError, "Invalid memory category or budget");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_get_image_cache_stats(PyObject *self, PyObject *args)
+{
+    image_cache_stats stats;
+    mylib_get_image_cache_stats(&stats);
+    
+    return Py_BuildValue("{s:k,s:k,s:k,s:i,s:l,s:i}",
+                         "hits", stats.hits,
+                         "misses", stats.misses,
+                         "evictions", stats.evictions,
+                         "entries", stats.entryCount,
+                         "bytes", stats.bytes,
+                         "atlas_entries", stats.atlasEntryCount);
+}
+
+static PyObject *myui_start_trace(PyObject *self, PyObject *args)
+{
+    const char *path;
+    
+    if (!PyArg_ParseTuple(args, "s", &path)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_start_trace(path) );
+}
+
+static PyObject *myui_flush_trace(PyObject *self, PyObject *args)
+{
+    mylib_flush_trace();
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_stop_trace(PyObject *self, PyObject *args)
+{
+    mylib_stop_trace();
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_set_display_backend(PyObject *self, PyObject *args)
+{
+    int type;
+    
+    if (!PyArg_ParseTuple(args, "i", &type)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_display_backend(type) );
+}
+
+static PyObject *myui_load_screen(PyObject *self, PyObject *args)
+{
+    const char *path;
+    PyObject *callbacks;
+    
+    if (!PyArg_ParseTuple(args, "sO!", &path, &PyDict_Type, &callbacks)) {      
+        return NULL;
+    }
+    screen_entry *entry = malloc(sizeof(screen_entry));
+    if ( ! entry ) {
+        return PyErr_NoMemory();
+    }
+    entry->screen = mylib_load_screen(path,myui_resolve_screen_callback,callbacks);
+    if ( entry->screen == NULL ) {
+        free(entry);
+        return PyInt_FromLong(0);
+    }
+    Py_INCREF(callbacks);
+    entry->callbacks = callbacks;
+    entry->screenId = uniqueScreenId++;
+    entry->next = screens;
+    screens = entry;
+    return PyInt_FromLong(entry->screenId);
+}
+
+static PyObject *myui_show_screen(PyObject *self, PyObject *args)
+{
+    int screenId;
+    
+    if (!PyArg_ParseTuple(args, "i", &screenId)) {      
+        return NULL;
+    }
+    screen_entry *entry = myui_find_screen(screenId);
+    if ( entry == NULL ) {
+        return NULL;
+    }
+    int result = mylib_show_screen(entry->screen);
+    if ( result ) {
+        shownScreenCallbacks = entry->callbacks;
+    }
+    return PyInt_FromLong(result);
+}
+
+static PyObject *myui_find_screen_element(PyObject *self, PyObject *args)
+{
+    int screenId;
+    const char *name;
+    
+    if (!PyArg_ParseTuple(args, "is", &screenId, &name)) {      
+        return NULL;
+    }
+    screen_entry *entry = myui_find_screen(screenId);
+    if ( entry == NULL ) {
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_find_screen_element(entry->screen,name) );
+}
+
+static PyObject *myui_free_screen(PyObject *self, PyObject *args)
+{
+    int screenId;
+    
+    if (!PyArg_ParseTuple(args, "i", &screenId)) {      
+        return NULL;
+    }
+    screen_entry **current = &screens;
+    while ( *current && (*current)->screenId != screenId ) {
+        current = &(*current)->next;
+    }
+    if ( *current == NULL ) {
+        PyErr_SetString(PyExc_ValueError, "No such screen");
+        return NULL;
+    }
+    screen_entry *entry = *current;
+    *current = entry->next;
+    mylib_free_screen(entry->screen);
+    if ( shownScreenCallbacks == entry->callbacks ) {
+        shownScreenCallbacks = NULL;
+    }
+    Py_DECREF(entry->callbacks);
+    free(entry);
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_set_asset_bundle(PyObject *self, PyObject *args)
+{
+    const char *path;
+    
+    if (!PyArg_ParseTuple(args, "s", &path)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_asset_bundle(path) );
+}
+
+static PyObject *myui_set_render_workers(PyObject *self, PyObject *args)
+{
+    int count;
+    
+    if (!PyArg_ParseTuple(args, "i", &count)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_render_workers(count) );
+}
+
+static PyObject *myui_capture_frame(PyObject *self, PyObject *args)
+{
+    SDL_Surface *frame = mylib_capture_frame();
+    if ( frame == NULL ) {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to capture frame");
+        return NULL;
+    }
+    
+    // strip row padding
+    int rowSize = frame->w * 4;
+    PyObject *pixels = PyString_FromStringAndSize(NULL, rowSize * frame->h);
+    if ( pixels != NULL ) 
+    {
+        char *dst = PyString_AS_STRING(pixels);
+        for ( int y = 0 ; y < frame->h ; y++ ) {
+            memcpy(dst + y * rowSize, ((char*) frame->pixels) + y * frame->pitch, rowSize);
+        }
+    }
+    int width = frame->w;
+    int height = frame->h;
+    SDL_FreeSurface(frame);
+    
+    if ( pixels == NULL ) {
+        return NULL;
+    }
+    return Py_BuildValue("(iiN)", width, height, pixels);
+}
+
+static PyObject *myui_add_container(PyObject *self, PyObject *args)
+{
+    int x;
+    int y;
+    int width;
+    int height;
+    int r = -1;
+    int g = 0;
+    int b = 0;
+    
+    if (!PyArg_ParseTuple(args, "iiii|(iii)", &x, &y, &width, &height, &r, &g, &b)) {      
+        return NULL;
+    }
+    SDL_Color background = { r, g, b };
+    return PyInt_FromLong( mylib_add_container(x, y, width, height, r < 0 ? NULL : &background) );
+}
+
+static PyObject *myui_begin_container(PyObject *self, PyObject *args)
+{
+    int containerId;
+    
+    if (!PyArg_ParseTuple(args, "i", &containerId)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_begin_container(containerId) );
+}
+
+static PyObject *myui_end_container(PyObject *self, PyObject *args)
+{
+    mylib_end_container();
+    Py_RETURN_NONE;
+}
+
+static PyObject *myui_add_page(PyObject *self, PyObject *args)
+{
+    int r = -1;
+    int g = 0;
+    int b = 0;
+    
+    if (!PyArg_ParseTuple(args, "|(iii)", &r, &g, &b)) {      
+        return NULL;
+    }
+    SDL_Color background = { r, g, b };
+    return PyInt_FromLong( mylib_add_page(r < 0 ? NULL : &background) );
+}
+
+static PyObject *myui_push_page(PyObject *self, PyObject *args)
+{
+    int pageId;
+    int transition = PAGE_TRANSITION_NONE;
+    int duration = 0;
+    
+    if (!PyArg_ParseTuple(args, "i|ii", &pageId, &transition, &duration)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_push_page(pageId, transition, duration) );
+}
+
+static PyObject *myui_pop_page(PyObject *self, PyObject *args)
+{
+    int transition = PAGE_TRANSITION_NONE;
+    int duration = 0;
+    
+    if (!PyArg_ParseTuple(args, "|ii", &transition, &duration)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_pop_page(transition, duration) );
+}
+
+static PyObject *myui_show_page(PyObject *self, PyObject *args)
+{
+    int pageId;
+    int transition = PAGE_TRANSITION_NONE;
+    int duration = 0;
+    
+    if (!PyArg_ParseTuple(args, "i|ii", &pageId, &transition, &duration)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_show_page(pageId, transition, duration) );
+}
+
+static PyObject *myui_get_active_page(PyObject *self, PyObject *args)
+{
+    return PyInt_FromLong( mylib_get_active_page() );
+}
+
+static PyObject *myui_set_z_order(PyObject *self, PyObject *args)
+{
+    int elementId;
+    int zOrder;
+    
+    if (!PyArg_ParseTuple(args, "ii", &elementId, &zOrder)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_z_order(elementId, zOrder) );
+}
+
+static PyObject *myui_set_layout(PyObject *self, PyObject *args)
+{
+    int containerId;
+    int type;
+    int padding = 0;
+    int spacing = 0;
+    int columns = 1;
+    
+    if (!PyArg_ParseTuple(args, "ii|iii", &containerId, &type, &padding, &spacing, &columns)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_layout(containerId, type, padding, spacing, columns) );
+}
+
+static PyObject *myui_set_layout_size(PyObject *self, PyObject *args)
+{
+    int elementId;
+    int width;
+    int height;
+    int weight = 0;
+    
+    if (!PyArg_ParseTuple(args, "iii|i", &elementId, &width, &height, &weight)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_layout_size(elementId, width, height, weight) );
+}
+
+static PyObject *myui_set_button_text(PyObject *self, PyObject *args)
+{
+    int buttonId;
+    char *text;
+    
+    if (!PyArg_ParseTuple(args, "is", &buttonId, &text)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_set_button_text(buttonId, text) );
+}
+
+static PyObject *myui_invalidate(PyObject *self, PyObject *args)
+{
+    int elementId;
+    
+    if (!PyArg_ParseTuple(args, "i", &elementId)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_invalidate(elementId) );
+}
+
+static PyObject *myui_animate(PyObject *self, PyObject *args)
+{
+    int elementId;
+    int property;
+    long to;
+    int durationMillis;
+    int easing = EASE_OUT_QUAD;
+    
+    if (!PyArg_ParseTuple(args, "iili|i", &elementId, &property, &to, &durationMillis, &easing)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_animate(elementId, property, to, durationMillis, easing) );
+}
+
+static PyObject *myui_cancel_animation(PyObject *self, PyObject *args)
+{
+    int animationId;
+    
+    if (!PyArg_ParseTuple(args, "i", &animationId)) {      
+        return NULL;
+    }
+    return PyInt_FromLong( mylib_cancel_animation(animationId) );
+}
+
 static PyMethodDef availableMethods[] = 
 {
     {"init",  myui_init, METH_VARARGS,"Initialize library."},
     {"close",  myui_close, METH_VARARGS,"Close library."},
     {"add_button",  myui_add_button, METH_VARARGS,"Add a ui button"},
     {"add_image_button",  myui_add_image_button, METH_VARARGS,"Add a ui image button"},
+    {"add_progressbar",  myui_add_progressbar, METH_VARARGS,"Add a progress bar, optionally with a seek callback(id, value)"},
+    {"progressbar_set_value",  myui_progressbar_set_value, METH_VARARGS,"Set the value of a progress bar without waiting for the rendering thread"},
+    {"progressbar_set_maximum",  myui_progressbar_set_maximum, METH_VARARGS,"Set the value at which a progress bar is full"},
+    {"add_container",  myui_add_container, METH_VARARGS,"Add a container, optionally with a background color (r,g,b)"},
+    {"begin_container",  myui_begin_container, METH_VARARGS,"Add all following elements to a container"},
+    {"end_container",  myui_end_container, METH_VARARGS,"Stop adding elements to the current container"},
+    {"add_page",  myui_add_page, METH_VARARGS,"Add a full-screen page, optionally with a background color (r,g,b); add elements to it with begin_container"},
+    {"push_page",  myui_push_page, METH_VARARGS,"Make a page the active page, optionally with a transition (PAGE_TRANSITION_xxx) and its duration (ms)"},
+    {"pop_page",  myui_pop_page, METH_VARARGS,"Return to the previous page, optionally with a transition (PAGE_TRANSITION_xxx) and its duration (ms)"},
+    {"show_page",  myui_show_page, METH_VARARGS,"Replace the active page, optionally with a transition (PAGE_TRANSITION_xxx) and its duration (ms)"},
+    {"get_active_page",  myui_get_active_page, METH_VARARGS,"Get the ID of the active page"},
+    {"set_z_order",  myui_set_z_order, METH_VARARGS,"Set z-order of an element, higher values are drawn on top"},
+    {"set_layout",  myui_set_layout, METH_VARARGS,"Lay out the children of a container as a row, column or grid (LAYOUT_xxx), optionally with padding, spacing and number of columns"},
+    {"set_layout_size",  myui_set_layout_size, METH_VARARGS,"Set the width and height (pixels, LAYOUT_WRAP_CONTENT or LAYOUT_FILL) and optionally the weight an element requests from its layout container"},
+    {"set_button_text",  myui_set_button_text, METH_VARARGS,"Replace the text of a button"},
+    {"animate",  myui_animate, METH_VARARGS,"Animate a property (ANIM_xxx) of an element to a value within a duration (ms), optionally with an easing function (EASE_xxx)"},
+    {"cancel_animation",  myui_cancel_animation, METH_VARARGS,"Stop an animation"},
+    {"invalidate",  myui_invalidate, METH_VARARGS,"Repaint an element at the end of the frame"},
+    {"set_log_level",  myui_set_log_level, METH_VARARGS,"Set log level (LOG_xxx) of a module (LOG_MODULE_xxx)"},
+    {"get_log_level",  myui_get_log_level, METH_VARARGS,"Get log level of a module (LOG_MODULE_xxx)"},
+    {"get_mailbox_stats",  myui_get_mailbox_stats, METH_VARARGS,"Get statistics about callbacks executed on the rendering thread"},
+    {"reset_mailbox_stats",  myui_reset_mailbox_stats, METH_VARARGS,"Discard mailbox statistics"},
+    {"set_slow_callback_threshold",  myui_set_slow_callback_threshold, METH_VARARGS,"Set execution time (microseconds) above which callbacks get logged as slow"},
+    {"get_memory_usage",  myui_get_memory_usage, METH_VARARGS,"Get current/peak memory usage in bytes per category"},
+    {"set_memory_budget",  myui_set_memory_budget, METH_VARARGS,"Set memory budget in bytes (0 = unlimited) of a category (MEM_xxx)"},
+    {"get_image_cache_stats",  myui_get_image_cache_stats, METH_VARARGS,"Get hits, misses, evictions, entries, bytes and atlas entries of the image cache"},
+    {"start_trace",  myui_start_trace, METH_VARARGS,"Start writing a Chrome trace event file"},
+    {"flush_trace",  myui_flush_trace, METH_VARARGS,"Write buffered trace events to the trace file"},
+    {"stop_trace",  myui_stop_trace, METH_VARARGS,"Write buffered trace events and close the trace file"},
+    {"set_display_backend",  myui_set_display_backend, METH_VARARGS,"Select display backend (DISPLAY_xxx), must be called before init()"},
+    {"load_screen",  myui_load_screen, METH_VARARGS,"Load a screen file, callbacks is a dict mapping the callback names used in the file to functions. Returns the screen ID or 0 on error"},
+    {"show_screen",  myui_show_screen, METH_VARARGS,"Replace the currently shown screen"},
+    {"find_screen_element",  myui_find_screen_element, METH_VARARGS,"Get the ID of a named element of a shown screen"},
+    {"free_screen",  myui_free_screen, METH_VARARGS,"Free a screen loaded with load_screen()"},
+    {"set_asset_bundle",  myui_set_asset_bundle, METH_VARARGS,"Take icons and glyphs from a bundle created by mkbundle, must be called before init()"},
+    {"set_render_workers",  myui_set_render_workers, METH_VARARGS,"Set the number of threads rendering list view items besides the rendering thread, -1 for one per additional CPU core"},
+    {"capture_frame",  myui_capture_frame, METH_VARARGS,"Capture the screen as (width, height, RGBA bytes)"},
     {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
@@ -178,5 +876,44 @@ PyMODINIT_FUNC inituilib(void)
 {
     PyObject *m = Py_InitModule("uilib", availableMethods);
     if (m != NULL) {
+      PyModule_AddIntConstant(m, "LOG_MODULE_RENDER", LOG_MODULE_RENDER);
+      PyModule_AddIntConstant(m, "LOG_MODULE_INPUT", LOG_MODULE_INPUT);
+      PyModule_AddIntConstant(m, "LOG_MODULE_UI", LOG_MODULE_UI);
+      PyModule_AddIntConstant(m, "LOG_MODULE_PYTHON", LOG_MODULE_PYTHON);
+      PyModule_AddIntConstant(m, "LOG_ERROR", ERROR);
+      PyModule_AddIntConstant(m, "LOG_WARN", WARN);
+      PyModule_AddIntConstant(m, "LOG_INFO", INFO);
+      PyModule_AddIntConstant(m, "LOG_DEBUG", DEBUG);
+      PyModule_AddIntConstant(m, "LOG_TRACE", TRACE);
+      PyModule_AddIntConstant(m, "MEM_IMAGES", MEM_CATEGORY_IMAGES);
+      PyModule_AddIntConstant(m, "MEM_LISTVIEW_SURFACES", MEM_CATEGORY_LISTVIEW_SURFACES);
+      PyModule_AddIntConstant(m, "MEM_TEXT", MEM_CATEGORY_TEXT);
+      PyModule_AddIntConstant(m, "MEM_FONTS", MEM_CATEGORY_FONTS);
+      PyModule_AddIntConstant(m, "MEM_LABEL_CACHE", MEM_CATEGORY_LABEL_CACHE);
+      PyModule_AddIntConstant(m, "MEM_POOLS", MEM_CATEGORY_POOLS);
+      PyModule_AddIntConstant(m, "MEM_PAGE_SURFACES", MEM_CATEGORY_PAGE_SURFACES);
+      PyModule_AddIntConstant(m, "DISPLAY_SDL", DISPLAY_BACKEND_SDL);
+      PyModule_AddIntConstant(m, "DISPLAY_MEMORY", DISPLAY_BACKEND_MEMORY);
+      PyModule_AddIntConstant(m, "ANIM_X", ANIM_PROPERTY_X);
+      PyModule_AddIntConstant(m, "ANIM_Y", ANIM_PROPERTY_Y);
+      PyModule_AddIntConstant(m, "ANIM_BACKGROUND_COLOR", ANIM_PROPERTY_BACKGROUND_COLOR);
+      PyModule_AddIntConstant(m, "ANIM_SCROLL_OFFSET", ANIM_PROPERTY_SCROLL_OFFSET);
+      PyModule_AddIntConstant(m, "LAYOUT_NONE", LAYOUT_NONE);
+      PyModule_AddIntConstant(m, "LAYOUT_ROW", LAYOUT_ROW);
+      PyModule_AddIntConstant(m, "LAYOUT_COLUMN", LAYOUT_COLUMN);
+      PyModule_AddIntConstant(m, "LAYOUT_GRID", LAYOUT_GRID);
+      PyModule_AddIntConstant(m, "LAYOUT_WRAP_CONTENT", LAYOUT_WRAP_CONTENT);
+      PyModule_AddIntConstant(m, "LAYOUT_FILL", LAYOUT_FILL);
+      PyModule_AddIntConstant(m, "PAGE_TRANSITION_NONE", PAGE_TRANSITION_NONE);
+      PyModule_AddIntConstant(m, "PAGE_TRANSITION_SLIDE_LEFT", PAGE_TRANSITION_SLIDE_LEFT);
+      PyModule_AddIntConstant(m, "PAGE_TRANSITION_SLIDE_RIGHT", PAGE_TRANSITION_SLIDE_RIGHT);
+      PyModule_AddIntConstant(m, "PAGE_TRANSITION_SLIDE_UP", PAGE_TRANSITION_SLIDE_UP);
+      PyModule_AddIntConstant(m, "PAGE_TRANSITION_SLIDE_DOWN", PAGE_TRANSITION_SLIDE_DOWN);
+      PyModule_AddIntConstant(m, "EASE_LINEAR", EASE_LINEAR);
+      PyModule_AddIntConstant(m, "EASE_IN_QUAD", EASE_IN_QUAD);
+      PyModule_AddIntConstant(m, "EASE_OUT_QUAD", EASE_OUT_QUAD);
+      PyModule_AddIntConstant(m, "EASE_IN_OUT_QUAD", EASE_IN_OUT_QUAD);
+      PyModule_AddIntConstant(m, "EASE_OUT_CUBIC", EASE_OUT_CUBIC);
+      PyModule_AddIntConstant(m, "EASE_IN_OUT_CUBIC", EASE_IN_OUT_CUBIC);
     }
 }
@@ -0,0 +1,491 @@
+#include "mylib.h"
+#include "render.h"
+#include "ui.h"
+#include "global.h"
+#include "raster.h"
+#include "blend.h"
+#include "rowpool.h"
+#include "SDL/SDL_gfxPrimitives.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Headless benchmarks.
+ *
+ * Renders into the in-memory display backend, so no video subsystem is needed.
+ * Pass --csv to get CSV instead of JSON output.
+ */
+
+#define BUTTON_REDRAWS 2000
+#define SCROLL_FRAMES 500
+#define TEXT_DRAWS 2000
+#define ROUND_TRIPS 200
+#define HIT_TEST_BUTTONS 64
+#define HIT_TESTS 1000000
+#define BOX_DRAWS 20000
+#define ICON_BLITS 100000
+#define ICON_SIZE 32
+#define ICON_LOAD_TIMEOUT_MICROS 5000000
+
+static int csvOutput = 0;
+static int resultCount = 0;
+static int failureCount = 0;
+
+static int scrollItemCount = 0;
+static ui_element *benchElement = NULL;
+
+static long nowMicros(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+static void reportResult(const char *name,const char *param,double value,const char *unit)
+{
+  if ( csvOutput ) {
+    if ( resultCount == 0 ) {
+      printf("name,param,value,unit\n");
+    }
+    printf("%s,%s,%.3f,%s\n",name,param,value,unit);
+  } else {
+    printf("%s\n  {\"name\": \"%s\", \"param\": \"%s\", \"value\": %.3f, \"unit\": \"%s\"}",resultCount == 0 ? "[" : ",",name,param,value,unit);
+  }
+  resultCount++;
+}
+
+static void finishReport(void)
+{
+  if ( ! csvOutput ) {
+    printf("%s\n]\n", resultCount == 0 ? "[" : "");
+  }
+}
+
+static void buttonHandler(int buttonId) {
+}
+
+static char *scrollLabel(int listViewId,int itemId)
+{
+  static char buffer[32];
+  snprintf(buffer,sizeof(buffer),"item #%d",itemId);
+  return buffer;
+}
+
+static int scrollItemCountProvider(int listViewId) {
+  return scrollItemCount;
+}
+
+static void scrollItemClicked(int listViewId,int itemId) {
+}
+
+static int compareLong(const void *a,const void *b)
+{
+  long la = *((long*) a);
+  long lb = *((long*) b);
+  return la < lb ? -1 : ( la > lb ? 1 : 0 );
+}
+
+// ============ button redraw ============
+
+static void *benchButtonRedrawInternal(void *data)
+{
+  long start = nowMicros();
+  for ( int i = 0 ; i < BUTTON_REDRAWS ; i++ )
+  {
+    render_draw(benchElement);
+    if ( (i % 16) == 15 ) {
+      render_present_frame();
+    }
+  }
+  long elapsed = nowMicros() - start;
+  reportResult("button_redraw","",BUTTON_REDRAWS * 1000000.0 / elapsed,"redraws/s");
+  return NULL;
+}
+
+static void benchButtonRedraw(void)
+{
+  int buttonId = mylib_add_button("Benchmark",10,10,150,30,buttonHandler);
+  benchElement = ui_find_element_by_id(buttonId);
+  if ( benchElement ) {
+    render_exec_on_thread(benchButtonRedrawInternal,NULL,1);
+  }
+}
+
+// ============ listview scrolling ============
+
+typedef struct scroll_bench {
+  const char *name;
+  char param[32];
+} scroll_bench;
+
+static void *benchListviewScrollInternal(void *data)
+{
+  scroll_bench *bench = data;
+  listview_entry *listview = benchElement->listview;
+
+  int maxOffset = (scrollItemCount - listview->visibleItemCount) * LISTVIEW_ITEM_HEIGHT;
+  int step = max( maxOffset / SCROLL_FRAMES, 1 );
+
+  long start = nowMicros();
+  for ( int i = 0 ; i < SCROLL_FRAMES ; i++ )
+  {
+    listview->yStartOffset = (i * step) % (maxOffset+1);
+    render_draw(benchElement);
+    render_present_frame();
+  }
+  long elapsed = nowMicros() - start;
+
+  reportResult(bench->name,bench->param,SCROLL_FRAMES * 1000000.0 / elapsed,"frames/s");
+  return NULL;
+}
+
+static void benchScrollListview(SDL_Rect *bounds,int itemCount,scroll_bench *bench)
+{
+  scrollItemCount = itemCount;
+  int listViewId = mylib_add_listview(bounds, scrollLabel, scrollItemCountProvider, scrollItemClicked);
+  benchElement = ui_find_element_by_id(listViewId);
+  if ( benchElement ) {
+    render_exec_on_thread(benchListviewScrollInternal,bench,1);
+  }
+}
+
+static void benchListviewScroll(int itemCount)
+{
+  SDL_Rect bounds = {10,50,150,100};
+  scroll_bench bench = { "listview_scroll" };
+  snprintf(bench.param,sizeof(bench.param),"items=%d",itemCount);
+  benchScrollListview(&bounds,itemCount,&bench);
+}
+
+// ============ listview row workers ============
+
+static void benchListviewRows(void)
+{
+  // full screen, so there are enough rows to split among the threads
+  SDL_Rect bounds = {0,0,320,240};
+  for ( int threads = 1 ; threads <= ROWPOOL_MAX_WORKERS+1 ; threads++ )
+  {
+    if ( ! mylib_set_render_workers(threads-1) ) {
+      continue;
+    }
+    scroll_bench bench = { "listview_rows" };
+    snprintf(bench.param,sizeof(bench.param),"threads=%d",threads);
+    benchScrollListview(&bounds,100000,&bench);
+  }
+  mylib_set_render_workers(-1);
+}
+
+// ============ text rasterization ============
+
+static void *benchTextInternal(void *data)
+{
+  SDL_Color color = {255,255,255};
+
+  long start = nowMicros();
+  for ( int i = 0 ; i < TEXT_DRAWS ; i++ )
+  {
+    render_render_text("The quick brown fox",10,200,color);
+    if ( (i % 16) == 15 ) {
+      render_present_frame();
+    }
+  }
+  long elapsed = nowMicros() - start;
+  reportResult("text_rasterization","",TEXT_DRAWS * 1000000.0 / elapsed,"texts/s");
+  return NULL;
+}
+
+static void benchText(void)
+{
+  render_exec_on_thread(benchTextInternal,NULL,1);
+}
+
+// ============ render_exec_on_thread() round trip ============
+
+static void *noop(void *data) {
+  return data;
+}
+
+static void benchRoundTrip(void)
+{
+  long samples[ROUND_TRIPS];
+  long total = 0;
+
+  for ( int i = 0 ; i < ROUND_TRIPS ; i++ )
+  {
+    long start = nowMicros();
+    render_exec_on_thread(noop,NULL,1);
+    samples[i] = nowMicros() - start;
+    total += samples[i];
+  }
+  qsort(samples,ROUND_TRIPS,sizeof(long),compareLong);
+
+  reportResult("exec_on_thread_roundtrip","mean",total / (double) ROUND_TRIPS,"us");
+  reportResult("exec_on_thread_roundtrip","p50",samples[ROUND_TRIPS/2],"us");
+  reportResult("exec_on_thread_roundtrip","p99",samples[(ROUND_TRIPS*99)/100],"us");
+}
+
+// ============ hit testing ============
+
+static void benchHitTest(void)
+{
+  // only the buttons below must be searched, not the elements of earlier benchmarks
+  ui_free_all();
+  for ( int i = 0 ; i < HIT_TEST_BUTTONS ; i++ ) {
+    mylib_add_button("x",(i % 8) * 40,(i / 8) * 30,38,28,buttonHandler);
+  }
+
+  // random points are generated up front, so rand() is not timed
+  Sint16 *points = malloc(HIT_TESTS * 2 * sizeof(Sint16));
+  if ( points == NULL ) {
+    return;
+  }
+  srand(42);
+  for ( int i = 0 ; i < HIT_TESTS ; i++ )
+  {
+    points[2*i] = rand() % 320;
+    points[2*i+1] = rand() % 240;
+  }
+
+  int hits = 0;
+  long start = nowMicros();
+  for ( int i = 0 ; i < HIT_TESTS ; i++ )
+  {
+    if ( ui_find_element( points[2*i], points[2*i+1] ) ) {
+      hits++;
+    }
+  }
+  long elapsed = nowMicros() - start;
+  free(points);
+
+  char param[32];
+  snprintf(param,sizeof(param),"elements=%d",HIT_TEST_BUTTONS);
+  reportResult("hit_test",param,elapsed * 1000.0 / HIT_TESTS,"ns/call");
+}
+
+// ============ rounded boxes: raster.h vs. SDL_gfx ============
+
+static void benchRoundedBox(SDL_Surface *surface,int radius,int useGfx)
+{
+  SDL_Color fill = {40,80,160};
+  SDL_Color border = {255,255,255};
+  Uint32 fillPixel = SDL_MapRGB(surface->format,fill.r,fill.g,fill.b);
+  Uint32 borderPixel = SDL_MapRGB(surface->format,border.r,border.g,border.b);
+
+  long start = nowMicros();
+  for ( int i = 0 ; i < BOX_DRAWS ; i++ )
+  {
+    // a button sized box, moving so that some of them get clipped
+    Sint16 x1 = (i * 7) % 240 - 20;
+    Sint16 y1 = (i * 13) % 220;
+    Sint16 x2 = x1 + 100;
+    Sint16 y2 = y1 + 30;
+    if ( useGfx ) 
+    {
+      roundedBoxRGBA(surface,x1,y1,x2,y2,radius,fill.r,fill.g,fill.b,255);
+      roundedRectangleRGBA(surface,x1,y1,x2,y2,radius,border.r,border.g,border.b,255);
+    } 
+    else 
+    {
+      raster_fill_rounded_box(surface,x1,y1,x2,y2,radius,fillPixel);
+      raster_draw_rounded_rect(surface,x1,y1,x2,y2,radius,borderPixel);
+    }
+  }
+  long elapsed = nowMicros() - start;
+
+  char param[32];
+  snprintf(param,sizeof(param),"%s,radius=%d",useGfx ? "sdl_gfx" : "raster",radius);
+  reportResult("rounded_box_16bpp",param,BOX_DRAWS * 1000000.0 / elapsed,"boxes/s");
+}
+
+static void benchRoundedBoxes(void)
+{
+  SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE,320,240,16,0xf800,0x07e0,0x001f,0);
+  if ( surface == NULL ) {
+    fprintf(stderr,"Failed to create surface\n");
+    return;
+  }
+  int radii[] = { 3, 12 };
+  for ( int i = 0 ; i < 2 ; i++ )
+  {
+    benchRoundedBox(surface,radii[i],1);
+    benchRoundedBox(surface,radii[i],0);
+  }
+  SDL_FreeSurface(surface);
+}
+
+// ============ icon blits: opaque RGB565 vs. translucent ARGB ============
+
+static void benchIconBlit(SDL_Surface *screen,SDL_Surface *icon,const char *param)
+{
+  long start = nowMicros();
+  for ( int i = 0 ; i < ICON_BLITS ; i++ )
+  {
+    SDL_Rect dstRect = { (i * 7) % 300 - 10, (i * 13) % 220 - 10, 0, 0 };
+    blend_blit(icon,NULL,screen,&dstRect);
+  }
+  long elapsed = nowMicros() - start;
+  reportResult("icon_blit_16bpp",param,ICON_BLITS * 1000000.0 / elapsed,"blits/s");
+}
+
+static void benchIconBlits(void)
+{
+  SDL_Surface *screen = SDL_CreateRGBSurface(SDL_SWSURFACE,320,240,16,0xf800,0x07e0,0x001f,0);
+  SDL_Surface *opaque = SDL_CreateRGBSurface(SDL_SWSURFACE,ICON_SIZE,ICON_SIZE,16,0xf800,0x07e0,0x001f,0);
+  SDL_Surface *translucent = SDL_CreateRGBSurface(SDL_SWSURFACE,ICON_SIZE,ICON_SIZE,32,BLEND_RMASK,BLEND_GMASK,BLEND_BMASK,BLEND_AMASK);
+  if ( screen == NULL || opaque == NULL || translucent == NULL ) 
+  {
+    fprintf(stderr,"Failed to create surface\n");
+    SDL_FreeSurface(translucent);
+    SDL_FreeSurface(opaque);
+    SDL_FreeSurface(screen);
+    return;
+  }
+  SDL_FillRect(opaque,NULL,SDL_MapRGB(opaque->format,200,40,40));
+
+  // a disc with an anti-aliased edge, transparent in the corners
+  for ( int y = 0 ; y < ICON_SIZE ; y++ )
+  {
+    Uint32 *row = (Uint32*) ( (Uint8*) translucent->pixels + y * translucent->pitch );
+    for ( int x = 0 ; x < ICON_SIZE ; x++ )
+    {
+      int dx = 2 * x + 1 - ICON_SIZE;
+      int dy = 2 * y + 1 - ICON_SIZE;
+      int distance = ICON_SIZE * ICON_SIZE - dx * dx - dy * dy;
+      Uint32 alpha = distance <= 0 ? 0 : min(distance * 4,255);
+      row[x] = ( alpha << 24 ) | 0xc82828;
+    }
+  }
+  blend_premultiply(translucent);
+
+  benchIconBlit(screen,opaque,"opaque");
+  benchIconBlit(screen,translucent,"translucent");
+
+  SDL_FreeSurface(translucent);
+  SDL_FreeSurface(opaque);
+  SDL_FreeSurface(screen);
+}
+
+// ============ texture atlas: opaque icons after a translucent one ============
+
+/**
+ * Writes the disc of benchIconBlits() as an uncompressed true-color TGA image,
+ * with an anti-aliased alpha edge if translucent is set.
+ * @return 0 on error, otherwise success
+ */
+static int writeIcon(const char *path,int translucent)
+{
+  FILE *file = fopen(path,"wb");
+  if ( file == NULL ) {
+    return 0;
+  }
+  Uint8 header[18] = {0};
+  header[2] = 2; // uncompressed true-color
+  header[12] = ICON_SIZE;
+  header[14] = ICON_SIZE;
+  header[16] = translucent ? 32 : 24;
+  header[17] = translucent ? 0x28 : 0x20; // top-left origin, alpha bits
+  fwrite(header,1,sizeof(header),file);
+  for ( int y = 0 ; y < ICON_SIZE ; y++ )
+  {
+    for ( int x = 0 ; x < ICON_SIZE ; x++ )
+    {
+      int dx = 2 * x + 1 - ICON_SIZE;
+      int dy = 2 * y + 1 - ICON_SIZE;
+      int distance = ICON_SIZE * ICON_SIZE - dx * dx - dy * dy;
+      Uint8 pixel[4] = { 0x28, 0x28, 0xc8, distance <= 0 ? 0 : min(distance * 4,255) };
+      fwrite(pixel,1,translucent ? 4 : 3,file);
+    }
+  }
+  return fclose(file) == 0;
+}
+
+/**
+ * Adds an image button and waits until the image cache has loaded its image.
+ * @return 0 on error, otherwise success
+ */
+static int addIconButton(char *path,int x)
+{
+  image_cache_stats stats;
+  mylib_get_image_cache_stats(&stats);
+  long bytesBefore = stats.bytes;
+  if ( ! mylib_add_image_button(path,x,10,ICON_SIZE,ICON_SIZE,buttonHandler) ) {
+    return 0;
+  }
+  long start = nowMicros();
+  while ( stats.bytes == bytesBefore && nowMicros() - start < ICON_LOAD_TIMEOUT_MICROS )
+  {
+    usleep(1000);
+    mylib_get_image_cache_stats(&stats);
+  }
+  return stats.bytes != bytesBefore;
+}
+
+static void benchAtlasAfterTranslucent(void)
+{
+  char translucentPath[64];
+  char opaquePath[64];
+  snprintf(translucentPath,sizeof(translucentPath),"/tmp/bench-%d-translucent.tga",(int) getpid());
+  snprintf(opaquePath,sizeof(opaquePath),"/tmp/bench-%d-opaque.tga",(int) getpid());
+  
+  image_cache_stats stats;
+  // the translucent icon comes first, so it would have determined the atlas format
+  if ( ! writeIcon(translucentPath,1) || ! writeIcon(opaquePath,0) 
+       || ! addIconButton(translucentPath,10) || ! addIconButton(opaquePath,60) ) 
+  {
+    fprintf(stderr,"FAILED: Could not load icons\n");
+    failureCount++;
+  } 
+  else
+  {
+    mylib_get_image_cache_stats(&stats);
+    reportResult("atlas_entries","translucent_first",stats.atlasEntryCount,"images");
+    if ( stats.atlasEntryCount != 1 ) {
+      fprintf(stderr,"FAILED: Expected the opaque icon in the atlas, got %d atlas entries\n",stats.atlasEntryCount);
+      failureCount++;
+    }
+  }
+  unlink(translucentPath);
+  unlink(opaquePath);
+}
+
+int main(int argc, char* args[])
+{
+  for ( int i = 1 ; i < argc ; i++ ) {
+    if ( strcmp(args[i],"--csv") == 0 ) {
+      csvOutput = 1;
+    }
+  }
+
+  // no display required
+  mylib_set_display_backend(DISPLAY_BACKEND_MEMORY);
+
+  // log output goes to stdout as well
+  mylib_set_log_level(LOG_MODULE_RENDER,ERROR);
+  mylib_set_log_level(LOG_MODULE_INPUT,ERROR);
+  mylib_set_log_level(LOG_MODULE_UI,ERROR);
+
+  if ( ! mylib_init() ) {
+    fprintf(stderr,"Failed to initialize library\n");
+    return 1;
+  }
+
+  benchButtonRedraw();
+  benchListviewScroll(10);
+  benchListviewScroll(1000);
+  benchListviewScroll(100000);
+  benchListviewRows();
+  benchText();
+  benchRoundTrip();
+  benchHitTest();
+  benchRoundedBoxes();
+  benchIconBlits();
+  benchAtlasAfterTranslucent();
+
+  finishReport();
+
+  mylib_close();
+  return failureCount == 0 ? 0 : 1;
+}
@@ -1,7 +1,38 @@
 #include "mylib.h"
+#include "input.h"
+#include "render.h"
+#include "bundle.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/time.h>
+
+/*
+ * Counts every heap allocation of the process, including the ones of SDL, SDL_ttf and libc.
+ * The library is a shared object, so its allocations can't be caught by linking 
+ * with -Wl,--wrap=malloc; defining malloc() in the executable interposes it for all of them.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count,size_t size);
+extern void *__libc_realloc(void *ptr,size_t size);
+
+static volatile unsigned long realAllocations = 0;
+
+void *malloc(size_t size) {
+  __sync_fetch_and_add(&realAllocations,1);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count,size_t size) {
+  __sync_fetch_and_add(&realAllocations,1);
+  return __libc_calloc(count,size);
+}
+
+void *realloc(void *ptr,size_t size) {
+  __sync_fetch_and_add(&realAllocations,1);
+  return __libc_realloc(ptr,size);
+}
 
 void buttonHandler(int buttonId) {
   printf("Button clicked >> %d <<\n",buttonId);
@@ -42,21 +73,108 @@ void itemClicked(int listViewId,int itemId) {
   printf("Item %d clicked\n",itemId);
 }
 
+/*
+ * Simulates dragging a finger across a listview from top to bottom and back.
+ * Runs on the rendering thread, which owns the listview state the touch handler reads.
+ */
+void *dragScroll(void *data) 
+{
+  SDL_Rect *bounds = data;
+  TouchEvent event = {0};
+  event.x = bounds->x + bounds->w/2;
+  event.pressure = 255;
+  
+  int top = bounds->y+1;
+  int bottom = bounds->y + 4*LISTVIEW_ITEM_HEIGHT;
+  
+  event.y = top;
+  event.type = TOUCH_START;
+  gettimeofday(&event.tv,NULL);  
+  input_invoke_input_handler(&event);
+  
+  event.type = TOUCH_CONTINUE;
+  for ( int y = top ; y <= bottom ; y+=4 ) 
+  {
+    event.y = y;
+    gettimeofday(&event.tv,NULL);
+    input_invoke_input_handler(&event);
+  }
+  for ( int y = bottom ; y >= top ; y-=4 ) 
+  {
+    event.y = y;
+    gettimeofday(&event.tv,NULL);
+    input_invoke_input_handler(&event);
+  }
+  
+  event.type = TOUCH_STOP;
+  event.pressure = 0;
+  gettimeofday(&event.tv,NULL);  
+  input_invoke_input_handler(&event);  
+  return NULL;
+}
+
+/*
+ * Checks whether the asset bundle that was actually opened holds the glyphs of the UI font.
+ * Runs on the rendering thread, which owns the bundle.
+ */
+void *hasBundleGlyphs(void *data) {
+  return (void*) (intptr_t) bundle_has_font(FONT_PATH,FONT_SIZE);
+}
+
+/*
+ * Checks that scrolling a listview whose rows have all been seen before
+ * does not allocate from the heap. Without an asset bundle SDL_ttf rasterizes
+ * every row into a new surface, so only the library's own allocations 
+ * must be zero then; with glyphs from a bundle no allocation at all is allowed.
+ */
+int testScrollDoesNotAllocate(SDL_Rect *bounds,int glyphsFromBundle) 
+{
+  // first pass warms up label cache, pools and frame arena
+  render_exec_on_thread(dragScroll,bounds,1);
+  
+  unsigned long before = mylib_get_heap_allocation_count();
+  unsigned long realBefore = __sync_fetch_and_add(&realAllocations,0);
+  render_exec_on_thread(dragScroll,bounds,1);
+  unsigned long realAfter = __sync_fetch_and_add(&realAllocations,0);
+  unsigned long after = mylib_get_heap_allocation_count();
+  
+  if ( after != before ) {
+    fprintf(stderr,"FAILED: Scrolling listview performed %lu heap allocations in the library\n",after-before);
+    return 0;
+  }
+  if ( glyphsFromBundle && realAfter != realBefore ) {
+    fprintf(stderr,"FAILED: Scrolling listview performed %lu heap allocations\n",realAfter-realBefore);
+    return 0;
+  }
+  printf("OK: Scrolling listview performed no heap allocations in the library, %lu in total\n",realAfter-realBefore);
+  return 1;
+}
+
 int main(int argc, char* args[])
 {
+  // asset bundle (see tools/mkbundle) holding the glyphs of the UI font, ctest passes one
+  if ( argc > 1 ) {
+    mylib_set_asset_bundle(args[1]);
+  }
   if ( mylib_init() ) 
   {
+    int glyphsFromBundle = (int) (intptr_t) render_exec_on_thread(hasBundleGlyphs,NULL,1);
+    if ( ! glyphsFromBundle ) {
+      printf("No glyphs of %s at size %d in an asset bundle, only the library's allocations are checked\n",FONT_PATH,FONT_SIZE);
+    }
     // int elementId = mylib_add_image_button("/home/tobi/qtcreator/raspi/raspi/test.png",50,50,150,20,buttonHandler);    
 //     int elementId = mylib_add_button("test",50,50,150,20,buttonHandler);
 //     printf("Registered button %d\n",elementId);
     
     SDL_Rect bounds = {10,10,150,150};
     int elementId = mylib_add_listview(&bounds, getLabel, getItemCount, itemClicked);
-    if ( elementId > 0 ) {
+    int success = elementId > 0;
+    if ( success ) {
+      success = testScrollDoesNotAllocate(&bounds,glyphsFromBundle);
       sleep(10);
     }
     mylib_close();
-    return 0;
+    return success ? 0 : 1;
   } 
   fprintf(stderr,"Failed to initialize library\n");
   return 1;
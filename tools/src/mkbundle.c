@@ -0,0 +1,205 @@
+#include "bundle.h"
+#include "imageloader.h"
+#include "blend.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#include "SDL/SDL_image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Creates an asset bundle (see library/src/bundle.h).
+ *
+ * mkbundle <output file> <font file> <font size> [<image file> <max. width> <max. height>]...
+ *
+ * Images get scaled the same way the image loader scales them for an image button
+ * of the given size. Translucent images are stored as premultiplied ARGB8888 so they
+ * get blended like loaded ones, all others as RGB565. Font and image paths must be given exactly like the library
+ * uses them, they are the keys the bundle is searched by.
+ */
+
+typedef struct bundle_buffer
+{
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+} bundle_buffer;
+
+/**
+ * Appends zeroed space to the buffer, starting at a 4 byte boundary.
+ * @return offset of the space
+ */
+static size_t reserve(bundle_buffer *buffer,size_t size)
+{
+  size_t offset = (buffer->size + 3) & ~((size_t) 3);
+  if ( offset + size > buffer->capacity )
+  {
+    size_t capacity = buffer->capacity ? buffer->capacity : 65536;
+    while ( offset + size > capacity ) {
+      capacity *= 2;
+    }
+    unsigned char *data = realloc(buffer->data,capacity);
+    if ( data == NULL ) {
+      fprintf(stderr,"Out of memory\n");
+      exit(1);
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+  }
+  memset(buffer->data + buffer->size,0,offset + size - buffer->size);
+  buffer->size = offset + size;
+  return offset;
+}
+
+static int add_glyphs(bundle_buffer *buffer,const char *fontPath,int fontSize)
+{
+  TTF_Font *font = TTF_OpenFont(fontPath,fontSize);
+  if ( font == NULL ) {
+    fprintf(stderr,"Failed to load font %s: %s\n",fontPath,TTF_GetError());
+    return 0;
+  }
+  int fontHeight = TTF_FontHeight(font);
+  ((bundle_header*) buffer->data)->fontHeight = fontHeight;
+
+  SDL_Color white = {255,255,255};
+  for ( int c = BUNDLE_FIRST_GLYPH ; c <= BUNDLE_LAST_GLYPH ; c++ )
+  {
+    // rendered like the library renders text so glyphs look the same as without bundle
+    char text[2] = { (char) c, 0 };
+    SDL_Surface *glyphSurface = TTF_RenderText_Solid(font,text,white);
+    if ( glyphSurface == NULL ) {
+      fprintf(stderr,"Failed to render glyph %d: %s\n",c,TTF_GetError());
+      continue;
+    }
+    size_t offset = reserve(buffer,(size_t) glyphSurface->w * fontHeight);
+    bundle_glyph *glyph = (bundle_glyph*) (buffer->data + ((bundle_header*) buffer->data)->glyphOffset) + (c - BUNDLE_FIRST_GLYPH);
+    glyph->width = glyphSurface->w;
+    glyph->offset = offset;
+
+    // palette index 0 is the transparent background
+    SDL_LockSurface(glyphSurface);
+    for ( int y = 0 ; y < glyphSurface->h && y < fontHeight ; y++ )
+    {
+      Uint8 *src = (Uint8*) glyphSurface->pixels + y * glyphSurface->pitch;
+      for ( int x = 0 ; x < glyphSurface->w ; x++ ) {
+        buffer->data[offset + y * glyphSurface->w + x] = src[x] != 0;
+      }
+    }
+    SDL_UnlockSurface(glyphSurface);
+    SDL_FreeSurface(glyphSurface);
+  }
+  TTF_CloseFont(font);
+  return 1;
+}
+
+static int add_icon(bundle_buffer *buffer,int index,const char *path,int maxWidth,int maxHeight,SDL_PixelFormat *format)
+{
+  if ( strlen(path) >= BUNDLE_PATH_LENGTH ) {
+    fprintf(stderr,"Path too long: %s\n",path);
+    return 0;
+  }
+  SDL_Surface *image = IMG_Load(path);
+  if ( image == NULL ) {
+    fprintf(stderr,"Failed to load %s: %s\n",path,IMG_GetError());
+    return 0;
+  }
+  SDL_Surface *scaled = imageloader_scale(image,maxWidth,maxHeight);
+  SDL_FreeSurface(image);
+  // converting translucent images to RGB565 would turn their transparent edges into boxes
+  int translucent = scaled && blend_is_translucent(scaled);
+  SDL_Surface *converted = scaled;
+  if ( scaled && ! translucent ) {
+    converted = SDL_ConvertSurface(scaled,format,SDL_SWSURFACE);
+    SDL_FreeSurface(scaled);
+  }
+  if ( converted == NULL ) {
+    fprintf(stderr,"Failed to convert %s: %s\n",path,SDL_GetError());
+    return 0;
+  }
+
+  int bytesPerPixel = translucent ? 4 : 2;
+  size_t offset = reserve(buffer,(size_t) converted->w * converted->h * bytesPerPixel);
+  bundle_icon *icon = (bundle_icon*) (buffer->data + ((bundle_header*) buffer->data)->iconOffset) + index;
+  strcpy(icon->path,path);
+  icon->maxWidth = maxWidth;
+  icon->maxHeight = maxHeight;
+  icon->width = converted->w;
+  icon->height = converted->h;
+  icon->format = translucent ? BUNDLE_ICON_ARGB8888 : BUNDLE_ICON_RGB565;
+  icon->offset = offset;
+
+  SDL_LockSurface(converted);
+  for ( int y = 0 ; y < converted->h ; y++ ) {
+    memcpy(buffer->data + offset + y * converted->w * bytesPerPixel,(Uint8*) converted->pixels + y * converted->pitch,converted->w * bytesPerPixel);
+  }
+  SDL_UnlockSurface(converted);
+  printf("%s: %dx%d%s\n",path,converted->w,converted->h,translucent ? " (translucent)" : "");
+  SDL_FreeSurface(converted);
+  return 1;
+}
+
+int main(int argc,char **argv)
+{
+  if ( argc < 4 || (argc - 4) % 3 != 0 ) {
+    fprintf(stderr,"Usage: %s <output file> <font file> <font size> [<image file> <max. width> <max. height>]...\n",argv[0]);
+    return 1;
+  }
+  const char *outputPath = argv[1];
+  const char *fontPath = argv[2];
+  int fontSize = atoi(argv[3]);
+  int iconCount = (argc - 4) / 3;
+  if ( strlen(fontPath) >= BUNDLE_PATH_LENGTH ) {
+    fprintf(stderr,"Path too long: %s\n",fontPath);
+    return 1;
+  }
+
+  if ( SDL_Init(0) < 0 || TTF_Init() < 0 ) {
+    fprintf(stderr,"Failed to initialize SDL: %s\n",SDL_GetError());
+    return 1;
+  }
+  // the pixel format the display runs in
+  SDL_Surface *rgb565 = SDL_CreateRGBSurface(SDL_SWSURFACE,1,1,16,0xf800,0x07e0,0x001f,0);
+  if ( rgb565 == NULL ) {
+    fprintf(stderr,"Failed to create surface: %s\n",SDL_GetError());
+    return 1;
+  }
+
+  // tables go first, the data they point to gets appended behind them
+  bundle_buffer buffer = {0};
+  reserve(&buffer,sizeof(bundle_header));
+  size_t glyphOffset = reserve(&buffer,BUNDLE_GLYPH_COUNT * sizeof(bundle_glyph));
+  size_t iconOffset = reserve(&buffer,iconCount * sizeof(bundle_icon));
+  bundle_header *header = (bundle_header*) buffer.data;
+  header->magic = BUNDLE_MAGIC;
+  header->version = BUNDLE_VERSION;
+  strcpy(header->fontPath,fontPath);
+  header->fontSize = fontSize;
+  header->glyphOffset = glyphOffset;
+  header->iconCount = iconCount;
+  header->iconOffset = iconOffset;
+
+  int result = add_glyphs(&buffer,fontPath,fontSize);
+  for ( int i = 0 ; i < iconCount && result ; i++ ) {
+    result = add_icon(&buffer,i,argv[4+i*3],atoi(argv[5+i*3]),atoi(argv[6+i*3]),rgb565->format);
+  }
+
+  if ( result )
+  {
+    FILE *file = fopen(outputPath,"wb");
+    if ( file == NULL || fwrite(buffer.data,1,buffer.size,file) != buffer.size ) {
+      fprintf(stderr,"Failed to write %s\n",outputPath);
+      result = 0;
+    } else {
+      printf("Wrote %s (%ld bytes, %d icons)\n",outputPath,(long) buffer.size,iconCount);
+    }
+    if ( file && fclose(file) != 0 ) {
+      result = 0;
+    }
+  }
+  free(buffer.data);
+  SDL_FreeSurface(rgb565);
+  TTF_Quit();
+  SDL_Quit();
+  return result ? 0 : 1;
+}